@@ -1,22 +1,45 @@
 #include "animation_puppet.h"
+#include "bone_mapping.h"
 
+#include <plugins/dcc_asset/dcc_asset_truth.h>
+#include <plugins/editor_views/asset_browser.h>
 #include <plugins/entity/entity.h>
 #include <plugins/entity/scene_tree_component.h>
 #include <plugins/the_machinery_shared/component_interfaces/editor_ui_interface.h>
 #include <plugins/entity/tag_component.h>
+#include <plugins/entity/transform_component.h>
 
 #include <foundation/api_registry.h>
 #include <foundation/carray.inl>
 #include <foundation/feature_flags.h>
+#include <foundation/hash.inl>
+#include <foundation/job_system.h>
 #include <foundation/localizer.h>
 #include <foundation/math.inl>
+#include <foundation/murmurhash64a.inl>
 #include <foundation/the_truth.h>
 #include <foundation/the_truth_types.h>
 #include <foundation/log.h>
+#include <foundation/temp_allocator.h>
 
-// Tha bone count that puppet is interested in
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define PUPPET_SSE 1
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Bone count of the built-in Mixamo mapping, used by puppets without a bone mapping asset.
 #define BONE_COUNT 65
 
+// Number of puppets updated by each job. The engine runs on a single thread if there are no more
+// puppets than this.
+#define PUPPETS_PER_JOB 32
+
 // default bone mappings
 #include "mapping/bones-1.h"
 #include "mapping/bones-2.h"
@@ -31,21 +54,289 @@ struct tm_scene_tree_component_api *tm_scene_tree_component_api;
 struct tm_tag_component_api *tm_tag_component_api;
 struct tm_tag_component_manager_o *tm_tag_component_manager;
 struct tm_link_component_api *tm_link_component_api;
+struct tm_job_system_api *tm_job_system_api;
 
 #define NODE_NOT_FOUND UINT32_MAX
+#define ROOT_NOT_FOUND UINT32_MAX
 #define ANIMATION_ROOT_TAG_HASH TM_STATIC_HASH("tm_ig_animation_puppet_root",   0xc88a0edba8d16200ULL)
+#define LOD_REFERENCE_TAG_HASH TM_STATIC_HASH("tm_ig_animation_puppet_lod_reference", 0x36adb21c8bfad809ULL)
+
+// Lowest update tier, where puppets copy the root pose every 16 frames.
+#define MAX_UPDATE_TIER 4
+
+// Frames between two attempts to resolve a root asset that couldn't be resolved, unless the asset
+// changes in the Truth. Catches roots spawned after the puppet without a lookup every frame.
+#define ROOT_RETRY_FRAMES 64
+
+// Bones whose transform differs from the last one written by no more than this (per component) are
+// not written again.
+#define CHANGE_TOLERANCE 1e-5f
+
+// Returns the index of the lowest set bit of `x`, which must not be zero.
+static inline uint32_t lowest_bit(uint64_t x)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, x);
+    return (uint32_t)index;
+#else
+    return (uint32_t)__builtin_ctzll(x);
+#endif
+}
+
+// Rounds a bone count up to a multiple of four, so that poses can be processed four bones at a time.
+static inline uint32_t padded_bone_count(uint32_t num_bones)
+{
+    return (num_bones + 3) & ~3u;
+}
+
+// A bone mapping compiled from the Truth, shared by all the puppets that use it.
+typedef struct puppet_mapping_t
+{
+    // Bone mapping asset, 0 for the built-in mapping.
+    tm_tt_id_t asset;
+
+    // Version of `asset` the mapping was compiled from.
+    uint64_t version;
+
+    // Incremented each time the mapping is recompiled.
+    uint32_t generation;
+    uint32_t reserved;
+
+    bone_mapping_t bones;
+} puppet_mapping_t;
+
+// Local rotations of the nodes of a DCC asset as stored in the Truth, the bind pose of the scene
+// trees created from the asset. Shared by all the remaps of scene trees of the asset.
+typedef struct puppet_bind_pose_t
+{
+    tm_tt_id_t asset;
+
+    // Version of `asset` the bind pose was read from.
+    uint64_t version;
+
+    uint32_t num_nodes;
+    uint32_t reserved;
+
+    // Name hash and local rotation of each node of the asset.
+    uint64_t *names;
+    tm_vec4_t *rot;
+} puppet_bind_pose_t;
+
+typedef struct TM_HASH_T(uint64_t, puppet_bind_pose_t *) bind_pose_map_t;
+
+// Scene tree node indices of the mapped bones. Resolving the bone names is a hash lookup per bone,
+// so this is only done when the scene tree or the bone mapping changes.
+typedef struct bone_remap_t
+{
+    // Scene tree the node indices were resolved in, NULL if not resolved yet.
+    const tm_scene_tree_component_t *stc;
+
+    // Bone mapping the node indices were resolved for and its generation at the time.
+    const puppet_mapping_t *mapping;
+    uint32_t mapping_generation;
+
+    // Changes each time the node indices are resolved.
+    uint32_t version;
+
+    // Name and node index of one of the resolved bones. Looked up again to detect that the nodes of
+    // the scene tree were rebuilt (e.g. when its asset changed).
+    uint64_t check_name;
+    uint32_t check_node;
+
+    // Number of bones `nodes` and `rest_rot` have room for.
+    uint32_t capacity;
+
+    // Node index of each bone, NODE_NOT_FOUND if the bone isn't in the scene tree.
+    uint32_t *nodes;
+
+    // Rotation of each bone in the bind pose, identity if the bone isn't in the bind pose. This is
+    // used as the rest pose of the skeleton when retargeting. It is read from the Truth rather than
+    // from the scene tree, so that it doesn't depend on the pose the scene tree is in when the
+    // remap is built.
+    tm_vec4_t *rest_rot;
+} bone_remap_t;
+
+// Local transforms of the bones, stored as one array per component of the position, rotation and
+// scale.
+typedef struct bone_pose_t
+{
+    float *pos[3];
+    float *rot[4];
+    float *scl[3];
+
+    // Number of bones the arrays have room for, a multiple of four.
+    uint32_t capacity;
+    uint32_t reserved;
+
+    // Single allocation holding all the arrays.
+    float *data;
+} bone_pose_t;
+
+// An entity followed by puppets. The pose of each root is read once per frame and shared by all
+// of its puppets.
+typedef struct puppet_root_t
+{
+    tm_entity_t entity;
+
+    // Bone mapping of the puppets following the root.
+    const puppet_mapping_t *mapping;
+
+    // Bones of the scene tree of the root.
+    bone_remap_t remap;
+
+    // Local transforms of the bones of the root, read once per frame before the puppets are
+    // updated. Only valid for the bones found in `remap`.
+    bone_pose_t pose;
+
+    // Set if the root is followed by any puppet this frame. Roots without puppets are dropped.
+    bool used;
+
+    // Set if the root has a scene tree this frame.
+    bool valid;
+} puppet_root_t;
 
 typedef struct tm_animation_puppet_component_t
 {
     tm_vec3_t transform_factor;
     tm_vec4_t rotation_factor;
     tm_vec3_t scale_factor;
+
+    // Entity asset the puppet follows. If not set, the puppet follows the entity tagged with
+    // `ANIMATION_ROOT_TAG_HASH`.
+    tm_tt_id_t root_asset;
+
+    // `root_asset` resolved to an entity, done on first use.
+    tm_entity_t root;
+
+    // Set if `root_asset` couldn't be resolved, and the Truth version of `root_asset` at the time.
+    bool root_unresolved;
+    uint64_t root_unresolved_version;
+
+    // Index of the root followed this frame in `tm_animation_puppet_component_manager_t.roots`,
+    // ROOT_NOT_FOUND if there is none.
+    uint32_t root_index;
+
+    // If set, the rotations are corrected for the difference between the rest poses of the root
+    // and the puppet.
+    bool retarget;
+
+    // Bone mapping used by the puppet.
+    const puppet_mapping_t *mapping;
+
+    // Bones of the scene tree of the puppet.
+    bone_remap_t remap;
+
+    // Set before the puppets are updated if `remap` has to be rebuilt, along with the bind pose to
+    // rebuild it from. The bind pose is only looked up for retargeted puppets.
+    bool rebuild_remap;
+    const puppet_bind_pose_t *bind_pose;
+
+    // Root and versions of the remaps `corrections` was computed for.
+    tm_entity_t corrected_root;
+    uint32_t corrected_root_version;
+    uint32_t corrected_version;
+
+    // Number of bones `corrections` has room for, a multiple of four.
+    uint32_t corrections_capacity;
+
+    // Rotation applied to each bone of the root pose when retargeting. Four arrays of
+    // `corrections_capacity` floats, one per component.
+    float *corrections;
+
+    // Update tier and tier distance set in the Truth.
+    uint32_t update_tier;
+    float tier_distance;
+
+    // Update tier this frame, picked from `update_tier` and the distance to the LOD reference.
+    uint32_t tier;
+
+    // Offset of the frames the root pose is copied on, so that the puppets of a tier don't all copy
+    // on the same frame.
+    uint32_t phase;
+
+    // Set if the root pose is copied this frame, otherwise the puppet interpolates between `keys`.
+    bool copy;
+
+    // Root entity the poses in `keys` were copied from.
+    tm_entity_t keyed_root;
+
+    // Number of valid poses in `keys` and index of the latest one.
+    uint32_t num_keys;
+    uint32_t key_index;
+
+    // Time since the latest key and time between the two keys.
+    float key_time;
+    float key_duration;
+
+    // Last two poses copied from the root, with the factors and corrections applied. Only used by
+    // puppets in tiers above zero.
+    bone_pose_t keys[2];
+
+    // Transforms last written to the scene tree of the puppet. Only valid for the bones the puppet
+    // writes, and only if `written_valid` is set, which is cleared when the remap is rebuilt.
+    bone_pose_t written;
+    bool written_valid;
+
+    // Version of the root remap when `written` was last filled in. Bones found in a rebuilt root
+    // remap have never been written.
+    uint32_t written_root_version;
+
+    // Name hashes of the bones in the mask set in the Truth, and whether they are excluded rather
+    // than included.
+    uint32_t num_mask_names;
+    bool mask_exclude;
+    uint64_t *mask_names;
+
+    // Bitset of the bones of `mapping` written by the puppet, built from the mask names for the
+    // mapping and generation in `mask_mapping` and `mask_generation`.
+    const puppet_mapping_t *mask_mapping;
+    uint32_t mask_generation;
+    uint32_t mask_capacity;
+    uint64_t *mask;
+
+    // Set if any bit of `mask` is set. Puppets with an empty mask are skipped.
+    bool mask_any;
 } tm_animation_puppet_component_t;
 
 typedef struct tm_animation_puppet_component_manager_t
 {
     tm_entity_context_o *ctx;
     tm_allocator_i allocator;
+
+    // Component types used by the engine, looked up when the engine is registered.
+    tm_component_type_t scene_tree_component;
+    tm_component_type_t tag_component;
+    tm_component_type_t transform_component;
+    tm_tag_component_manager_o *tag_manager;
+
+    // Entity tagged with `ANIMATION_ROOT_TAG_HASH`, only searched for again when it is destroyed or
+    // loses the tag.
+    tm_entity_t tagged_root;
+
+    // carray of the roots followed by the puppets.
+    puppet_root_t *roots;
+
+    // carray of the compiled bone mappings. The first one is the built-in mapping.
+    puppet_mapping_t **mappings;
+
+    // Bind poses of the DCC assets of the scene trees of the roots and the puppets, by asset.
+    bind_pose_map_t bind_poses;
+
+    // Type of the DCC assets, looked up once when the manager is created.
+    uint64_t dcc_asset_type;
+
+    // Version given to the next remap of a root.
+    uint32_t root_remap_version;
+
+    // Number of updates so far, used to pick the frames puppets in the lower tiers copy on.
+    uint32_t frame;
+
+    // Delta time of the current update.
+    float dt;
+
+    // Entity tagged with `LOD_REFERENCE_TAG_HASH`, cached like `tagged_root`.
+    tm_entity_t lod_reference;
 } tm_animation_puppet_component_manager_t;
 
 static tm_animation_puppet_component_t default_values = {
@@ -93,12 +384,62 @@ static void read_vec4(const tm_the_truth_o *tt, const tm_the_truth_object_o *o,
     a->w = tm_the_truth_api->get_float(tt, o, TM_TT_PROP__VEC4__W);
 }
 
+static tm_tt_id_t asset_browser_create__bone_mapping(struct tm_asset_browser_create_asset_o *inst, tm_the_truth_o *tt, tm_tt_undo_scope_t undo_scope)
+{
+    const tm_tt_type_t type = tm_the_truth_api->object_type_from_name_hash(tt, TM_TT_TYPE_HASH__IG_ANIMATION_PUPPET_BONE_MAPPING);
+    return tm_the_truth_api->create_object_of_type(tt, type, undo_scope);
+}
+
+static tm_asset_browser_create_asset_i asset_browser_create_bone_mapping = {
+    .menu_name = TM_LOCALIZE_LATER("New Puppet Bone Mapping"),
+    .asset_name = TM_LOCALIZE_LATER("New Puppet Bone Mapping"),
+    .create = asset_browser_create__bone_mapping,
+};
+
+static void create_bone_mapping_types(struct tm_the_truth_o *tt)
+{
+    tm_the_truth_property_definition_t bone_properties[] = {
+        { "root_name",   TM_THE_TRUTH_PROPERTY_TYPE_STRING },
+        { "target_name", TM_THE_TRUTH_PROPERTY_TYPE_STRING },
+        { "channels",    TM_THE_TRUTH_PROPERTY_TYPE_UINT32_T },
+    };
+
+    const tm_tt_type_t bone_type = tm_the_truth_api->create_object_type(tt, TM_TT_TYPE__IG_ANIMATION_PUPPET_BONE, bone_properties, TM_ARRAY_COUNT(bone_properties));
+
+    const tm_tt_id_t bone = tm_the_truth_api->create_object_of_type(tt, bone_type, TM_TT_NO_UNDO_SCOPE);
+    tm_the_truth_object_o *bone_w = tm_the_truth_api->write(tt, bone);
+    tm_the_truth_api->set_uint32_t(tt, bone_w, TM_TT_PROP__IG_ANIMATION_PUPPET_BONE__CHANNELS, TM_IG_ANIMATION_PUPPET_CHANNEL_ROTATION | TM_IG_ANIMATION_PUPPET_CHANNEL_SCALE);
+    tm_the_truth_api->commit(tt, bone_w, TM_TT_NO_UNDO_SCOPE);
+    tm_the_truth_api->set_default_object(tt, bone_type, bone);
+
+    tm_the_truth_property_definition_t bone_mapping_properties[] = {
+        { "bones", TM_THE_TRUTH_PROPERTY_TYPE_SUBOBJECT_SET, .type_hash = TM_TT_TYPE_HASH__IG_ANIMATION_PUPPET_BONE },
+    };
+
+    const tm_tt_type_t bone_mapping_type = tm_the_truth_api->create_object_type(tt, TM_TT_TYPE__IG_ANIMATION_PUPPET_BONE_MAPPING, bone_mapping_properties, TM_ARRAY_COUNT(bone_mapping_properties));
+    tm_the_truth_api->set_aspect(tt, bone_mapping_type, TM_TT_ASPECT__FILE_EXTENSION, "puppet_bone_mapping");
+}
+
 static void component__create_types(struct tm_the_truth_o *tt)
 {
+    create_bone_mapping_types(tt);
+
+    tm_the_truth_property_definition_t mask_bone_properties[] = {
+        { "name", TM_THE_TRUTH_PROPERTY_TYPE_STRING },
+    };
+    tm_the_truth_api->create_object_type(tt, TM_TT_TYPE__IG_ANIMATION_PUPPET_MASK_BONE, mask_bone_properties, TM_ARRAY_COUNT(mask_bone_properties));
+
     tm_the_truth_property_definition_t animation_puppet_component_properties[] = {
         { "transform_factor", TM_THE_TRUTH_PROPERTY_TYPE_SUBOBJECT, .type_hash = TM_TT_TYPE_HASH__POSITION },
         { "rotation_factor", TM_THE_TRUTH_PROPERTY_TYPE_SUBOBJECT, .type_hash = TM_TT_TYPE_HASH__ROTATION },
         { "scale_factor",    TM_THE_TRUTH_PROPERTY_TYPE_SUBOBJECT, .type_hash = TM_TT_TYPE_HASH__SCALE },
+        { "root",            TM_THE_TRUTH_PROPERTY_TYPE_REFERENCE, .type_hash = TM_TT_TYPE_HASH__ENTITY },
+        { "retarget",        TM_THE_TRUTH_PROPERTY_TYPE_BOOL },
+        { "mapping",         TM_THE_TRUTH_PROPERTY_TYPE_REFERENCE, .type_hash = TM_TT_TYPE_HASH__IG_ANIMATION_PUPPET_BONE_MAPPING },
+        { "update_tier",     TM_THE_TRUTH_PROPERTY_TYPE_UINT32_T },
+        { "tier_distance",   TM_THE_TRUTH_PROPERTY_TYPE_FLOAT },
+        { "mask",            TM_THE_TRUTH_PROPERTY_TYPE_SUBOBJECT_SET, .type_hash = TM_TT_TYPE_HASH__IG_ANIMATION_PUPPET_MASK_BONE },
+        { "mask_exclude",    TM_THE_TRUTH_PROPERTY_TYPE_BOOL },
     };
 
     const tm_tt_type_t object_type = tm_the_truth_api->create_object_type(tt, TM_TT_TYPE__IG_ANIMATION_PUPPET, animation_puppet_component_properties, TM_ARRAY_COUNT(animation_puppet_component_properties));
@@ -132,14 +473,135 @@ static void component__create_types(struct tm_the_truth_o *tt)
 //    tm_the_truth_api->set_aspect(tt, object_type, TM_TT_ASPECT__VALIDATE, properties__validate);
 }
 
+// Compiles the bone mapping asset `asset`. Bones without a root name are skipped.
+static void compile_bone_mapping(puppet_mapping_t *mapping, const tm_the_truth_o *tt, tm_tt_id_t asset, tm_allocator_i *a)
+{
+    TM_INIT_TEMP_ALLOCATOR(ta);
+
+    const tm_tt_id_t *bones = tm_the_truth_api->get_subobject_set(tt, tm_tt_read(tt, asset), TM_TT_PROP__IG_ANIMATION_PUPPET_BONE_MAPPING__BONES, ta);
+    const uint32_t num_bones = (uint32_t)tm_carray_size(bones);
+
+    uint64_t *root_names = 0;
+    uint64_t *target_names = 0;
+    uint32_t *channels = 0;
+    for (uint32_t i = 0; i < num_bones; ++i) {
+        const tm_the_truth_object_o *bone = tm_tt_read(tt, bones[i]);
+        const char *root_name = tm_the_truth_api->get_string(tt, bone, TM_TT_PROP__IG_ANIMATION_PUPPET_BONE__ROOT_NAME);
+        const char *target_name = tm_the_truth_api->get_string(tt, bone, TM_TT_PROP__IG_ANIMATION_PUPPET_BONE__TARGET_NAME);
+        if (!root_name || !*root_name)
+            continue;
+
+        const uint64_t root_hash = tm_murmur_hash_string(root_name);
+        tm_carray_temp_push(root_names, root_hash, ta);
+        tm_carray_temp_push(target_names, target_name && *target_name ? tm_murmur_hash_string(target_name) : root_hash, ta);
+        tm_carray_temp_push(channels, tm_the_truth_api->get_uint32_t(tt, bone, TM_TT_PROP__IG_ANIMATION_PUPPET_BONE__CHANNELS), ta);
+    }
+
+    bone_mapping_create(&mapping->bones, root_names, target_names, channels, (uint32_t)tm_carray_size(root_names), a);
+
+    TM_SHUTDOWN_TEMP_ALLOCATOR(ta);
+}
+
+// Returns the compiled bone mapping of `asset`, compiling it if it hasn't been compiled yet or has
+// changed since. Returns the built-in mapping if `asset` isn't set.
+static const puppet_mapping_t *load_bone_mapping(tm_animation_puppet_component_manager_t *manager, const tm_the_truth_o *tt, tm_tt_id_t asset)
+{
+    if (!asset.u64 || !tm_the_truth_api->is_alive(tt, asset))
+        return manager->mappings[0];
+
+    const uint64_t version = tm_the_truth_api->version(tt, asset);
+    puppet_mapping_t *mapping = 0;
+    for (uint32_t i = 1; i < tm_carray_size(manager->mappings); ++i) {
+        if (manager->mappings[i]->asset.u64 == asset.u64)
+            mapping = manager->mappings[i];
+    }
+
+    if (mapping && mapping->version == version)
+        return mapping;
+
+    if (mapping) {
+        bone_mapping_destroy(&mapping->bones, &manager->allocator);
+    } else {
+        mapping = tm_alloc(&manager->allocator, sizeof(*mapping));
+        *mapping = (puppet_mapping_t){ .asset = asset };
+        tm_carray_push(manager->mappings, mapping, &manager->allocator);
+    }
+
+    compile_bone_mapping(mapping, tt, asset, &manager->allocator);
+    mapping->version = version;
+    mapping->generation++;
+    return mapping;
+}
+
+// Recompiles the bone mappings whose asset has changed since they were compiled. Puppets only
+// load their mapping when they are loaded, so without this, edits to a mapping asset wouldn't
+// reach the running puppets. The new generation makes the puppets and roots using the mapping
+// rebuild their remaps and masks.
+static void update_bone_mappings(tm_animation_puppet_component_manager_t *manager, const tm_the_truth_o *tt)
+{
+    for (uint32_t i = 1; i < tm_carray_size(manager->mappings); ++i) {
+        const tm_tt_id_t asset = manager->mappings[i]->asset;
+        if (tm_the_truth_api->is_alive(tt, asset) && tm_the_truth_api->version(tt, asset) != manager->mappings[i]->version)
+            load_bone_mapping(manager, tt, asset);
+    }
+}
+
+// Returns the bind pose of the scene trees created from `asset`, reading it from the Truth if it
+// hasn't been read yet or has changed since. Returns NULL if `asset` isn't a DCC asset. Only called
+// when a remap is rebuilt.
+static const puppet_bind_pose_t *load_bind_pose(tm_animation_puppet_component_manager_t *manager, const tm_the_truth_o *tt, tm_tt_id_t asset)
+{
+    if (!asset.u64 || asset.type != manager->dcc_asset_type || !tm_the_truth_api->is_alive(tt, asset))
+        return NULL;
+
+    const uint64_t version = tm_the_truth_api->version(tt, asset);
+    puppet_bind_pose_t *bind_pose = tm_hash_get(&manager->bind_poses, asset.u64);
+    if (bind_pose && bind_pose->version == version)
+        return bind_pose;
+
+    if (bind_pose) {
+        tm_free(&manager->allocator, bind_pose->names, bind_pose->num_nodes * sizeof(*bind_pose->names));
+        tm_free(&manager->allocator, bind_pose->rot, bind_pose->num_nodes * sizeof(*bind_pose->rot));
+    } else {
+        bind_pose = tm_alloc(&manager->allocator, sizeof(*bind_pose));
+        tm_hash_add(&manager->bind_poses, asset.u64, bind_pose);
+    }
+
+    TM_INIT_TEMP_ALLOCATOR(ta);
+    const tm_tt_id_t *nodes = tm_the_truth_api->get_subobject_set(tt, tm_tt_read(tt, asset), TM_TT_PROP__DCC_ASSET__NODES, ta);
+    *bind_pose = (puppet_bind_pose_t){
+        .asset = asset,
+        .version = version,
+        .num_nodes = (uint32_t)tm_carray_size(nodes),
+    };
+    bind_pose->names = tm_alloc(&manager->allocator, bind_pose->num_nodes * sizeof(*bind_pose->names));
+    bind_pose->rot = tm_alloc(&manager->allocator, bind_pose->num_nodes * sizeof(*bind_pose->rot));
+    for (uint32_t i = 0; i < bind_pose->num_nodes; ++i) {
+        const tm_the_truth_object_o *node = tm_tt_read(tt, nodes[i]);
+        const char *name = tm_the_truth_api->get_string(tt, node, TM_TT_PROP__DCC_ASSET_NODE__NAME);
+        const tm_tt_id_t rotation = tm_the_truth_api->get_subobject(tt, node, TM_TT_PROP__DCC_ASSET_NODE__ROTATION);
+        bind_pose->names[i] = name ? tm_murmur_hash_string(name) : 0;
+        bind_pose->rot[i] = (tm_vec4_t){ 0, 0, 0, 1 };
+        if (rotation.u64) {
+            const tm_the_truth_object_o *r = tm_tt_read(tt, rotation);
+            bind_pose->rot[i] = (tm_vec4_t){
+                tm_the_truth_api->get_float(tt, r, TM_TT_PROP__DCC_ASSET_ROTATION__X),
+                tm_the_truth_api->get_float(tt, r, TM_TT_PROP__DCC_ASSET_ROTATION__X + 1),
+                tm_the_truth_api->get_float(tt, r, TM_TT_PROP__DCC_ASSET_ROTATION__X + 2),
+                tm_the_truth_api->get_float(tt, r, TM_TT_PROP__DCC_ASSET_ROTATION__X + 3),
+            };
+        }
+    }
+    TM_SHUTDOWN_TEMP_ALLOCATOR(ta);
+    return bind_pose;
+}
+
 static bool component__load_asset(tm_component_manager_o *manager_, tm_entity_t e, void *data, const tm_the_truth_o *tt, tm_tt_id_t asset)
 {
     tm_animation_puppet_component_manager_t *manager = (tm_animation_puppet_component_manager_t *)manager_;
     tm_animation_puppet_component_t *c = data;
     const tm_the_truth_object_o *asset_obj = tm_the_truth_api->read(tt, asset);
 
-    (void)manager;
-
     tm_tt_id_t position_id = tm_the_truth_api->get_subobject(tt, asset_obj, TM_TT_PROP__IG_ANIMATION_PUPPET__POSITION_FACTOR);
     read_vec3(tt, tm_tt_read(tt, position_id), &c->transform_factor);
 
@@ -149,15 +611,94 @@ static bool component__load_asset(tm_component_manager_o *manager_, tm_entity_t
     tm_tt_id_t scale_id = tm_the_truth_api->get_subobject(tt, asset_obj, TM_TT_PROP__IG_ANIMATION_PUPPET__SCALE_FACTOR);
     read_vec3(tt, tm_tt_read(tt, scale_id), &c->scale_factor);
 
+    c->root_asset = tm_the_truth_api->get_reference(tt, asset_obj, TM_TT_PROP__IG_ANIMATION_PUPPET__ROOT);
+    c->root = (tm_entity_t){ 0 };
+    c->root_unresolved = false;
+    c->root_index = ROOT_NOT_FOUND;
+    c->retarget = tm_the_truth_api->get_bool(tt, asset_obj, TM_TT_PROP__IG_ANIMATION_PUPPET__RETARGET);
+    c->mapping = load_bone_mapping(manager, tt, tm_the_truth_api->get_reference(tt, asset_obj, TM_TT_PROP__IG_ANIMATION_PUPPET__MAPPING));
+    c->remap.stc = NULL;
+    c->corrected_root = (tm_entity_t){ 0 };
+    c->update_tier = TM_MIN(tm_the_truth_api->get_uint32_t(tt, asset_obj, TM_TT_PROP__IG_ANIMATION_PUPPET__UPDATE_TIER), MAX_UPDATE_TIER);
+    c->tier_distance = tm_the_truth_api->get_float(tt, asset_obj, TM_TT_PROP__IG_ANIMATION_PUPPET__TIER_DISTANCE);
+    c->phase = e.index;
+    c->num_keys = 0;
+    c->written_valid = false;
+
+    TM_INIT_TEMP_ALLOCATOR(ta);
+    const tm_tt_id_t *mask = tm_the_truth_api->get_subobject_set(tt, asset_obj, TM_TT_PROP__IG_ANIMATION_PUPPET__MASK, ta);
+    tm_free(&manager->allocator, c->mask_names, c->num_mask_names * sizeof(*c->mask_names));
+    c->num_mask_names = (uint32_t)tm_carray_size(mask);
+    c->mask_names = c->num_mask_names ? tm_alloc(&manager->allocator, c->num_mask_names * sizeof(*c->mask_names)) : 0;
+    for (uint32_t i = 0; i < c->num_mask_names; ++i) {
+        const char *name = tm_the_truth_api->get_string(tt, tm_tt_read(tt, mask[i]), TM_TT_PROP__IG_ANIMATION_PUPPET_MASK_BONE__NAME);
+        c->mask_names[i] = name ? tm_murmur_hash_string(name) : 0;
+    }
+    c->mask_exclude = tm_the_truth_api->get_bool(tt, asset_obj, TM_TT_PROP__IG_ANIMATION_PUPPET__MASK_EXCLUDE);
+    c->mask_mapping = NULL;
+    TM_SHUTDOWN_TEMP_ALLOCATOR(ta);
+
     return true;
 }
 
+static void remap_free(bone_remap_t *remap, tm_allocator_i *a)
+{
+    tm_free(a, remap->nodes, remap->capacity * sizeof(*remap->nodes));
+    tm_free(a, remap->rest_rot, remap->capacity * sizeof(*remap->rest_rot));
+    *remap = (bone_remap_t){ 0 };
+}
+
+static void pose_free(bone_pose_t *pose, tm_allocator_i *a)
+{
+    tm_free(a, pose->data, pose->capacity * 10 * sizeof(float));
+    *pose = (bone_pose_t){ 0 };
+}
+
+static void component__remove(tm_component_manager_o *manager_, tm_entity_t e, void *data)
+{
+    tm_animation_puppet_component_manager_t *manager = (tm_animation_puppet_component_manager_t *)manager_;
+    tm_animation_puppet_component_t *c = data;
+
+    remap_free(&c->remap, &manager->allocator);
+    tm_free(&manager->allocator, c->corrections, c->corrections_capacity * 4 * sizeof(float));
+    c->corrections = 0;
+    c->corrections_capacity = 0;
+    pose_free(&c->keys[0], &manager->allocator);
+    pose_free(&c->keys[1], &manager->allocator);
+    pose_free(&c->written, &manager->allocator);
+    tm_free(&manager->allocator, c->mask_names, c->num_mask_names * sizeof(*c->mask_names));
+    tm_free(&manager->allocator, c->mask, c->mask_capacity * sizeof(*c->mask));
+    c->mask_names = 0;
+    c->num_mask_names = 0;
+    c->mask = 0;
+    c->mask_capacity = 0;
+}
+
 static void destroy(tm_component_manager_o *manager)
 {
     tm_animation_puppet_component_manager_t *man = (tm_animation_puppet_component_manager_t *)manager;
 
     tm_entity_context_o *ctx = man->ctx;
     tm_allocator_i a = man->allocator;
+    for (puppet_root_t *root = man->roots; root != tm_carray_end(man->roots); ++root) {
+        remap_free(&root->remap, &a);
+        pose_free(&root->pose, &a);
+    }
+    tm_carray_free(man->roots, &a);
+    for (uint32_t i = 0; i < tm_carray_size(man->mappings); ++i) {
+        bone_mapping_destroy(&man->mappings[i]->bones, &a);
+        tm_free(&a, man->mappings[i], sizeof(*man->mappings[i]));
+    }
+    tm_carray_free(man->mappings, &a);
+    for (uint32_t i = 0; i < man->bind_poses.num_buckets; ++i) {
+        if (!tm_hash_use_index(&man->bind_poses, i))
+            continue;
+        puppet_bind_pose_t *bind_pose = man->bind_poses.values[i];
+        tm_free(&a, bind_pose->names, bind_pose->num_nodes * sizeof(*bind_pose->names));
+        tm_free(&a, bind_pose->rot, bind_pose->num_nodes * sizeof(*bind_pose->rot));
+        tm_free(&a, bind_pose, sizeof(*bind_pose));
+    }
+    tm_hash_free(&man->bind_poses);
     tm_free(&a, man, sizeof(*man));
     tm_entity_api->destroy_child_allocator(ctx, &a);
 }
@@ -169,13 +710,25 @@ static void component__create(struct tm_entity_context_o *ctx)
     tm_animation_puppet_component_manager_t *manager = tm_alloc(&a, sizeof(*manager));
     *manager = (tm_animation_puppet_component_manager_t){
         .ctx = ctx,
-        .allocator = a
+        .allocator = a,
+        .dcc_asset_type = tm_the_truth_api->object_type_from_name_hash(tm_entity_api->the_truth(ctx), TM_TT_TYPE_HASH__DCC_ASSET).u64,
     };
+    manager->bind_poses.allocator = &manager->allocator;
+
+    // The built-in mapping translates the Hips bone only.
+    uint32_t channels[BONE_COUNT];
+    for (uint32_t bone_idx = 0; bone_idx < BONE_COUNT; bone_idx++)
+        channels[bone_idx] = bone_idx == 0 ? TM_IG_ANIMATION_PUPPET_CHANNEL_ALL : TM_IG_ANIMATION_PUPPET_CHANNEL_ROTATION | TM_IG_ANIMATION_PUPPET_CHANNEL_SCALE;
+    puppet_mapping_t *mapping = tm_alloc(&manager->allocator, sizeof(*mapping));
+    *mapping = (puppet_mapping_t){ .generation = 1 };
+    bone_mapping_create(&mapping->bones, BONES_1, BONES_2, channels, BONE_COUNT, &manager->allocator);
+    tm_carray_push(manager->mappings, mapping, &manager->allocator);
 
     tm_component_i component = {
         .name = TM_TT_TYPE__IG_ANIMATION_PUPPET,
         .bytes = sizeof(tm_animation_puppet_component_t),
         .load_asset = component__load_asset,
+        .remove = component__remove,
         .destroy = destroy,
         .manager = (tm_component_manager_o *)manager
     };
@@ -183,59 +736,680 @@ static void component__create(struct tm_entity_context_o *ctx)
     tm_entity_api->register_component(ctx, &component);
 }
 
-static void engine_update__bind(tm_engine_o *inst, tm_engine_update_set_t *data)
+// Makes room for `num_bones` bones in `remap`.
+static void remap_reserve(bone_remap_t *remap, uint32_t num_bones, tm_allocator_i *a)
 {
-    struct tm_entity_context_o *ctx = (struct tm_entity_context_o *)inst;
+    if (remap->capacity >= num_bones)
+        return;
 
-    float dt = 1.0f / 60.0f;
-    for (const tm_entity_blackboard_value_t *bb = data->blackboard_start; bb != data->blackboard_end; ++bb) {
-        if (bb->id == TM_ENTITY_BB__DELTA_TIME)
-            dt = (float)bb->double_value;
+    remap->nodes = tm_realloc(a, remap->nodes, remap->capacity * sizeof(*remap->nodes), num_bones * sizeof(*remap->nodes));
+    remap->rest_rot = tm_realloc(a, remap->rest_rot, remap->capacity * sizeof(*remap->rest_rot), num_bones * sizeof(*remap->rest_rot));
+    remap->capacity = num_bones;
+}
+
+// Returns the rotation of the node `name` in `bind_pose`, identity if it isn't found. This is a
+// linear search, but it is only done when a remap is rebuilt.
+static tm_vec4_t bind_pose_rotation(const puppet_bind_pose_t *bind_pose, uint64_t name)
+{
+    for (uint32_t i = 0; bind_pose && i < bind_pose->num_nodes; ++i) {
+        if (bind_pose->names[i] == name)
+            return bind_pose->rot[i];
+    }
+    return (tm_vec4_t){ 0, 0, 0, 1 };
+}
+
+// Resolves the node indices of the bones of `mapping` in `stc` and reads their rest rotations from
+// `bind_pose`. Each bone is looked up by its root name, and by its target name if
+// `use_target_names` is set and that fails. `remap` must have room for all the bones of the
+// mapping.
+static void remap_build(bone_remap_t *remap, const tm_scene_tree_component_t *stc, const puppet_mapping_t *mapping, const puppet_bind_pose_t *bind_pose, bool use_target_names, uint32_t version)
+{
+    remap->stc = stc;
+    remap->mapping = mapping;
+    remap->mapping_generation = mapping->generation;
+    remap->version = version;
+    remap->check_name = 0;
+    remap->check_node = NODE_NOT_FOUND;
+
+    const bone_mapping_t *bones = &mapping->bones;
+    for (uint32_t bone_idx = 0; bone_idx < bones->num_bones; bone_idx++) {
+        uint64_t name = bones->root_names[bone_idx];
+        uint32_t node_index = tm_scene_tree_component_api->node_index_from_name(stc, name, NODE_NOT_FOUND);
+        if (node_index == NODE_NOT_FOUND && use_target_names && bones->target_names[bone_idx] != name) {
+            name = bones->target_names[bone_idx];
+            node_index = tm_scene_tree_component_api->node_index_from_name(stc, name, NODE_NOT_FOUND);
+        }
+        remap->nodes[bone_idx] = node_index;
+        remap->rest_rot[bone_idx] = (tm_vec4_t){ 0, 0, 0, 1 };
+        if (node_index == NODE_NOT_FOUND)
+            continue;
+
+        remap->rest_rot[bone_idx] = bind_pose_rotation(bind_pose, name);
+        if (remap->check_node == NODE_NOT_FOUND) {
+            remap->check_name = name;
+            remap->check_node = node_index;
+        }
     }
+}
+
+// Returns true if `remap` was resolved in `stc` for `mapping` and neither of them has changed
+// since.
+static bool remap_valid(const bone_remap_t *remap, const tm_scene_tree_component_t *stc, const puppet_mapping_t *mapping)
+{
+    if (remap->stc != stc || remap->mapping != mapping || remap->mapping_generation != mapping->generation)
+        return false;
+    if (remap->check_node == NODE_NOT_FOUND)
+        return true;
+    return tm_scene_tree_component_api->node_index_from_name(stc, remap->check_name, NODE_NOT_FOUND) == remap->check_node;
+}
+
+// Makes room for `num_bones` bones in `pose`. The padding at the end of the arrays is zeroed.
+static void pose_reserve(bone_pose_t *pose, uint32_t num_bones, tm_allocator_i *a)
+{
+    const uint32_t capacity = padded_bone_count(num_bones);
+    if (pose->capacity >= capacity)
+        return;
 
-    tm_entity_t root = tm_tag_component_api->find_first(tm_tag_component_manager, ANIMATION_ROOT_TAG_HASH);
-    tm_scene_tree_component_t *root_stc = tm_entity_api->get_component(ctx, root, tm_entity_api->lookup_component_type(ctx, TM_TT_TYPE_HASH__SCENE_TREE_COMPONENT));
+    pose->data = tm_realloc(a, pose->data, pose->capacity * 10 * sizeof(float), capacity * 10 * sizeof(float));
+    pose->capacity = capacity;
+    memset(pose->data, 0, capacity * 10 * sizeof(float));
+    for (uint32_t k = 0; k < 3; ++k)
+        pose->pos[k] = pose->data + k * capacity;
+    for (uint32_t k = 0; k < 4; ++k)
+        pose->rot[k] = pose->data + (3 + k) * capacity;
+    for (uint32_t k = 0; k < 3; ++k)
+        pose->scl[k] = pose->data + (7 + k) * capacity;
+}
+
+static void pose_store(bone_pose_t *pose, uint32_t bone_idx, const tm_transform_t *t)
+{
+    pose->pos[0][bone_idx] = t->pos.x;
+    pose->pos[1][bone_idx] = t->pos.y;
+    pose->pos[2][bone_idx] = t->pos.z;
+    pose->rot[0][bone_idx] = t->rot.x;
+    pose->rot[1][bone_idx] = t->rot.y;
+    pose->rot[2][bone_idx] = t->rot.z;
+    pose->rot[3][bone_idx] = t->rot.w;
+    pose->scl[0][bone_idx] = t->scl.x;
+    pose->scl[1][bone_idx] = t->scl.y;
+    pose->scl[2][bone_idx] = t->scl.z;
+}
 
-    if (root.u64 == 0 || root_stc == NULL) {
+// Makes room for the corrections of `num_bones` bones in `c`.
+static void corrections_reserve(tm_animation_puppet_component_t *c, uint32_t num_bones, tm_allocator_i *a)
+{
+    const uint32_t capacity = padded_bone_count(num_bones);
+    if (c->corrections_capacity >= capacity)
         return;
+
+    tm_free(a, c->corrections, c->corrections_capacity * 4 * sizeof(float));
+    c->corrections = tm_alloc(a, capacity * 4 * sizeof(float));
+    c->corrections_capacity = capacity;
+    c->corrected_root = (tm_entity_t){ 0 };
+}
+
+// Builds the bitset of the bones of the mapping of `c` that the puppet writes. These are the bones
+// in the mask, all the bones if the mask is empty, or all but the bones in the mask if it excludes
+// them. Bones without any channels are left out.
+static void mask_build(tm_animation_puppet_component_t *c, tm_allocator_i *a)
+{
+    const bone_mapping_t *bones = &c->mapping->bones;
+    const uint32_t num_words = (bones->num_bones + 63) / 64;
+    if (c->mask_capacity < num_words) {
+        c->mask = tm_realloc(a, c->mask, c->mask_capacity * sizeof(*c->mask), num_words * sizeof(*c->mask));
+        c->mask_capacity = num_words;
+    }
+
+    const bool all = !c->num_mask_names || c->mask_exclude;
+    memset(c->mask, all ? 0xff : 0, num_words * sizeof(*c->mask));
+    for (uint32_t i = 0; i < c->num_mask_names; ++i) {
+        const uint32_t bone_idx = bone_mapping_find(bones, c->mask_names[i]);
+        if (bone_idx == BONE_MAPPING_NOT_FOUND)
+            continue;
+        if (all)
+            c->mask[bone_idx / 64] &= ~(1ULL << (bone_idx % 64));
+        else
+            c->mask[bone_idx / 64] |= 1ULL << (bone_idx % 64);
+    }
+
+    for (uint32_t bone_idx = 0; bone_idx < num_words * 64; ++bone_idx) {
+        if (bone_idx >= bones->num_bones || !(bones->channels[bone_idx] & TM_IG_ANIMATION_PUPPET_CHANNEL_ALL))
+            c->mask[bone_idx / 64] &= ~(1ULL << (bone_idx % 64));
+    }
+
+    c->mask_any = false;
+    for (uint32_t word = 0; word < num_words; ++word)
+        c->mask_any |= c->mask[word] != 0;
+
+    c->mask_mapping = c->mapping;
+    c->mask_generation = c->mapping->generation;
+}
+
+// Returns the entity tagged with `tag`, searching for it only if the `cached` entity is gone or has
+// lost the tag.
+static tm_entity_t find_tagged(tm_animation_puppet_component_manager_t *manager, tm_entity_t *cached, uint64_t tag)
+{
+    const tm_entity_t e = *cached;
+    if (e.u64 && tm_entity_api->is_alive(manager->ctx, e) && tm_tag_component_api->has_tag(manager->tag_manager, e, tag))
+        return e;
+
+    *cached = tm_tag_component_api->find_first(manager->tag_manager, tag);
+    return *cached;
+}
+
+// Returns the update tier of `c`. The puppet drops one tier for each `tier_distance` between its
+// transform and the transform of the LOD reference.
+static uint32_t update_tier(const tm_animation_puppet_component_t *c, const tm_transform_component_t *transform, const tm_transform_component_t *reference)
+{
+    uint32_t tier = c->update_tier;
+    if (c->tier_distance > 0.0f && transform && reference) {
+        const float distance = tm_vec3_length(tm_vec3_sub(transform->world.pos, reference->world.pos));
+        tier = TM_MAX(tier, (uint32_t)TM_MIN(distance / c->tier_distance, (float)MAX_UPDATE_TIER));
     }
+    return tier;
+}
+
+// Returns the index of the root `root` with the bone mapping `mapping` in the roots of `manager`,
+// adding it if needed. `hint` is the index the root had last frame.
+static uint32_t use_root(tm_animation_puppet_component_manager_t *manager, tm_entity_t root, const puppet_mapping_t *mapping, uint32_t hint)
+{
+    const uint32_t num_roots = (uint32_t)tm_carray_size(manager->roots);
+    uint32_t root_index = hint;
+    if (root_index >= num_roots || manager->roots[root_index].entity.u64 != root.u64 || manager->roots[root_index].mapping != mapping) {
+        root_index = 0;
+        while (root_index < num_roots && (manager->roots[root_index].entity.u64 != root.u64 || manager->roots[root_index].mapping != mapping))
+            ++root_index;
+        if (root_index == num_roots)
+            tm_carray_push(manager->roots, ((puppet_root_t){ .entity = root, .mapping = mapping }), &manager->allocator);
+    }
+    manager->roots[root_index].used = true;
+    return root_index;
+}
 
+// Finds the root followed by each of the puppets and reads the pose of each root once. Also picks
+// the update tier of each puppet and makes room for its bones, so that the puppets can be updated
+// without allocating.
+static void update_roots(tm_animation_puppet_component_manager_t *manager, tm_engine_update_set_t *data)
+{
+    tm_entity_context_o *ctx = manager->ctx;
+    const tm_the_truth_o *tt = tm_entity_api->the_truth(ctx);
+
+    update_bone_mappings(manager, tt);
+
+    // Drop the roots that weren't followed by any puppet last frame.
+    for (uint32_t i = 0; i < tm_carray_size(manager->roots);) {
+        if (manager->roots[i].used) {
+            manager->roots[i++].used = false;
+        } else {
+            remap_free(&manager->roots[i].remap, &manager->allocator);
+            pose_free(&manager->roots[i].pose, &manager->allocator);
+            const puppet_root_t last = tm_carray_pop(manager->roots);
+            if (i < tm_carray_size(manager->roots))
+                manager->roots[i] = last;
+        }
+    }
+
+    const tm_entity_t lod_reference = find_tagged(manager, &manager->lod_reference, LOD_REFERENCE_TAG_HASH);
+    const tm_transform_component_t *reference_transform = lod_reference.u64 ? tm_entity_api->get_component(ctx, lod_reference, manager->transform_component) : NULL;
+
+    tm_entity_t tagged_root = { 0 };
+    bool tagged_root_found = false;
     for (tm_engine_update_array_t *update_array = data->arrays; update_array < data->arrays + data->num_arrays; ++update_array) {
         tm_animation_puppet_component_t *bind = update_array->components[0];
-
+        const tm_scene_tree_component_t *stcs = update_array->components[1];
+        const tm_transform_component_t *transforms = update_array->components[3];
         for (uint32_t i = 0; i < update_array->n; ++i) {
-            tm_entity_t target_entity = update_array->entities[i];
-            tm_scene_tree_component_t *stc = tm_entity_api->get_component(ctx, target_entity, tm_entity_api->lookup_component_type(ctx, TM_TT_TYPE_HASH__SCENE_TREE_COMPONENT));
+            tm_animation_puppet_component_t *c = bind + i;
+            if (!c->mapping)
+                c->mapping = manager->mappings[0];
+            c->rebuild_remap = stcs && !remap_valid(&c->remap, stcs + i, c->mapping);
+            c->bind_pose = c->rebuild_remap && c->retarget ? load_bind_pose(manager, tt, stcs[i].scene_tree) : NULL;
+
+            tm_entity_t root;
+            if (c->root_asset.u64) {
+                if (!c->root.u64 || !tm_entity_api->is_alive(ctx, c->root)) {
+                    const uint64_t version = tm_the_truth_api->version(tt, c->root_asset);
+                    c->root = (tm_entity_t){ 0 };
+                    if (!c->root_unresolved || c->root_unresolved_version != version || (manager->frame + c->phase) % ROOT_RETRY_FRAMES == 0) {
+                        c->root = tm_entity_api->resolve_asset_reference(ctx, update_array->entities[i], c->root_asset);
+                        c->root_unresolved = !c->root.u64;
+                        c->root_unresolved_version = version;
+                    }
+                }
+                root = c->root;
+            } else {
+                if (!tagged_root_found) {
+                    tagged_root = find_tagged(manager, &manager->tagged_root, ANIMATION_ROOT_TAG_HASH);
+                    tagged_root_found = true;
+                }
+                root = tagged_root;
+            }
 
-            for (uint32_t bone_idx = 0; bone_idx < BONE_COUNT; bone_idx++) {
-                uint64_t root_node_name = BONES_1[bone_idx];
-                uint64_t target_node_name2 = BONES_2[bone_idx];
+            c->root_index = root.u64 ? use_root(manager, root, c->mapping, c->root_index) : ROOT_NOT_FOUND;
 
-                uint32_t node_index = tm_scene_tree_component_api->node_index_from_name(root_stc, root_node_name, NODE_NOT_FOUND);
-                if (node_index != NODE_NOT_FOUND) {
-                    tm_transform_t transform = tm_scene_tree_component_api->local_transform(root_stc, node_index);
+            // Keys copied from another root would be blended with the pose of the new one.
+            if (c->keyed_root.u64 != root.u64) {
+                c->keyed_root = root;
+                c->num_keys = 0;
+            }
 
-                    node_index = tm_scene_tree_component_api->node_index_from_name(stc, root_node_name, NODE_NOT_FOUND);
-                    if (node_index == NODE_NOT_FOUND)
-                        node_index = tm_scene_tree_component_api->node_index_from_name(stc, target_node_name2, NODE_NOT_FOUND);
-                    if (node_index == NODE_NOT_FOUND)
-                        continue;
+            const uint32_t num_bones = c->mapping->bones.num_bones;
+            remap_reserve(&c->remap, num_bones, &manager->allocator);
+            pose_reserve(&c->written, num_bones, &manager->allocator);
+            if (c->retarget)
+                corrections_reserve(c, num_bones, &manager->allocator);
+            if (c->mask_mapping != c->mapping || c->mask_generation != c->mapping->generation)
+                mask_build(c, &manager->allocator);
 
-                    tm_transform_t target_transform = tm_scene_tree_component_api->local_transform(stc, node_index);
+            // Puppets entering the lower tiers start over from a fresh copy of the root pose.
+            const uint32_t tier = update_tier(c, transforms ? transforms + i : NULL, reference_transform);
+            if (tier && !c->tier)
+                c->num_keys = 0;
+            c->tier = tier;
+            c->copy = !tier || !c->num_keys || ((manager->frame + c->phase) & ((1u << tier) - 1)) == 0;
+            if (tier) {
+                pose_reserve(&c->keys[0], num_bones, &manager->allocator);
+                pose_reserve(&c->keys[1], num_bones, &manager->allocator);
+            }
+        }
+    }
 
-                    // translate Hips bone only
-                    if (bone_idx == 0) {
-                        target_transform.pos = tm_vec3_element_mul(bind[i].transform_factor, transform.pos);
-                    }
+    for (puppet_root_t *root = manager->roots; root != tm_carray_end(manager->roots); ++root) {
+        if (!root->used)
+            continue;
 
-                    target_transform.rot = tm_vec4_element_mul(bind[i].rotation_factor, transform.rot);
-                    target_transform.scl = tm_vec3_element_mul(bind[i].scale_factor, transform.scl);
+        tm_scene_tree_component_t *root_stc = tm_entity_api->get_component(ctx, root->entity, manager->scene_tree_component);
+        root->valid = root_stc != NULL;
+        if (!root->valid)
+            continue;
 
-                    tm_scene_tree_component_api->set_local_transform(stc, node_index, &target_transform);
-                }
+        const uint32_t num_bones = root->mapping->bones.num_bones;
+        if (!remap_valid(&root->remap, root_stc, root->mapping)) {
+            remap_reserve(&root->remap, num_bones, &manager->allocator);
+            remap_build(&root->remap, root_stc, root->mapping, load_bind_pose(manager, tt, root_stc->scene_tree), false, ++manager->root_remap_version);
+        }
+
+        pose_reserve(&root->pose, num_bones, &manager->allocator);
+        for (uint32_t bone_idx = 0; bone_idx < num_bones; bone_idx++) {
+            const uint32_t root_node_index = root->remap.nodes[bone_idx];
+            if (root_node_index != NODE_NOT_FOUND) {
+                const tm_transform_t transform = tm_scene_tree_component_api->local_transform(root_stc, root_node_index);
+                pose_store(&root->pose, bone_idx, &transform);
+            }
+        }
+    }
+}
+
+// Multiplies the first `n` values of one component of the bones with `factor`.
+static void pose_mul_component(float *out, const float *in, float factor, uint32_t n)
+{
+#if PUPPET_SSE
+    const __m128 f = _mm_set1_ps(factor);
+    for (uint32_t b = 0; b < n; b += 4)
+        _mm_storeu_ps(out + b, _mm_mul_ps(_mm_loadu_ps(in + b), f));
+#else
+    for (uint32_t b = 0; b < n; ++b)
+        out[b] = in[b] * factor;
+#endif
+}
+
+// Computes the rotation that takes each bone of the root from its rest pose to the rest pose of the
+// bone in the puppet: `inverse(root_rest) * puppet_rest`. Applied to the root pose, it gives the
+// puppet's rest pose when the root is in its rest pose.
+static void compute_corrections(tm_animation_puppet_component_t *c, tm_entity_t root, const bone_remap_t *root_remap)
+{
+    const uint32_t num_bones = c->mapping->bones.num_bones;
+    float *corrections[4];
+    for (uint32_t k = 0; k < 4; ++k)
+        corrections[k] = c->corrections + k * c->corrections_capacity;
+
+    for (uint32_t bone_idx = 0; bone_idx < padded_bone_count(num_bones); bone_idx++) {
+        tm_vec4_t q = { 0, 0, 0, 1 };
+        if (bone_idx < num_bones)
+            q = tm_quaternion_mul(tm_quaternion_inverse(root_remap->rest_rot[bone_idx]), c->remap.rest_rot[bone_idx]);
+        corrections[0][bone_idx] = q.x;
+        corrections[1][bone_idx] = q.y;
+        corrections[2][bone_idx] = q.z;
+        corrections[3][bone_idx] = q.w;
+    }
+
+    c->corrected_root = root;
+    c->corrected_root_version = root_remap->version;
+    c->corrected_version = c->remap.version;
+}
+
+// Multiplies the rotations of the first `n` bones of `pose` with the corrections of `c` from the
+// right.
+static void pose_mul_rotations(bone_pose_t *pose, const tm_animation_puppet_component_t *c, uint32_t n)
+{
+    float **r = pose->rot;
+    const float *cx = c->corrections, *cy = cx + c->corrections_capacity, *cz = cy + c->corrections_capacity, *cw = cz + c->corrections_capacity;
+#if PUPPET_SSE
+    for (uint32_t b = 0; b < n; b += 4) {
+        const __m128 ax = _mm_loadu_ps(r[0] + b), ay = _mm_loadu_ps(r[1] + b), az = _mm_loadu_ps(r[2] + b), aw = _mm_loadu_ps(r[3] + b);
+        const __m128 bx = _mm_loadu_ps(cx + b), by = _mm_loadu_ps(cy + b), bz = _mm_loadu_ps(cz + b), bw = _mm_loadu_ps(cw + b);
+        const __m128 x = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(aw, bx), _mm_mul_ps(ax, bw)), _mm_mul_ps(ay, bz)), _mm_mul_ps(az, by));
+        const __m128 y = _mm_add_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(aw, by), _mm_mul_ps(ax, bz)), _mm_mul_ps(ay, bw)), _mm_mul_ps(az, bx));
+        const __m128 z = _mm_add_ps(_mm_sub_ps(_mm_add_ps(_mm_mul_ps(aw, bz), _mm_mul_ps(ax, by)), _mm_mul_ps(ay, bx)), _mm_mul_ps(az, bw));
+        const __m128 w = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_mul_ps(aw, bw), _mm_mul_ps(ax, bx)), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+        _mm_storeu_ps(r[0] + b, x);
+        _mm_storeu_ps(r[1] + b, y);
+        _mm_storeu_ps(r[2] + b, z);
+        _mm_storeu_ps(r[3] + b, w);
+    }
+#else
+    for (uint32_t b = 0; b < n; ++b) {
+        const float ax = r[0][b], ay = r[1][b], az = r[2][b], aw = r[3][b];
+        const float bx = cx[b], by = cy[b], bz = cz[b], bw = cw[b];
+        r[0][b] = aw * bx + ax * bw + ay * bz - az * by;
+        r[1][b] = aw * by - ax * bz + ay * bw + az * bx;
+        r[2][b] = aw * bz + ax * by - ay * bx + az * bw;
+        r[3][b] = aw * bw - ax * bx - ay * by - az * bz;
+    }
+#endif
+}
+
+// Applies the factors of `c` to the first `n` bones of the root pose.
+static void pose_apply_factors(bone_pose_t *out, const bone_pose_t *root, const tm_animation_puppet_component_t *c, uint32_t n)
+{
+    const float *transform_factor = &c->transform_factor.x;
+    const float *rotation_factor = &c->rotation_factor.x;
+    const float *scale_factor = &c->scale_factor.x;
+    for (uint32_t k = 0; k < 3; ++k)
+        pose_mul_component(out->pos[k], root->pos[k], transform_factor[k], n);
+    for (uint32_t k = 0; k < 4; ++k)
+        pose_mul_component(out->rot[k], root->rot[k], rotation_factor[k], n);
+    for (uint32_t k = 0; k < 3; ++k)
+        pose_mul_component(out->scl[k], root->scl[k], scale_factor[k], n);
+}
+
+// Interpolates the first `n` values of one component of the bones from `from` to `to`.
+static void pose_lerp_component(float *out, const float *from, const float *to, float t, uint32_t n)
+{
+#if PUPPET_SSE
+    const __m128 tt = _mm_set1_ps(t);
+    for (uint32_t b = 0; b < n; b += 4) {
+        const __m128 f = _mm_loadu_ps(from + b);
+        _mm_storeu_ps(out + b, _mm_add_ps(f, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(to + b), f), tt)));
+    }
+#else
+    for (uint32_t b = 0; b < n; ++b)
+        out[b] = from[b] + (to[b] - from[b]) * t;
+#endif
+}
+
+// Interpolates the first `n` bones from the pose `from` to the pose `to`. Positions and scales are
+// lerped, rotations are nlerped along the shortest arc.
+static void pose_blend(bone_pose_t *out, const bone_pose_t *from, const bone_pose_t *to, float t, uint32_t n)
+{
+    for (uint32_t k = 0; k < 3; ++k) {
+        pose_lerp_component(out->pos[k], from->pos[k], to->pos[k], t, n);
+        pose_lerp_component(out->scl[k], from->scl[k], to->scl[k], t, n);
+    }
+
+    float *const *r = out->rot;
+    float *const *a = from->rot, *const *q = to->rot;
+#if PUPPET_SSE
+    const __m128 s = _mm_set1_ps(1.0f - t);
+    const __m128 tt = _mm_set1_ps(t);
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 tiny = _mm_set1_ps(1e-12f);
+    for (uint32_t b = 0; b < n; b += 4) {
+        const __m128 ax = _mm_loadu_ps(a[0] + b), ay = _mm_loadu_ps(a[1] + b), az = _mm_loadu_ps(a[2] + b), aw = _mm_loadu_ps(a[3] + b);
+        const __m128 bx = _mm_loadu_ps(q[0] + b), by = _mm_loadu_ps(q[1] + b), bz = _mm_loadu_ps(q[2] + b), bw = _mm_loadu_ps(q[3] + b);
+        const __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_add_ps(_mm_mul_ps(az, bz), _mm_mul_ps(aw, bw)));
+        const __m128 bt = _mm_xor_ps(tt, _mm_and_ps(d, sign));
+        const __m128 x = _mm_add_ps(_mm_mul_ps(ax, s), _mm_mul_ps(bx, bt));
+        const __m128 y = _mm_add_ps(_mm_mul_ps(ay, s), _mm_mul_ps(by, bt));
+        const __m128 z = _mm_add_ps(_mm_mul_ps(az, s), _mm_mul_ps(bz, bt));
+        const __m128 w = _mm_add_ps(_mm_mul_ps(aw, s), _mm_mul_ps(bw, bt));
+        const __m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_add_ps(_mm_mul_ps(z, z), _mm_mul_ps(w, w)));
+        const __m128 inv_len = _mm_div_ps(one, _mm_sqrt_ps(_mm_max_ps(len2, tiny)));
+        _mm_storeu_ps(r[0] + b, _mm_mul_ps(x, inv_len));
+        _mm_storeu_ps(r[1] + b, _mm_mul_ps(y, inv_len));
+        _mm_storeu_ps(r[2] + b, _mm_mul_ps(z, inv_len));
+        _mm_storeu_ps(r[3] + b, _mm_mul_ps(w, inv_len));
+    }
+#else
+    for (uint32_t b = 0; b < n; ++b) {
+        const float d = a[0][b] * q[0][b] + a[1][b] * q[1][b] + a[2][b] * q[2][b] + a[3][b] * q[3][b];
+        const float bt = d < 0.0f ? -t : t;
+        float v[4];
+        for (uint32_t k = 0; k < 4; ++k)
+            v[k] = a[k][b] * (1.0f - t) + q[k][b] * bt;
+        const float len = sqrtf(TM_MAX(v[0] * v[0] + v[1] * v[1] + v[2] * v[2] + v[3] * v[3], 1e-12f));
+        for (uint32_t k = 0; k < 4; ++k)
+            r[k][b] = v[k] / len;
+    }
+#endif
+}
+
+#if PUPPET_SSE
+// Returns the largest of `d` and the difference between `a` and `b` in each lane.
+static inline __m128 max_abs_diff(__m128 d, const float *a, const float *b)
+{
+    const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    return _mm_max_ps(d, _mm_and_ps(_mm_sub_ps(_mm_loadu_ps(a), _mm_loadu_ps(b)), abs_mask));
+}
+#endif
+
+// Sets `changed` to the channels (`enum tm_ig_animation_puppet_channel`) of each of the first `n`
+// bones of `pose` that differ from `written` by more than `CHANGE_TOLERANCE`.
+static void pose_changed_channels(uint8_t *changed, const bone_pose_t *pose, const bone_pose_t *written, uint32_t n)
+{
+#if PUPPET_SSE
+    const __m128 tolerance = _mm_set1_ps(CHANGE_TOLERANCE);
+    for (uint32_t b = 0; b < n; b += 4) {
+        __m128 dp = _mm_setzero_ps(), dr = _mm_setzero_ps(), ds = _mm_setzero_ps();
+        for (uint32_t k = 0; k < 3; ++k) {
+            dp = max_abs_diff(dp, pose->pos[k] + b, written->pos[k] + b);
+            ds = max_abs_diff(ds, pose->scl[k] + b, written->scl[k] + b);
+        }
+        for (uint32_t k = 0; k < 4; ++k)
+            dr = max_abs_diff(dr, pose->rot[k] + b, written->rot[k] + b);
+
+        const int mp = _mm_movemask_ps(_mm_cmpgt_ps(dp, tolerance));
+        const int mr = _mm_movemask_ps(_mm_cmpgt_ps(dr, tolerance));
+        const int ms = _mm_movemask_ps(_mm_cmpgt_ps(ds, tolerance));
+        for (uint32_t j = 0; j < 4; ++j) {
+            changed[b + j] = (uint8_t)((((mp >> j) & 1) ? TM_IG_ANIMATION_PUPPET_CHANNEL_POSITION : 0)
+                | (((mr >> j) & 1) ? TM_IG_ANIMATION_PUPPET_CHANNEL_ROTATION : 0)
+                | (((ms >> j) & 1) ? TM_IG_ANIMATION_PUPPET_CHANNEL_SCALE : 0));
+        }
+    }
+#else
+    for (uint32_t b = 0; b < n; ++b) {
+        float dp = 0.0f, dr = 0.0f, ds = 0.0f;
+        for (uint32_t k = 0; k < 3; ++k) {
+            dp = TM_MAX(dp, fabsf(pose->pos[k][b] - written->pos[k][b]));
+            ds = TM_MAX(ds, fabsf(pose->scl[k][b] - written->scl[k][b]));
+        }
+        for (uint32_t k = 0; k < 4; ++k)
+            dr = TM_MAX(dr, fabsf(pose->rot[k][b] - written->rot[k][b]));
+
+        changed[b] = (uint8_t)((dp > CHANGE_TOLERANCE ? TM_IG_ANIMATION_PUPPET_CHANNEL_POSITION : 0)
+            | (dr > CHANGE_TOLERANCE ? TM_IG_ANIMATION_PUPPET_CHANNEL_ROTATION : 0)
+            | (ds > CHANGE_TOLERANCE ? TM_IG_ANIMATION_PUPPET_CHANNEL_SCALE : 0));
+    }
+#endif
+}
+
+// Copies the root poses to the puppets `first` to `first + n` of an update array. Puppets only
+// write to their own components, so separate ranges can be updated in parallel.
+static void update_puppets(const tm_animation_puppet_component_manager_t *manager, tm_animation_puppet_component_t *bind, tm_scene_tree_component_t *stcs, uint32_t first, uint32_t n)
+{
+    TM_INIT_TEMP_ALLOCATOR(ta);
+    TM_GET_TEMP_ALLOCATOR_ADAPTER(ta, a);
+
+    bone_pose_t pose = { 0 };
+    uint8_t *changed = 0;
+
+    for (uint32_t i = first; i < first + n; ++i) {
+        if (bind[i].root_index == ROOT_NOT_FOUND || !manager->roots[bind[i].root_index].valid || !bind[i].mask_any)
+            continue;
+
+        const puppet_root_t *root = manager->roots + bind[i].root_index;
+        const bone_remap_t *root_remap = &root->remap;
+        const bone_pose_t *root_pose = &root->pose;
+        const bone_mapping_t *bones = &bind[i].mapping->bones;
+        tm_scene_tree_component_t *stc = stcs + i;
+
+        bone_remap_t *remap = &bind[i].remap;
+        if (bind[i].rebuild_remap) {
+            remap_build(remap, stc, bind[i].mapping, bind[i].bind_pose, true, remap->version + 1);
+            bind[i].num_keys = 0;
+            bind[i].written_valid = false;
+        }
+
+        const uint32_t num_bones = bones->num_bones;
+        const uint32_t padded_bones = padded_bone_count(num_bones);
+        pose_reserve(&pose, num_bones, a);
+
+        // Puppets in tier zero copy the root pose every frame. The others copy it to their next key
+        // and interpolate between their last two keys, one key interval behind the root. The
+        // interval between two keys includes the frame the later key is copied on.
+        const bone_pose_t *out = &pose;
+        if (bind[i].tier)
+            bind[i].key_time += manager->dt;
+        if (bind[i].copy || !bind[i].num_keys) {
+            bone_pose_t *target = &pose;
+            if (bind[i].tier) {
+                bind[i].key_index = bind[i].num_keys ? bind[i].key_index ^ 1 : 0;
+                target = bind[i].keys + bind[i].key_index;
+            }
+
+            pose_apply_factors(target, root_pose, bind + i, padded_bones);
+            if (bind[i].retarget) {
+                if (bind[i].corrected_root.u64 != root->entity.u64 || bind[i].corrected_root_version != root_remap->version || bind[i].corrected_version != remap->version)
+                    compute_corrections(bind + i, root->entity, root_remap);
+                pose_mul_rotations(target, bind + i, padded_bones);
+            }
+
+            if (bind[i].tier) {
+                bind[i].key_duration = bind[i].key_time;
+                bind[i].key_time = 0.0f;
+                bind[i].num_keys = TM_MIN(bind[i].num_keys + 1, 2);
             }
         }
+
+        if (bind[i].tier) {
+            const bone_pose_t *latest = bind[i].keys + bind[i].key_index;
+            out = latest;
+            if (bind[i].num_keys == 2) {
+                const float t = bind[i].key_duration > 0.0f ? TM_MIN(bind[i].key_time / bind[i].key_duration, 1.0f) : 1.0f;
+                pose_blend(&pose, bind[i].keys + (bind[i].key_index ^ 1), latest, t, padded_bones);
+                out = &pose;
+            }
+        }
+
+        // Only the channels that moved since they were last written are written again, so that
+        // idle bones don't dirty the transforms of the scene tree. Skipped bones keep their last
+        // written transform, so slow drifts are still written once they exceed the tolerance.
+        bone_pose_t *written = &bind[i].written;
+        tm_carray_temp_resize(changed, padded_bones, ta);
+        if (bind[i].written_valid && bind[i].written_root_version == root_remap->version)
+            pose_changed_channels(changed, out, written, padded_bones);
+        else
+            memset(changed, TM_IG_ANIMATION_PUPPET_CHANNEL_ALL, padded_bones);
+
+        // Only the bones in the mask are visited.
+        for (uint32_t word = 0; word < (num_bones + 63) / 64; ++word) {
+            for (uint64_t bits = bind[i].mask[word]; bits; bits &= bits - 1) {
+                const uint32_t bone_idx = word * 64 + lowest_bit(bits);
+                const uint32_t node_index = remap->nodes[bone_idx];
+                const uint32_t channels = bones->channels[bone_idx] & TM_IG_ANIMATION_PUPPET_CHANNEL_ALL;
+                if (root_remap->nodes[bone_idx] == NODE_NOT_FOUND || node_index == NODE_NOT_FOUND || !(channels & changed[bone_idx]))
+                    continue;
+
+                // The channels that aren't copied keep the puppet's own transform.
+                tm_transform_t target_transform;
+                if (channels != TM_IG_ANIMATION_PUPPET_CHANNEL_ALL)
+                    target_transform = tm_scene_tree_component_api->local_transform(stc, node_index);
+
+                if (channels & TM_IG_ANIMATION_PUPPET_CHANNEL_POSITION)
+                    target_transform.pos = (tm_vec3_t){ out->pos[0][bone_idx], out->pos[1][bone_idx], out->pos[2][bone_idx] };
+                if (channels & TM_IG_ANIMATION_PUPPET_CHANNEL_ROTATION)
+                    target_transform.rot = (tm_vec4_t){ out->rot[0][bone_idx], out->rot[1][bone_idx], out->rot[2][bone_idx], out->rot[3][bone_idx] };
+                if (channels & TM_IG_ANIMATION_PUPPET_CHANNEL_SCALE)
+                    target_transform.scl = (tm_vec3_t){ out->scl[0][bone_idx], out->scl[1][bone_idx], out->scl[2][bone_idx] };
+
+                tm_scene_tree_component_api->set_local_transform(stc, node_index, &target_transform);
+                pose_store(written, bone_idx, &target_transform);
+            }
+        }
+        bind[i].written_valid = true;
+        bind[i].written_root_version = root_remap->version;
     }
+
+    TM_SHUTDOWN_TEMP_ALLOCATOR(ta);
+}
+
+typedef struct update_puppets_job_t
+{
+    const tm_animation_puppet_component_manager_t *manager;
+    tm_animation_puppet_component_t *bind;
+    tm_scene_tree_component_t *stcs;
+    uint32_t first;
+    uint32_t n;
+} update_puppets_job_t;
+
+static void update_puppets_job(void *data)
+{
+    update_puppets_job_t *job = data;
+    update_puppets(job->manager, job->bind, job->stcs, job->first, job->n);
+}
+
+static void engine_update__bind(tm_engine_o *inst, tm_engine_update_set_t *data)
+{
+    tm_animation_puppet_component_manager_t *manager = (tm_animation_puppet_component_manager_t *)inst;
+
+    float dt = 1.0f / 60.0f;
+    for (const tm_entity_blackboard_value_t *bb = data->blackboard_start; bb != data->blackboard_end; ++bb) {
+        if (bb->id == TM_ENTITY_BB__DELTA_TIME)
+            dt = (float)bb->double_value;
+    }
+    manager->dt = dt;
+
+    update_roots(manager, data);
+    ++manager->frame;
+
+    if (data->total_entities <= PUPPETS_PER_JOB) {
+        for (tm_engine_update_array_t *update_array = data->arrays; update_array < data->arrays + data->num_arrays; ++update_array) {
+            if (update_array->components[1])
+                update_puppets(manager, update_array->components[0], update_array->components[1], 0, update_array->n);
+        }
+        return;
+    }
+
+    TM_INIT_TEMP_ALLOCATOR(ta);
+
+    update_puppets_job_t *puppet_jobs = 0;
+    tm_jobdecl_t *jobs = 0;
+    for (tm_engine_update_array_t *update_array = data->arrays; update_array < data->arrays + data->num_arrays; ++update_array) {
+        if (!update_array->components[1])
+            continue;
+
+        for (uint32_t first = 0; first < update_array->n; first += PUPPETS_PER_JOB) {
+            const update_puppets_job_t job = {
+                .manager = manager,
+                .bind = update_array->components[0],
+                .stcs = update_array->components[1],
+                .first = first,
+                .n = TM_MIN(PUPPETS_PER_JOB, update_array->n - first),
+            };
+            tm_carray_temp_push(puppet_jobs, job, ta);
+        }
+    }
+
+    const uint32_t num_jobs = (uint32_t)tm_carray_size(puppet_jobs);
+    tm_carray_temp_resize(jobs, num_jobs, ta);
+    for (uint32_t i = 0; i < num_jobs; ++i)
+        jobs[i] = (tm_jobdecl_t){ .task = update_puppets_job, .data = puppet_jobs + i };
+    if (num_jobs)
+        tm_job_system_api->wait_for_counter_and_free(tm_job_system_api->run_jobs(jobs, num_jobs));
+
+    TM_SHUTDOWN_TEMP_ALLOCATOR(ta);
 }
 
 static bool engine_filter__bind(tm_engine_o *inst, const tm_component_type_t *components, uint32_t num_components, const tm_component_mask_t *mask)
@@ -248,17 +1422,23 @@ static void component__register_engine(struct tm_entity_context_o *ctx)
     const tm_component_type_t anim_component = tm_entity_api->lookup_component_type(ctx, TM_TT_TYPE_HASH__IG_ANIMATION_PUPPET);
     const tm_component_type_t scene_tree_component = tm_entity_api->lookup_component_type(ctx, TM_TT_TYPE_HASH__SCENE_TREE_COMPONENT);
     const tm_component_type_t tag_component = tm_entity_api->lookup_component_type(ctx, TM_TT_TYPE_HASH__TAG_COMPONENT);
+    const tm_component_type_t transform_component = tm_entity_api->lookup_component_type(ctx, TM_TT_TYPE_HASH__TRANSFORM_COMPONENT);
 
     tm_tag_component_manager = (tm_tag_component_manager_o *)tm_entity_api->component_manager(ctx, tag_component);
+    tm_animation_puppet_component_manager_t *manager = (tm_animation_puppet_component_manager_t *)tm_entity_api->component_manager(ctx, anim_component);
+    manager->scene_tree_component = scene_tree_component;
+    manager->tag_component = tag_component;
+    manager->transform_component = transform_component;
+    manager->tag_manager = tm_tag_component_manager;
 
     const tm_engine_i animation_puppet_engine = {
         .name = TM_LOCALIZE_LATER("Puppet Animation"),
-        .num_components = 3,
-        .components = { anim_component, scene_tree_component, tag_component },
-        .writes = { false, true, true },
+        .num_components = 4,
+        .components = { anim_component, scene_tree_component, tag_component, transform_component },
+        .writes = { true, true, true, false },
         .update = engine_update__bind,
         .filter = engine_filter__bind,
-        .inst = (tm_engine_o *)ctx,
+        .inst = (tm_engine_o *)manager,
     };
     tm_entity_api->register_engine(ctx, &animation_puppet_engine);
 }
@@ -273,8 +1453,10 @@ TM_DLL_EXPORT void tm_load_plugin(struct tm_api_registry_api *reg, bool load)
     tm_logger_api = reg->get(TM_LOGGER_API_NAME);
     tm_scene_tree_component_api = reg->get(TM_SCENE_TREE_COMPONENT_API_NAME);
     tm_tag_component_api = reg->get(TM_TAG_COMPONENT_API_NAME);
+    tm_job_system_api = reg->get(TM_JOB_SYSTEM_API_NAME);
 
     tm_add_or_remove_implementation(reg, load, TM_THE_TRUTH_CREATE_TYPES_INTERFACE_NAME, component__create_types);
     tm_add_or_remove_implementation(reg, load, TM_ENTITY_CREATE_COMPONENT_INTERFACE_NAME, component__create);
     tm_add_or_remove_implementation(reg, load, TM_ENTITY_SIMULATION_INTERFACE_NAME, component__register_engine);
+    tm_add_or_remove_implementation(reg, load, TM_ASSET_BROWSER_CREATE_ASSET_INTERFACE_NAME, &asset_browser_create_bone_mapping);
 }
@@ -5,8 +5,56 @@
 #define TM_TT_TYPE__IG_ANIMATION_PUPPET "tm_ig_animation_puppet"
 #define TM_TT_TYPE_HASH__IG_ANIMATION_PUPPET TM_STATIC_HASH("tm_ig_animation_puppet",  0x417d8f2cd6fd4f98ULL)
 
+#define TM_TT_TYPE__IG_ANIMATION_PUPPET_BONE_MAPPING "tm_ig_animation_puppet_bone_mapping"
+#define TM_TT_TYPE_HASH__IG_ANIMATION_PUPPET_BONE_MAPPING TM_STATIC_HASH("tm_ig_animation_puppet_bone_mapping", 0xe8fc3dc30c551206ULL)
+
+#define TM_TT_TYPE__IG_ANIMATION_PUPPET_BONE "tm_ig_animation_puppet_bone"
+#define TM_TT_TYPE_HASH__IG_ANIMATION_PUPPET_BONE TM_STATIC_HASH("tm_ig_animation_puppet_bone", 0x65058fa3335f6f4dULL)
+
+#define TM_TT_TYPE__IG_ANIMATION_PUPPET_MASK_BONE "tm_ig_animation_puppet_mask_bone"
+#define TM_TT_TYPE_HASH__IG_ANIMATION_PUPPET_MASK_BONE TM_STATIC_HASH("tm_ig_animation_puppet_mask_bone", 0x3b8d6dcb2653ec5cULL)
+
 enum {
     TM_TT_PROP__IG_ANIMATION_PUPPET__POSITION_FACTOR, // subobject(TM_TT_TYPE__POSITION)
     TM_TT_PROP__IG_ANIMATION_PUPPET__ROTATION_FACTOR, // subobject(TM_TT_TYPE__ROTATION)
     TM_TT_PROP__IG_ANIMATION_PUPPET__SCALE_FACTOR,    // subobject(TM_TT_TYPE__SCALE)
+    TM_TT_PROP__IG_ANIMATION_PUPPET__ROOT,            // reference(TM_TT_TYPE__ENTITY)
+    TM_TT_PROP__IG_ANIMATION_PUPPET__RETARGET,        // bool
+    TM_TT_PROP__IG_ANIMATION_PUPPET__MAPPING,         // reference(TM_TT_TYPE__IG_ANIMATION_PUPPET_BONE_MAPPING)
+    // Lowest update tier of the puppet. A puppet in tier N copies the root pose every 2^N frames and
+    // interpolates between the last two copied poses in between.
+    TM_TT_PROP__IG_ANIMATION_PUPPET__UPDATE_TIER,     // uint32_t
+    // Distance to the entity tagged `tm_ig_animation_puppet_lod_reference` (e.g. the camera) after
+    // which the puppet drops one update tier. Zero to only use the update tier.
+    TM_TT_PROP__IG_ANIMATION_PUPPET__TIER_DISTANCE,   // float
+    // Bones written by the puppet. If empty, the puppet writes all the bones of its mapping.
+    TM_TT_PROP__IG_ANIMATION_PUPPET__MASK,            // subobject_set(TM_TT_TYPE__IG_ANIMATION_PUPPET_MASK_BONE)
+    // If set, the puppet writes all the bones except the ones in the mask.
+    TM_TT_PROP__IG_ANIMATION_PUPPET__MASK_EXCLUDE,    // bool
+};
+
+// Bone mapping asset. Puppets without a mapping use the built-in mapping of the Mixamo skeleton.
+enum {
+    TM_TT_PROP__IG_ANIMATION_PUPPET_BONE_MAPPING__BONES, // subobject_set(TM_TT_TYPE__IG_ANIMATION_PUPPET_BONE)
+};
+
+enum {
+    // Name of the bone in the scene tree of the root.
+    TM_TT_PROP__IG_ANIMATION_PUPPET_BONE__ROOT_NAME,   // string
+    // Name of the bone in the scene tree of the puppet, if it isn't found by its root name.
+    TM_TT_PROP__IG_ANIMATION_PUPPET_BONE__TARGET_NAME, // string
+    TM_TT_PROP__IG_ANIMATION_PUPPET_BONE__CHANNELS,    // uint32_t (enum tm_ig_animation_puppet_channel)
+};
+
+enum {
+    // Root or target name of the bone in the bone mapping.
+    TM_TT_PROP__IG_ANIMATION_PUPPET_MASK_BONE__NAME, // string
+};
+
+// Flags for the parts of the local transform of a bone copied from the root to the puppet.
+enum tm_ig_animation_puppet_channel {
+    TM_IG_ANIMATION_PUPPET_CHANNEL_POSITION = 0x1,
+    TM_IG_ANIMATION_PUPPET_CHANNEL_ROTATION = 0x2,
+    TM_IG_ANIMATION_PUPPET_CHANNEL_SCALE = 0x4,
+    TM_IG_ANIMATION_PUPPET_CHANNEL_ALL = 0x7,
 };
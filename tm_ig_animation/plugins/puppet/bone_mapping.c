@@ -0,0 +1,181 @@
+#include "bone_mapping.h"
+
+#include <foundation/allocator.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+// Average number of names in each bucket of the perfect hash.
+#define NAMES_PER_BUCKET 4
+
+// Number of seeds tried for a bucket before giving up and retrying with more slots.
+#define MAX_SEEDS 4096
+
+typedef struct hashed_name_t
+{
+    uint64_t name;
+    uint32_t bone;
+    uint32_t bucket;
+    uint32_t bucket_size;
+    uint32_t reserved;
+} hashed_name_t;
+
+static inline uint32_t bucket_hash(uint64_t name, uint32_t num_buckets)
+{
+    return (uint32_t)((name ^ (name >> 32)) % num_buckets);
+}
+
+static inline uint32_t slot_hash(uint64_t name, uint32_t seed, uint32_t num_slots)
+{
+    uint64_t h = name ^ ((uint64_t)seed * 0x9e3779b97f4a7c15ULL);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return (uint32_t)(h % num_slots);
+}
+
+static int compare_by_name(const void *a, const void *b)
+{
+    const hashed_name_t *x = a, *y = b;
+    if (x->name != y->name)
+        return x->name < y->name ? -1 : 1;
+    return x->bone < y->bone ? -1 : x->bone > y->bone;
+}
+
+// Largest buckets first, since they are the hardest to place.
+static int compare_by_bucket(const void *a, const void *b)
+{
+    const hashed_name_t *x = a, *y = b;
+    if (x->bucket_size != y->bucket_size)
+        return x->bucket_size > y->bucket_size ? -1 : 1;
+    return x->bucket < y->bucket ? -1 : x->bucket > y->bucket;
+}
+
+// Allocates the arrays of `mapping` for `num_bones` bones and the current number of buckets and
+// slots.
+static void allocate_arrays(bone_mapping_t *mapping, uint32_t num_bones, struct tm_allocator_i *allocator)
+{
+    const uint64_t n = num_bones, buckets = mapping->num_buckets, slots = mapping->num_slots;
+    mapping->data_size = (2 * n + slots) * sizeof(uint64_t) + (n + buckets + slots) * sizeof(uint32_t);
+    mapping->data = tm_alloc(allocator, mapping->data_size);
+    mapping->num_bones = num_bones;
+    mapping->root_names = mapping->data;
+    mapping->target_names = mapping->root_names + n;
+    mapping->slot_names = mapping->target_names + n;
+    mapping->channels = (uint32_t *)(mapping->slot_names + slots);
+    mapping->seeds = mapping->channels + n;
+    mapping->slot_bones = mapping->seeds + buckets;
+
+    memset(mapping->seeds, 0, buckets * sizeof(uint32_t));
+    memset(mapping->slot_names, 0, slots * sizeof(uint64_t));
+    memset(mapping->slot_bones, 0xff, slots * sizeof(uint32_t));
+}
+
+// Finds a seed for each bucket so that all the names land in separate slots. Returns false if a
+// bucket couldn't be placed.
+static bool place_buckets(bone_mapping_t *mapping, const hashed_name_t *names, uint32_t num_names)
+{
+    uint32_t bucket_slots[64];
+    for (uint32_t first = 0; first < num_names;) {
+        const uint32_t bucket = names[first].bucket;
+        uint32_t last = first;
+        while (last < num_names && names[last].bucket == bucket)
+            ++last;
+        if (last - first > sizeof(bucket_slots) / sizeof(bucket_slots[0]))
+            return false;
+
+        bool placed = false;
+        for (uint32_t seed = 0; seed < MAX_SEEDS && !placed; ++seed) {
+            placed = true;
+            for (uint32_t i = first; i < last && placed; ++i) {
+                const uint32_t slot = slot_hash(names[i].name, seed, mapping->num_slots);
+                placed = mapping->slot_bones[slot] == BONE_MAPPING_NOT_FOUND;
+                for (uint32_t j = first; j < i && placed; ++j)
+                    placed = bucket_slots[j - first] != slot;
+                bucket_slots[i - first] = slot;
+            }
+            if (placed) {
+                mapping->seeds[bucket] = seed;
+                for (uint32_t i = first; i < last; ++i) {
+                    mapping->slot_bones[bucket_slots[i - first]] = names[i].bone;
+                    mapping->slot_names[bucket_slots[i - first]] = names[i].name;
+                }
+            }
+        }
+        if (!placed)
+            return false;
+        first = last;
+    }
+    return true;
+}
+
+void bone_mapping_create(bone_mapping_t *mapping, const uint64_t *root_names, const uint64_t *target_names,
+    const uint32_t *channels, uint32_t num_bones, struct tm_allocator_i *allocator)
+{
+    *mapping = (bone_mapping_t){ 0 };
+
+    // Both names of each bone, with the duplicates removed.
+    const uint64_t names_size = 2 * (uint64_t)num_bones * sizeof(hashed_name_t) + sizeof(hashed_name_t);
+    hashed_name_t *names = tm_alloc(allocator, names_size);
+    uint32_t num_names = 0;
+    for (uint32_t i = 0; i < num_bones; ++i) {
+        names[num_names++] = (hashed_name_t){ .name = root_names[i], .bone = i };
+        if (target_names[i] != root_names[i])
+            names[num_names++] = (hashed_name_t){ .name = target_names[i], .bone = i };
+    }
+    qsort(names, num_names, sizeof(*names), compare_by_name);
+    uint32_t num_unique = 0;
+    for (uint32_t i = 0; i < num_names; ++i) {
+        if (!num_unique || names[num_unique - 1].name != names[i].name)
+            names[num_unique++] = names[i];
+    }
+
+    mapping->num_buckets = (num_unique + NAMES_PER_BUCKET - 1) / NAMES_PER_BUCKET;
+    mapping->num_buckets = mapping->num_buckets ? mapping->num_buckets : 1;
+    mapping->num_slots = num_unique + num_unique / 4 + 1;
+    while (true) {
+        allocate_arrays(mapping, num_bones, allocator);
+
+        for (uint32_t i = 0; i < num_unique; ++i) {
+            names[i].bucket = bucket_hash(names[i].name, mapping->num_buckets);
+            names[i].bucket_size = 0;
+        }
+        for (uint32_t i = 0; i < num_unique; ++i)
+            mapping->seeds[names[i].bucket]++;
+        for (uint32_t i = 0; i < num_unique; ++i)
+            names[i].bucket_size = mapping->seeds[names[i].bucket];
+        memset(mapping->seeds, 0, mapping->num_buckets * sizeof(uint32_t));
+        qsort(names, num_unique, sizeof(*names), compare_by_bucket);
+
+        if (place_buckets(mapping, names, num_unique))
+            break;
+
+        tm_free(allocator, mapping->data, mapping->data_size);
+        mapping->num_buckets += mapping->num_buckets / 4 + 1;
+        mapping->num_slots += num_unique / 4 + 1;
+    }
+
+    memcpy(mapping->root_names, root_names, num_bones * sizeof(uint64_t));
+    memcpy(mapping->target_names, target_names, num_bones * sizeof(uint64_t));
+    memcpy(mapping->channels, channels, num_bones * sizeof(uint32_t));
+
+    tm_free(allocator, names, names_size);
+}
+
+void bone_mapping_destroy(bone_mapping_t *mapping, struct tm_allocator_i *allocator)
+{
+    tm_free(allocator, mapping->data, mapping->data_size);
+    *mapping = (bone_mapping_t){ 0 };
+}
+
+uint32_t bone_mapping_find(const bone_mapping_t *mapping, uint64_t name)
+{
+    if (!mapping->num_slots)
+        return BONE_MAPPING_NOT_FOUND;
+
+    const uint32_t seed = mapping->seeds[bucket_hash(name, mapping->num_buckets)];
+    const uint32_t slot = slot_hash(name, seed, mapping->num_slots);
+    return mapping->slot_names[slot] == name ? mapping->slot_bones[slot] : BONE_MAPPING_NOT_FOUND;
+}
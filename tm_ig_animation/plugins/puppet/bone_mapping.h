@@ -0,0 +1,54 @@
+#pragma once
+
+#include <foundation/api_types.h>
+
+struct tm_allocator_i;
+
+// Bone mappings compiled from the Truth to flat arrays, with a perfect hash from bone names to bones.
+
+#define BONE_MAPPING_NOT_FOUND UINT32_MAX
+
+typedef struct bone_mapping_t
+{
+    uint32_t num_bones;
+
+    // Number of buckets and slots of the perfect hash.
+    uint32_t num_buckets;
+    uint32_t num_slots;
+    uint32_t reserved;
+
+    // Name hash of each bone in the scene tree of the root.
+    uint64_t *root_names;
+
+    // Name hash of each bone in the scene tree of the puppet, used if the bone isn't found by its
+    // root name.
+    uint64_t *target_names;
+
+    // Channels (`enum tm_ig_animation_puppet_channel`) copied for each bone.
+    uint32_t *channels;
+
+    // Seed of each bucket of the perfect hash, picked so that the names in the bucket end up in
+    // free slots.
+    uint32_t *seeds;
+
+    // Bone index and name hash stored in each slot, BONE_MAPPING_NOT_FOUND and 0 for empty slots.
+    uint32_t *slot_bones;
+    uint64_t *slot_names;
+
+    // Single allocation holding all the arrays.
+    void *data;
+    uint64_t data_size;
+} bone_mapping_t;
+
+// Compiles the `num_bones` bones described by `root_names`, `target_names` and `channels`. Both
+// the root and the target name of each bone are added to the perfect hash. If the same name is
+// used for more than one bone, `bone_mapping_find()` returns the first of them.
+void bone_mapping_create(bone_mapping_t *mapping, const uint64_t *root_names, const uint64_t *target_names,
+    const uint32_t *channels, uint32_t num_bones, struct tm_allocator_i *allocator);
+
+// Frees the arrays of `mapping`.
+void bone_mapping_destroy(bone_mapping_t *mapping, struct tm_allocator_i *allocator);
+
+// Returns the index of the bone with the root or target name `name`, BONE_MAPPING_NOT_FOUND if
+// there is none. A single probe, no matter how many bones the mapping has.
+uint32_t bone_mapping_find(const bone_mapping_t *mapping, uint64_t name);
@@ -0,0 +1,629 @@
+#include "bc_encoder.h"
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define BC_ENCODER_SSE 1
+#include <emmintrin.h>
+#endif
+
+// Texels of a 4 x 4 block, one array per channel.
+typedef struct block_t
+{
+	float c[4][16];
+} block_t;
+
+// Colors that the indices of a block decode to.
+typedef struct palette_t
+{
+	float c[16][4];
+	uint32_t size;
+} palette_t;
+
+uint32_t bc_block_size(enum bc_format format)
+{
+	return format == BC_FORMAT_BC1 ? 8 : 16;
+}
+
+uint64_t bc_image_size(enum bc_format format, uint32_t width, uint32_t height)
+{
+	return (uint64_t)((width + 3) / 4) * ((height + 3) / 4) * bc_block_size(format);
+}
+
+static inline float clamp_255(float v)
+{
+	return v < 0.0f ? 0.0f : v > 255.0f ? 255.0f : v;
+}
+
+static void load_block(block_t *b, const uint8_t *rgba, uint32_t width, uint32_t height, uint32_t block_x, uint32_t block_y)
+{
+	for (uint32_t y = 0; y < 4; ++y) {
+		const uint32_t sy = block_y * 4 + y < height ? block_y * 4 + y : height - 1;
+		for (uint32_t x = 0; x < 4; ++x) {
+			const uint32_t sx = block_x * 4 + x < width ? block_x * 4 + x : width - 1;
+			const uint8_t *t = rgba + ((uint64_t)sy * width + sx) * 4;
+			for (uint32_t c = 0; c < 4; ++c)
+				b->c[c][y * 4 + x] = (float)t[c];
+		}
+	}
+}
+
+// Assigns each texel of `b` to the closest entry of `palette`, comparing the first `channels`
+// channels. Returns the summed squared error.
+static float assign_indices(const block_t *b, uint32_t channels, const palette_t *palette, uint8_t *indices)
+{
+#if BC_ENCODER_SSE
+	__m128 total = _mm_setzero_ps();
+	for (uint32_t i = 0; i < 16; i += 4) {
+		__m128 best = _mm_set1_ps(FLT_MAX);
+		__m128i best_index = _mm_setzero_si128();
+		for (uint32_t k = 0; k < palette->size; ++k) {
+			__m128 d2 = _mm_setzero_ps();
+			for (uint32_t c = 0; c < channels; ++c) {
+				const __m128 d = _mm_sub_ps(_mm_loadu_ps(b->c[c] + i), _mm_set1_ps(palette->c[k][c]));
+				d2 = _mm_add_ps(d2, _mm_mul_ps(d, d));
+			}
+			const __m128i closer = _mm_castps_si128(_mm_cmplt_ps(d2, best));
+			best = _mm_min_ps(d2, best);
+			best_index = _mm_or_si128(_mm_andnot_si128(closer, best_index), _mm_and_si128(closer, _mm_set1_epi32((int32_t)k)));
+		}
+		total = _mm_add_ps(total, best);
+
+		int32_t index[4];
+		_mm_storeu_si128((__m128i *)index, best_index);
+		for (uint32_t j = 0; j < 4; ++j)
+			indices[i + j] = (uint8_t)index[j];
+	}
+	float sum[4];
+	_mm_storeu_ps(sum, total);
+	return sum[0] + sum[1] + sum[2] + sum[3];
+#else
+	float total = 0.0f;
+	for (uint32_t i = 0; i < 16; ++i) {
+		float best = FLT_MAX;
+		for (uint32_t k = 0; k < palette->size; ++k) {
+			float d2 = 0.0f;
+			for (uint32_t c = 0; c < channels; ++c) {
+				const float d = b->c[c][i] - palette->c[k][c];
+				d2 += d * d;
+			}
+			if (d2 < best) {
+				best = d2;
+				indices[i] = (uint8_t)k;
+			}
+		}
+		total += best;
+	}
+	return total;
+#endif
+}
+
+// Fits a line through the texels of `b` and returns the extent of the texels along it as `e0` and
+// `e1`.
+static void principal_axis_endpoints(const block_t *b, uint32_t channels, float *e0, float *e1)
+{
+	float mean[4] = { 0 };
+	for (uint32_t c = 0; c < channels; ++c) {
+		for (uint32_t i = 0; i < 16; ++i)
+			mean[c] += b->c[c][i];
+		mean[c] *= 1.0f / 16.0f;
+	}
+
+	float cov[4][4] = { 0 };
+	for (uint32_t i = 0; i < 16; ++i) {
+		float d[4];
+		for (uint32_t c = 0; c < channels; ++c)
+			d[c] = b->c[c][i] - mean[c];
+		for (uint32_t c = 0; c < channels; ++c) {
+			for (uint32_t k = c; k < channels; ++k)
+				cov[c][k] += d[c] * d[k];
+		}
+	}
+	for (uint32_t c = 0; c < channels; ++c) {
+		for (uint32_t k = 0; k < c; ++k)
+			cov[c][k] = cov[k][c];
+	}
+
+	// Power iteration for the eigenvector with the largest eigenvalue, starting from the channel
+	// with the largest variance.
+	float axis[4] = { 0 };
+	uint32_t largest = 0;
+	for (uint32_t c = 1; c < channels; ++c)
+		largest = cov[c][c] > cov[largest][largest] ? c : largest;
+	for (uint32_t c = 0; c < channels; ++c)
+		axis[c] = cov[largest][c];
+	for (uint32_t iteration = 0; iteration < 8; ++iteration) {
+		float v[4] = { 0 };
+		float scale = 0.0f;
+		for (uint32_t c = 0; c < channels; ++c) {
+			for (uint32_t k = 0; k < channels; ++k)
+				v[c] += cov[c][k] * axis[k];
+			scale = fabsf(v[c]) > scale ? fabsf(v[c]) : scale;
+		}
+		if (scale < FLT_MIN)
+			break;
+		for (uint32_t c = 0; c < channels; ++c)
+			axis[c] = v[c] / scale;
+	}
+
+	float length = 0.0f;
+	for (uint32_t c = 0; c < channels; ++c)
+		length += axis[c] * axis[c];
+	if (length < 1e-8f) {
+		memcpy(e0, mean, sizeof(mean));
+		memcpy(e1, mean, sizeof(mean));
+		return;
+	}
+	length = 1.0f / sqrtf(length);
+	for (uint32_t c = 0; c < channels; ++c)
+		axis[c] *= length;
+
+	float t_min = FLT_MAX, t_max = -FLT_MAX;
+	for (uint32_t i = 0; i < 16; ++i) {
+		float t = 0.0f;
+		for (uint32_t c = 0; c < channels; ++c)
+			t += (b->c[c][i] - mean[c]) * axis[c];
+		t_min = t < t_min ? t : t_min;
+		t_max = t > t_max ? t : t_max;
+	}
+	for (uint32_t c = 0; c < channels; ++c) {
+		e0[c] = clamp_255(mean[c] + axis[c] * t_min);
+		e1[c] = clamp_255(mean[c] + axis[c] * t_max);
+	}
+}
+
+// Solves for the end points that minimize the squared error of the texels, given the
+// interpolation weight (0 at `e0`, 1 at `e1`) of each index. Returns false if all texels use the
+// same weight.
+static bool least_squares_endpoints(const block_t *b, uint32_t channels, const uint8_t *indices, const float *weights, float *e0, float *e1)
+{
+	float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+	float ax[4] = { 0 }, bx[4] = { 0 };
+	for (uint32_t i = 0; i < 16; ++i) {
+		const float w = weights[indices[i]];
+		const float a = 1.0f - w;
+		aa += a * a;
+		ab += a * w;
+		bb += w * w;
+		for (uint32_t c = 0; c < channels; ++c) {
+			ax[c] += a * b->c[c][i];
+			bx[c] += w * b->c[c][i];
+		}
+	}
+
+	const float det = aa * bb - ab * ab;
+	if (fabsf(det) < 1e-6f)
+		return false;
+
+	const float inv_det = 1.0f / det;
+	for (uint32_t c = 0; c < channels; ++c) {
+		e0[c] = clamp_255((ax[c] * bb - bx[c] * ab) * inv_det);
+		e1[c] = clamp_255((bx[c] * aa - ax[c] * ab) * inv_det);
+	}
+	return true;
+}
+
+static inline uint32_t refinement_iterations(enum bc_quality quality)
+{
+	return quality == BC_QUALITY_FAST ? 0 : quality == BC_QUALITY_NORMAL ? 1 : 4;
+}
+
+// BC1
+
+// Interpolation weight of the BC1 indices in four color mode.
+static const float bc1_weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+static uint16_t pack_565(const float *c)
+{
+	const uint32_t r = (uint32_t)(clamp_255(c[0]) * (31.0f / 255.0f) + 0.5f);
+	const uint32_t g = (uint32_t)(clamp_255(c[1]) * (63.0f / 255.0f) + 0.5f);
+	const uint32_t b = (uint32_t)(clamp_255(c[2]) * (31.0f / 255.0f) + 0.5f);
+	return (uint16_t)(r << 11 | g << 5 | b);
+}
+
+static void unpack_565(uint16_t v, float *c)
+{
+	const uint32_t r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+	c[0] = (float)(r << 3 | r >> 2);
+	c[1] = (float)(g << 2 | g >> 4);
+	c[2] = (float)(b << 3 | b >> 2);
+}
+
+// Quantizes the end points and assigns the texels to the closest color. The colors are ordered so
+// that the block decodes in four color mode. Returns the squared error.
+static float bc1_evaluate(const block_t *b, const float *e0, const float *e1, uint16_t *q, uint8_t *indices)
+{
+	uint16_t q0 = pack_565(e0), q1 = pack_565(e1);
+	if (q0 < q1) {
+		const uint16_t t = q0;
+		q0 = q1;
+		q1 = t;
+	}
+	q[0] = q0;
+	q[1] = q1;
+
+	// With equal end points the block decodes in three color mode, where only index 0 is valid.
+	palette_t palette = { .size = q0 == q1 ? 1 : 4 };
+	unpack_565(q0, palette.c[0]);
+	unpack_565(q1, palette.c[1]);
+	for (uint32_t c = 0; c < 3; ++c) {
+		palette.c[2][c] = (2.0f * palette.c[0][c] + palette.c[1][c]) * (1.0f / 3.0f);
+		palette.c[3][c] = (palette.c[0][c] + 2.0f * palette.c[1][c]) * (1.0f / 3.0f);
+	}
+	return assign_indices(b, 3, &palette, indices);
+}
+
+static void encode_bc1(uint8_t *out, const block_t *b, enum bc_quality quality)
+{
+	float e0[4], e1[4];
+	principal_axis_endpoints(b, 3, e0, e1);
+
+	uint16_t q[2];
+	uint8_t indices[16];
+	float error = bc1_evaluate(b, e0, e1, q, indices);
+
+	const uint32_t iterations = refinement_iterations(quality);
+	for (uint32_t i = 0; i < iterations && error > 0.0f; ++i) {
+		if (!least_squares_endpoints(b, 3, indices, bc1_weights, e0, e1))
+			break;
+		uint16_t refined_q[2];
+		uint8_t refined_indices[16];
+		const float refined_error = bc1_evaluate(b, e0, e1, refined_q, refined_indices);
+		if (refined_error >= error)
+			break;
+		error = refined_error;
+		memcpy(q, refined_q, sizeof(q));
+		memcpy(indices, refined_indices, sizeof(indices));
+	}
+
+	uint32_t bits = 0;
+	for (uint32_t i = 0; i < 16; ++i)
+		bits |= (uint32_t)indices[i] << (i * 2);
+	out[0] = (uint8_t)q[0];
+	out[1] = (uint8_t)(q[0] >> 8);
+	out[2] = (uint8_t)q[1];
+	out[3] = (uint8_t)(q[1] >> 8);
+	for (uint32_t i = 0; i < 4; ++i)
+		out[4 + i] = (uint8_t)(bits >> (i * 8));
+}
+
+// BC4
+
+static float bc4_evaluate(const block_t *b, uint32_t e0, uint32_t e1, uint8_t *indices)
+{
+	palette_t palette = { .size = 8 };
+	palette.c[0][0] = (float)e0;
+	palette.c[1][0] = (float)e1;
+	if (e0 > e1) {
+		for (uint32_t i = 1; i < 7; ++i)
+			palette.c[i + 1][0] = (float)((7 - i) * e0 + i * e1) * (1.0f / 7.0f);
+	} else {
+		for (uint32_t i = 1; i < 5; ++i)
+			palette.c[i + 1][0] = (float)((5 - i) * e0 + i * e1) * (1.0f / 5.0f);
+		palette.c[6][0] = 0.0f;
+		palette.c[7][0] = 255.0f;
+	}
+	return assign_indices(b, 1, &palette, indices);
+}
+
+// Encodes `channel` of `b` as a BC4 block.
+static void encode_bc4(uint8_t *out, const block_t *b, uint32_t channel, enum bc_quality quality)
+{
+	block_t values;
+	memcpy(values.c[0], b->c[channel], sizeof(values.c[0]));
+
+	float lo = 255.0f, hi = 0.0f;
+	for (uint32_t i = 0; i < 16; ++i) {
+		lo = values.c[0][i] < lo ? values.c[0][i] : lo;
+		hi = values.c[0][i] > hi ? values.c[0][i] : hi;
+	}
+
+	uint32_t e[2] = { (uint32_t)hi, (uint32_t)lo };
+	uint8_t indices[16];
+	float error = bc4_evaluate(&values, e[0], e[1], indices);
+
+	// Moving the end points inwards trades the error at the extremes for finer steps in between.
+	if (quality == BC_QUALITY_HIGH && error > 0.0f) {
+		for (uint32_t d0 = 0; d0 < 4; ++d0) {
+			for (uint32_t d1 = 0; d1 < 4; ++d1) {
+				if ((d0 == 0 && d1 == 0) || (uint32_t)hi < d0 || (uint32_t)hi - d0 <= (uint32_t)lo + d1)
+					continue;
+				uint8_t candidate[16];
+				const float candidate_error = bc4_evaluate(&values, (uint32_t)hi - d0, (uint32_t)lo + d1, candidate);
+				if (candidate_error < error) {
+					error = candidate_error;
+					e[0] = (uint32_t)hi - d0;
+					e[1] = (uint32_t)lo + d1;
+					memcpy(indices, candidate, sizeof(indices));
+				}
+			}
+		}
+	}
+
+	uint64_t bits = 0;
+	for (uint32_t i = 0; i < 16; ++i)
+		bits |= (uint64_t)indices[i] << (i * 3);
+	out[0] = (uint8_t)e[0];
+	out[1] = (uint8_t)e[1];
+	for (uint32_t i = 0; i < 6; ++i)
+		out[2 + i] = (uint8_t)(bits >> (i * 8));
+}
+
+// BC7
+
+static const uint32_t bc7_weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// End points, p-bits and indices of a mode 6 block.
+typedef struct bc7_mode6_t
+{
+	uint32_t q[2][4];
+	uint32_t p[2];
+	uint8_t indices[16];
+	float error;
+} bc7_mode6_t;
+
+static void bc7_quantize(const float *e, uint32_t p, uint32_t *q)
+{
+	for (uint32_t c = 0; c < 4; ++c) {
+		const int32_t v = (int32_t)floorf((e[c] - (float)p) * 0.5f + 0.5f);
+		q[c] = v < 0 ? 0 : v > 127 ? 127 : (uint32_t)v;
+	}
+}
+
+// Returns the p-bit that gives the lowest quantization error for `e`.
+static uint32_t bc7_best_pbit(const float *e)
+{
+	float error[2] = { 0 };
+	for (uint32_t p = 0; p < 2; ++p) {
+		uint32_t q[4];
+		bc7_quantize(e, p, q);
+		for (uint32_t c = 0; c < 4; ++c) {
+			const float d = (float)(q[c] << 1 | p) - e[c];
+			error[p] += d * d;
+		}
+	}
+	return error[1] < error[0] ? 1 : 0;
+}
+
+static void bc7_evaluate(const block_t *b, bc7_mode6_t *m)
+{
+	palette_t palette = { .size = 16 };
+	for (uint32_t c = 0; c < 4; ++c) {
+		const uint32_t v0 = m->q[0][c] << 1 | m->p[0];
+		const uint32_t v1 = m->q[1][c] << 1 | m->p[1];
+		for (uint32_t k = 0; k < 16; ++k)
+			palette.c[k][c] = (float)((v0 * (64 - bc7_weights[k]) + v1 * bc7_weights[k] + 32) >> 6);
+	}
+	m->error = assign_indices(b, 4, &palette, m->indices);
+}
+
+// Quantizes the end points and assigns the indices. The fast preset picks the p-bits from the
+// quantization error of the end points, the others try all combinations.
+static void bc7_fit(const block_t *b, const float *e0, const float *e1, enum bc_quality quality, bc7_mode6_t *best)
+{
+	best->error = FLT_MAX;
+	const uint32_t num_combinations = quality == BC_QUALITY_FAST ? 1 : 4;
+	for (uint32_t i = 0; i < num_combinations; ++i) {
+		bc7_mode6_t m;
+		m.p[0] = quality == BC_QUALITY_FAST ? bc7_best_pbit(e0) : i & 1;
+		m.p[1] = quality == BC_QUALITY_FAST ? bc7_best_pbit(e1) : i >> 1;
+		bc7_quantize(e0, m.p[0], m.q[0]);
+		bc7_quantize(e1, m.p[1], m.q[1]);
+		bc7_evaluate(b, &m);
+		if (m.error < best->error)
+			*best = m;
+	}
+}
+
+static void write_bits(uint8_t *out, uint32_t *pos, uint32_t value, uint32_t bits)
+{
+	for (uint32_t i = 0; i < bits; ++i, ++*pos)
+		out[*pos >> 3] |= (uint8_t)(((value >> i) & 1) << (*pos & 7));
+}
+
+// Encodes the block with mode 6 and returns the squared error.
+static float encode_bc7_mode6(uint8_t *out, const block_t *b, enum bc_quality quality)
+{
+	float e0[4], e1[4];
+	principal_axis_endpoints(b, 4, e0, e1);
+
+	bc7_mode6_t best;
+	bc7_fit(b, e0, e1, quality, &best);
+
+	float weights[16];
+	for (uint32_t k = 0; k < 16; ++k)
+		weights[k] = (float)bc7_weights[k] * (1.0f / 64.0f);
+
+	const uint32_t iterations = refinement_iterations(quality);
+	for (uint32_t i = 0; i < iterations && best.error > 0.0f; ++i) {
+		if (!least_squares_endpoints(b, 4, best.indices, weights, e0, e1))
+			break;
+		bc7_mode6_t refined;
+		bc7_fit(b, e0, e1, quality, &refined);
+		if (refined.error >= best.error)
+			break;
+		best = refined;
+	}
+
+	// The most significant bit of the first index is implicitly zero, swap the end points if it
+	// isn't.
+	if (best.indices[0] & 8) {
+		for (uint32_t c = 0; c < 4; ++c) {
+			const uint32_t t = best.q[0][c];
+			best.q[0][c] = best.q[1][c];
+			best.q[1][c] = t;
+		}
+		const uint32_t p = best.p[0];
+		best.p[0] = best.p[1];
+		best.p[1] = p;
+		for (uint32_t k = 0; k < 16; ++k)
+			best.indices[k] = (uint8_t)(15 - best.indices[k]);
+	}
+
+	memset(out, 0, 16);
+	uint32_t pos = 0;
+	write_bits(out, &pos, 1 << 6, 7);
+	for (uint32_t c = 0; c < 4; ++c) {
+		write_bits(out, &pos, best.q[0][c], 7);
+		write_bits(out, &pos, best.q[1][c], 7);
+	}
+	write_bits(out, &pos, best.p[0], 1);
+	write_bits(out, &pos, best.p[1], 1);
+	write_bits(out, &pos, best.indices[0], 3);
+	for (uint32_t k = 1; k < 16; ++k)
+		write_bits(out, &pos, best.indices[k], 4);
+	return best.error;
+}
+
+static const uint32_t bc7_weights2[4] = { 0, 21, 43, 64 };
+
+// Evaluates a mode 5 block: RGB end points with 7 bits and alpha end points with 8 bits, each
+// with their own 2-bit indices.
+static float bc7_mode5_evaluate(const block_t *b, const block_t *alpha, uint32_t q[2][3], const uint32_t *qa, uint8_t *color_indices, uint8_t *alpha_indices)
+{
+	palette_t palette = { .size = 4 };
+	palette_t alpha_palette = { .size = 4 };
+	for (uint32_t k = 0; k < 4; ++k) {
+		for (uint32_t c = 0; c < 3; ++c) {
+			const uint32_t v0 = q[0][c] << 1 | q[0][c] >> 6;
+			const uint32_t v1 = q[1][c] << 1 | q[1][c] >> 6;
+			palette.c[k][c] = (float)((v0 * (64 - bc7_weights2[k]) + v1 * bc7_weights2[k] + 32) >> 6);
+		}
+		alpha_palette.c[k][0] = (float)((qa[0] * (64 - bc7_weights2[k]) + qa[1] * bc7_weights2[k] + 32) >> 6);
+	}
+	return assign_indices(b, 3, &palette, color_indices) + assign_indices(alpha, 1, &alpha_palette, alpha_indices);
+}
+
+static void bc7_quantize_rgb7(const float *e, uint32_t *q)
+{
+	for (uint32_t c = 0; c < 3; ++c)
+		q[c] = (uint32_t)(clamp_255(e[c]) * (127.0f / 255.0f) + 0.5f);
+}
+
+// Encodes the block with mode 5 (without channel rotation) and returns the squared error.
+static float encode_bc7_mode5(uint8_t *out, const block_t *b, enum bc_quality quality)
+{
+	block_t alpha;
+	memcpy(alpha.c[0], b->c[3], sizeof(alpha.c[0]));
+	float lo = 255.0f, hi = 0.0f;
+	for (uint32_t i = 0; i < 16; ++i) {
+		lo = alpha.c[0][i] < lo ? alpha.c[0][i] : lo;
+		hi = alpha.c[0][i] > hi ? alpha.c[0][i] : hi;
+	}
+	uint32_t qa[2] = { (uint32_t)lo, (uint32_t)hi };
+
+	float e0[4], e1[4];
+	principal_axis_endpoints(b, 3, e0, e1);
+	uint32_t q[2][3];
+	bc7_quantize_rgb7(e0, q[0]);
+	bc7_quantize_rgb7(e1, q[1]);
+
+	uint8_t color_indices[16], alpha_indices[16];
+	float error = bc7_mode5_evaluate(b, &alpha, q, qa, color_indices, alpha_indices);
+
+	float weights[4];
+	for (uint32_t k = 0; k < 4; ++k)
+		weights[k] = (float)bc7_weights2[k] * (1.0f / 64.0f);
+
+	const uint32_t iterations = refinement_iterations(quality);
+	for (uint32_t i = 0; i < iterations && error > 0.0f; ++i) {
+		if (!least_squares_endpoints(b, 3, color_indices, weights, e0, e1))
+			break;
+		uint32_t refined_q[2][3];
+		bc7_quantize_rgb7(e0, refined_q[0]);
+		bc7_quantize_rgb7(e1, refined_q[1]);
+		uint8_t refined_color_indices[16], refined_alpha_indices[16];
+		const float refined_error = bc7_mode5_evaluate(b, &alpha, refined_q, qa, refined_color_indices, refined_alpha_indices);
+		if (refined_error >= error)
+			break;
+		error = refined_error;
+		memcpy(q, refined_q, sizeof(q));
+		memcpy(color_indices, refined_color_indices, sizeof(color_indices));
+		memcpy(alpha_indices, refined_alpha_indices, sizeof(alpha_indices));
+	}
+
+	// As for mode 6, the most significant bit of the first index of each set is implicitly zero.
+	if (color_indices[0] & 2) {
+		for (uint32_t c = 0; c < 3; ++c) {
+			const uint32_t t = q[0][c];
+			q[0][c] = q[1][c];
+			q[1][c] = t;
+		}
+		for (uint32_t k = 0; k < 16; ++k)
+			color_indices[k] = (uint8_t)(3 - color_indices[k]);
+	}
+	if (alpha_indices[0] & 2) {
+		const uint32_t t = qa[0];
+		qa[0] = qa[1];
+		qa[1] = t;
+		for (uint32_t k = 0; k < 16; ++k)
+			alpha_indices[k] = (uint8_t)(3 - alpha_indices[k]);
+	}
+
+	memset(out, 0, 16);
+	uint32_t pos = 0;
+	write_bits(out, &pos, 1 << 5, 6);
+	write_bits(out, &pos, 0, 2);
+	for (uint32_t c = 0; c < 3; ++c) {
+		write_bits(out, &pos, q[0][c], 7);
+		write_bits(out, &pos, q[1][c], 7);
+	}
+	write_bits(out, &pos, qa[0], 8);
+	write_bits(out, &pos, qa[1], 8);
+	write_bits(out, &pos, color_indices[0], 1);
+	for (uint32_t k = 1; k < 16; ++k)
+		write_bits(out, &pos, color_indices[k], 2);
+	write_bits(out, &pos, alpha_indices[0], 1);
+	for (uint32_t k = 1; k < 16; ++k)
+		write_bits(out, &pos, alpha_indices[k], 2);
+	return error;
+}
+
+// Encodes the block with mode 6, blocks with varying alpha are also tried with mode 5, which
+// stores alpha separately from the color.
+static void encode_bc7(uint8_t *out, const block_t *b, enum bc_quality quality)
+{
+	const float error = encode_bc7_mode6(out, b, quality);
+
+	bool constant_alpha = true;
+	for (uint32_t i = 1; i < 16; ++i)
+		constant_alpha = constant_alpha && b->c[3][i] == b->c[3][0];
+	if (constant_alpha || error == 0.0f)
+		return;
+
+	uint8_t mode5[16];
+	if (encode_bc7_mode5(mode5, b, quality) < error)
+		memcpy(out, mode5, sizeof(mode5));
+}
+
+void bc_compress_blocks(uint8_t *out, const uint8_t *rgba, uint32_t width, uint32_t height,
+	uint32_t first_block_row, uint32_t num_block_rows, enum bc_format format, enum bc_quality quality)
+{
+	const uint32_t blocks_x = (width + 3) / 4;
+	const uint32_t block_size = bc_block_size(format);
+	for (uint32_t by = first_block_row; by < first_block_row + num_block_rows; ++by) {
+		for (uint32_t bx = 0; bx < blocks_x; ++bx) {
+			block_t b;
+			load_block(&b, rgba, width, height, bx, by);
+			uint8_t *block = out + ((uint64_t)by * blocks_x + bx) * block_size;
+			switch (format) {
+			case BC_FORMAT_BC1:
+				encode_bc1(block, &b, quality);
+				break;
+			case BC_FORMAT_BC3:
+				encode_bc4(block, &b, 3, quality);
+				encode_bc1(block + 8, &b, quality);
+				break;
+			case BC_FORMAT_BC5:
+				encode_bc4(block, &b, 0, quality);
+				encode_bc4(block + 8, &b, 1, quality);
+				break;
+			case BC_FORMAT_BC7:
+				encode_bc7(block, &b, quality);
+				break;
+			}
+		}
+	}
+}
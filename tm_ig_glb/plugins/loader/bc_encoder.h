@@ -0,0 +1,49 @@
+#pragma once
+
+#include <foundation/api_types.h>
+
+// CPU encoders for the BC1, BC3, BC5 and BC7 block compressed texture formats.
+//
+// The images are compressed in blocks of 4 x 4 texels, with the texels outside of the image
+// replicated from the closest edge. BC7 blocks are encoded with a single subset, using mode 6
+// (RGBA end points, 4-bit indices) or mode 5 (separate color and alpha indices) for blocks where
+// the alpha varies.
+
+// Block compressed formats.
+enum bc_format {
+    // RGB, 8 bytes per block.
+    BC_FORMAT_BC1,
+
+    // RGBA (BC1 color and BC4 alpha), 16 bytes per block.
+    BC_FORMAT_BC3,
+
+    // Two channels (RG) with a BC4 block each, 16 bytes per block. Used for normal maps.
+    BC_FORMAT_BC5,
+
+    // RGBA, 16 bytes per block.
+    BC_FORMAT_BC7,
+};
+
+// Trade off between encoding speed and quality.
+enum bc_quality {
+    // Endpoints from the principal axis of the block colors, no refinement.
+    BC_QUALITY_FAST,
+
+    // Refines the endpoints once with a least squares fit and picks the best BC7 p-bits.
+    BC_QUALITY_NORMAL,
+
+    // Refines the endpoints iteratively and searches for the best BC4 endpoints.
+    BC_QUALITY_HIGH,
+};
+
+// Returns the size in bytes of a block of `format`.
+uint32_t bc_block_size(enum bc_format format);
+
+// Returns the size in bytes of a `width` x `height` image compressed to `format`.
+uint64_t bc_image_size(enum bc_format format, uint32_t width, uint32_t height);
+
+// Compresses the block rows `first_block_row` to `first_block_row + num_block_rows` of the
+// `width` x `height` RGBA8 image `rgba`. `out` points to the start of the compressed image, the
+// blocks are stored row by row. Separate block rows can be compressed in parallel.
+void bc_compress_blocks(uint8_t *out, const uint8_t *rgba, uint32_t width, uint32_t height,
+    uint32_t first_block_row, uint32_t num_block_rows, enum bc_format format, enum bc_quality quality);
@@ -0,0 +1,126 @@
+#include "draco_decoder.h"
+
+#if defined(TM_IG_DRACO)
+
+#include <draco/compression/decode.h>
+#include <draco/core/decoder_buffer.h>
+#include <draco/mesh/mesh.h>
+
+#include <memory>
+
+template <typename T>
+static bool convert_attribute(const draco::PointAttribute *attribute, uint32_t vertex_count, const draco_attribute_output_t *output)
+{
+	T *out = static_cast<T *>(output->data);
+	const int8_t num_components = (int8_t)output->num_components;
+	for (uint32_t i = 0; i < vertex_count; ++i) {
+		const draco::AttributeValueIndex value = attribute->mapped_index(draco::PointIndex(i));
+		if (!attribute->ConvertValue<T>(value, num_components, out + (uint64_t)i * output->num_components))
+			return false;
+	}
+	return true;
+}
+
+template <typename T>
+static void write_indices(const draco::Mesh &mesh, void *indices)
+{
+	T *out = static_cast<T *>(indices);
+	for (uint32_t f = 0; f < mesh.num_faces(); ++f) {
+		const draco::Mesh::Face &face = mesh.face(draco::FaceIndex(f));
+		out[f * 3 + 0] = (T)face[0].value();
+		out[f * 3 + 1] = (T)face[1].value();
+		out[f * 3 + 2] = (T)face[2].value();
+	}
+}
+
+bool draco_decoder_available(void)
+{
+	return true;
+}
+
+bool draco_decode_mesh(const uint8_t *buffer, uint64_t buffer_size, uint32_t vertex_count,
+	void *indices, uint32_t index_count, uint32_t index_size,
+	const draco_attribute_output_t *attributes, uint32_t num_attributes)
+{
+	draco::DecoderBuffer decoder_buffer;
+	decoder_buffer.Init(reinterpret_cast<const char *>(buffer), (size_t)buffer_size);
+
+	draco::Decoder decoder;
+	draco::StatusOr<std::unique_ptr<draco::Mesh>> result = decoder.DecodeMeshFromBuffer(&decoder_buffer);
+	if (!result.ok())
+		return false;
+
+	const std::unique_ptr<draco::Mesh> mesh = std::move(result).value();
+	if (mesh->num_points() != vertex_count)
+		return false;
+
+	if (indices) {
+		if ((uint64_t)mesh->num_faces() * 3 != index_count)
+			return false;
+
+		// The bitstream always uses 32-bit indices, values are known to fit since they are less
+		// than `vertex_count`.
+		switch (index_size) {
+		case 1:
+			write_indices<uint8_t>(*mesh, indices);
+			break;
+		case 2:
+			write_indices<uint16_t>(*mesh, indices);
+			break;
+		case 4:
+			write_indices<uint32_t>(*mesh, indices);
+			break;
+		default:
+			return false;
+		}
+	}
+
+	for (uint32_t i = 0; i < num_attributes; ++i) {
+		const draco_attribute_output_t *output = attributes + i;
+		const draco::PointAttribute *attribute = mesh->GetAttributeByUniqueId(output->unique_id);
+		if (!attribute || attribute->num_components() < output->num_components)
+			return false;
+
+		bool converted = false;
+		switch (output->component_type) {
+		case DRACO_COMPONENT_TYPE_INT8:
+			converted = convert_attribute<int8_t>(attribute, vertex_count, output);
+			break;
+		case DRACO_COMPONENT_TYPE_UINT8:
+			converted = convert_attribute<uint8_t>(attribute, vertex_count, output);
+			break;
+		case DRACO_COMPONENT_TYPE_INT16:
+			converted = convert_attribute<int16_t>(attribute, vertex_count, output);
+			break;
+		case DRACO_COMPONENT_TYPE_UINT16:
+			converted = convert_attribute<uint16_t>(attribute, vertex_count, output);
+			break;
+		case DRACO_COMPONENT_TYPE_UINT32:
+			converted = convert_attribute<uint32_t>(attribute, vertex_count, output);
+			break;
+		case DRACO_COMPONENT_TYPE_FLOAT32:
+			converted = convert_attribute<float>(attribute, vertex_count, output);
+			break;
+		}
+		if (!converted)
+			return false;
+	}
+
+	return true;
+}
+
+#else
+
+bool draco_decoder_available(void)
+{
+	return false;
+}
+
+bool draco_decode_mesh(const uint8_t *buffer, uint64_t buffer_size, uint32_t vertex_count,
+	void *indices, uint32_t index_count, uint32_t index_size,
+	const draco_attribute_output_t *attributes, uint32_t num_attributes)
+{
+	return false;
+}
+
+#endif
@@ -7,6 +7,7 @@
 #include <foundation/buffer_format.h>
 #include <foundation/carray_print.inl>
 #include <foundation/hash.inl>
+#include <foundation/job_system.h>
 #include <foundation/log.h>
 #include <foundation/math.h>
 #include <foundation/math.inl>
@@ -26,6 +27,14 @@
 #include <plugins/entity/entity.h>
 
 #include "mikktspace.h"
+#include "bc_encoder.h"
+#include "draco_decoder.h"
+#include "image_decoder.h"
+#include "meshlet.h"
+#include "meshopt_decoder.h"
+#include "mip_chain.h"
+#include "simplify.h"
+#include "vertex_layout.h"
 
 TM_DISABLE_PADDING_WARNINGS
 
@@ -36,6 +45,7 @@ TM_DISABLE_PADDING_WARNINGS
 TM_RESTORE_PADDING_WARNINGS
 
 #include <float.h>
+#include <math.h>
 
 extern const struct dcc_asset_type_info_t *dcc_asset_ti;
 
@@ -43,6 +53,7 @@ typedef struct import_glb_task_t
 {
 	uint64_t bytes;
 	struct tm_asset_io_import args;
+	tm_ig_glb_import_settings_t settings;
 	char filename[1]; // will allocate string data together with the rest of the struct.
 } import_glb_task_t;
 
@@ -52,6 +63,94 @@ typedef struct tm_bone_weight_t
 	float weight;
 } tm_bone_weight_t;
 
+// Merges the influences of a vertex that use the same bone, drops the ones at or below `threshold`
+// and keeps the `max_influences` largest (0 for no limit) of the rest. At least the largest
+// influence is kept. The remaining weights are sorted largest first and normalized. Returns the
+// new number of influences.
+static uint32_t prune_bone_weights(tm_bone_weight_t *weights, uint32_t count, float threshold, uint32_t max_influences)
+{
+	uint32_t n = 0;
+	for (uint32_t i = 0; i < count; ++i) {
+		uint32_t j = 0;
+		while (j < n && weights[j].bone_idx != weights[i].bone_idx)
+			++j;
+		if (j == n)
+			weights[n++] = weights[i];
+		else
+			weights[j].weight += weights[i].weight;
+	}
+
+	// Insertion sort, there are at most a handful of influences.
+	for (uint32_t i = 1; i < n; ++i) {
+		const tm_bone_weight_t w = weights[i];
+		uint32_t j = i;
+		for (; j > 0 && weights[j - 1].weight < w.weight; --j)
+			weights[j] = weights[j - 1];
+		weights[j] = w;
+	}
+
+	uint32_t kept = 1;
+	while (kept < n && weights[kept].weight > threshold && (!max_influences || kept < max_influences))
+		++kept;
+
+	float total_weight = 0.f;
+	for (uint32_t i = 0; i < kept; ++i)
+		total_weight += weights[i].weight;
+	if (total_weight > 0.f) {
+		for (uint32_t i = 0; i < kept; ++i)
+			weights[i].weight /= total_weight;
+	}
+	return kept;
+}
+
+// Size in bytes of the influences of a vertex in the skin data, see
+// `tm_ig_glb_import_settings_t.skin_weight_bits`. Padded so that the next vertex starts 4-byte
+// aligned.
+static inline uint32_t skin_record_size(uint32_t count, uint32_t bits)
+{
+	return bits == 32 ? count * (uint32_t)sizeof(tm_bone_weight_t) : (count * 2 * (bits / 8) + 3) & ~3u;
+}
+
+// Stores the normalized `weights` of a vertex with `bits` wide bone indices and weights. The
+// quantized weights are rounded so that they still sum up to exactly one.
+static void encode_skin_record(uint8_t *out, const tm_bone_weight_t *weights, uint32_t count, uint32_t bits)
+{
+	if (bits == 32) {
+		memcpy(out, weights, count * sizeof(tm_bone_weight_t));
+		return;
+	}
+
+	const uint32_t max = (1u << bits) - 1;
+	uint32_t q[8];
+	uint32_t sum = 0, largest = 0;
+	for (uint32_t i = 0; i < count; ++i) {
+		q[i] = (uint32_t)(weights[i].weight * (float)max + 0.5f);
+		q[i] = q[i] > max ? max : q[i];
+		sum += q[i];
+		largest = q[i] > q[largest] ? i : largest;
+	}
+	if (sum)
+		q[largest] = q[largest] + max - sum;
+
+	for (uint32_t i = 0; i < count; ++i) {
+		if (bits == 8) {
+			out[i * 2 + 0] = (uint8_t)weights[i].bone_idx;
+			out[i * 2 + 1] = (uint8_t)q[i];
+		} else {
+			const uint16_t e[2] = { (uint16_t)weights[i].bone_idx, (uint16_t)q[i] };
+			memcpy(out + i * sizeof(e), e, sizeof(e));
+		}
+	}
+}
+
+// Bits of the bone indices and weights of the skin data of a mesh with `num_bones` bones.
+static inline uint32_t skin_weight_bits(const tm_ig_glb_import_settings_t *settings, uint32_t num_bones)
+{
+	if (settings->skin_weight_bits == 8)
+		return num_bones <= 256 ? 8 : 16;
+	return settings->skin_weight_bits == 16 ? 16 : 32;
+}
+
 typedef struct smikktspace_data_t
 {
 	cgltf_size  face_count;
@@ -62,6 +161,7 @@ typedef struct smikktspace_data_t
 } smikktspace_data_t;
 
 typedef struct TM_HASH_T(uint64_t, tm_tt_id_t) name_to_id_t;
+typedef struct TM_HASH_T(uint64_t, uint32_t) hash_to_index_t;
 
 static void glb_to_tm_vec4(const cgltf_float *in, tm_vec4_t *out)
 {
@@ -165,6 +265,351 @@ static inline tm_vec3_t v3_max(tm_vec3_t a, float* b)
 	};
 }
 
+// Adds an accessor of `count` elements with `format` to `obj`. `stride` is the distance in bytes
+// between the elements, 0 if they are tightly packed.
+static tm_tt_id_t add_accessor(tm_the_truth_o *tt, tm_the_truth_object_o *obj, tm_tt_id_t buffer_id, uint32_t offset, uint32_t count, vertex_format_t format, uint32_t stride)
+{
+	const tm_tt_id_t access_id = tm_the_truth_api->create_object_of_type(tt, dcc_asset_ti->accessor_type, TM_TT_NO_UNDO_SCOPE);
+	tm_the_truth_object_o *access = tm_the_truth_api->write(tt, access_id);
+	tm_the_truth_api->set_uint32_t(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__OFFSET, offset);
+	tm_the_truth_api->set_uint32_t(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__COUNT, count);
+	if (stride)
+		tm_the_truth_api->set_uint32_t(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__STRIDE, stride);
+	tm_the_truth_api->set_bool(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__IS_FLOAT, format.is_float);
+	tm_the_truth_api->set_bool(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__IS_SIGNED, format.is_signed);
+	tm_the_truth_api->set_bool(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__IS_NORMALIZED, format.is_normalized);
+	tm_the_truth_api->set_uint32_t(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__BITS, format.bits);
+	tm_the_truth_api->set_uint32_t(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__COMPONENT_COUNT, format.component_count);
+	tm_the_truth_api->set_reference(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__BUFFER, buffer_id);
+	tm_the_truth_api->add_to_subobject_set(tt, obj, TM_TT_PROP__DCC_ASSET__ACCESSORS, &access, 1);
+	tm_the_truth_api->commit(tt, access, TM_TT_NO_UNDO_SCOPE);
+	return access_id;
+}
+
+// Adds an attribute with `semantic` that references the accessor `access_id` to `tm_mesh`.
+static void add_attribute(tm_the_truth_o *tt, tm_the_truth_object_o *tm_mesh, uint32_t semantic, tm_tt_id_t access_id)
+{
+	tm_the_truth_object_o *attr = tm_the_truth_api->write(tt, tm_the_truth_api->create_object_of_type(tt, dcc_asset_ti->attribute_type, TM_TT_NO_UNDO_SCOPE));
+	tm_the_truth_api->set_uint32_t(tt, attr, TM_TT_PROP__DCC_ASSET_ATTRIBUTE__SEMANTIC, semantic);
+	tm_the_truth_api->set_uint32_t(tt, attr, TM_TT_PROP__DCC_ASSET_ATTRIBUTE__SET, 0);
+	tm_the_truth_api->set_reference(tt, attr, TM_TT_PROP__DCC_ASSET_ATTRIBUTE__ACCESSOR, access_id);
+	tm_the_truth_api->add_to_subobject_set(tt, tm_mesh, TM_TT_PROP__DCC_ASSET_MESH__ATTRIBUTES, &attr, 1);
+	tm_the_truth_api->commit(tt, attr, TM_TT_NO_UNDO_SCOPE);
+}
+
+static void add_vertex_attribute(tm_the_truth_o *tt, tm_the_truth_object_o *obj, tm_the_truth_object_o *tm_mesh, uint32_t semantic,
+	tm_tt_id_t buffer_id, uint32_t offset, uint32_t count, vertex_format_t format, uint32_t stride)
+{
+	add_attribute(tt, tm_mesh, semantic, add_accessor(tt, obj, buffer_id, offset, count, format, stride));
+}
+
+static inline float clamp_snorm(float v)
+{
+	return v < -1.f ? -1.f : (v > 1.f ? 1.f : v);
+}
+
+static inline int16_t float_to_snorm16(float v)
+{
+	const float s = clamp_snorm(v) * 32767.f;
+	return (int16_t)(s >= 0.f ? s + 0.5f : s - 0.5f);
+}
+
+// Converts `f` to a IEEE 754 half float, rounding to nearest.
+static uint16_t float_to_half(float f)
+{
+	uint32_t u;
+	memcpy(&u, &f, sizeof(u));
+	const uint32_t sign = (u >> 16) & 0x8000;
+	const uint32_t f_exp = (u >> 23) & 0xff;
+	uint32_t mant = u & 0x7fffff;
+
+	if (f_exp == 0xff)
+		return (uint16_t)(sign | 0x7c00 | (mant ? 0x200 : 0));
+
+	const int32_t exp = (int32_t)f_exp - 127 + 15;
+	if (exp >= 31)
+		return (uint16_t)(sign | 0x7c00);
+
+	if (exp <= 0) {
+		// Subnormal half.
+		if (exp < -10)
+			return (uint16_t)sign;
+		mant |= 0x800000;
+		const uint32_t shift = (uint32_t)(14 - exp);
+		uint32_t h = mant >> shift;
+		if ((mant >> (shift - 1)) & 1)
+			++h;
+		return (uint16_t)(sign | h);
+	}
+
+	uint32_t h = sign | ((uint32_t)exp << 10) | (mant >> 13);
+	// A carry out of the mantissa correctly bumps the exponent.
+	if (mant & 0x1000)
+		++h;
+	return (uint16_t)h;
+}
+
+// Maps the unit vector `n` onto the [-1, 1] octahedron square.
+static void octahedral_encode(const float *n, float *out)
+{
+	const float l1 = fabsf(n[0]) + fabsf(n[1]) + fabsf(n[2]);
+	if (l1 == 0.f) {
+		out[0] = out[1] = 0.f;
+		return;
+	}
+	float x = n[0] / l1;
+	float y = n[1] / l1;
+	if (n[2] < 0.f) {
+		const float ox = (1.f - fabsf(y)) * (x >= 0.f ? 1.f : -1.f);
+		const float oy = (1.f - fabsf(x)) * (y >= 0.f ? 1.f : -1.f);
+		x = ox;
+		y = oy;
+	}
+	out[0] = x;
+	out[1] = y;
+}
+
+// The encoders below write one element per vertex, `out_stride` bytes apart.
+
+static void encode_positions_unorm16(uint8_t *out, uint32_t out_stride, const float *positions, uint32_t num_vertices, const tm_vec3_t bounds[2])
+{
+	const float *min = &bounds[0].x;
+	const float *max = &bounds[1].x;
+	float scale[3];
+	for (uint32_t c = 0; c < 3; ++c)
+		scale[c] = max[c] > min[c] ? 65535.f / (max[c] - min[c]) : 0.f;
+
+	for (uint32_t v = 0; v < num_vertices; ++v, positions += 3, out += out_stride) {
+		uint16_t e[3];
+		for (uint32_t c = 0; c < 3; ++c) {
+			const float q = (positions[c] - min[c]) * scale[c] + 0.5f;
+			e[c] = (uint16_t)(q < 0.f ? 0.f : (q > 65535.f ? 65535.f : q));
+		}
+		memcpy(out, e, sizeof(e));
+	}
+}
+
+// Encodes `num_vertices` vectors with a stride of `in_stride` floats as octahedral snorm16 pairs.
+// If `in_stride` is 4 the fourth component is treated as the tangent handedness.
+static void encode_octahedral_snorm16(uint8_t *out, uint32_t out_stride, const float *in, uint32_t in_stride, uint32_t num_vertices)
+{
+	for (uint32_t v = 0; v < num_vertices; ++v, in += in_stride, out += out_stride) {
+		float oct[2];
+		octahedral_encode(in, oct);
+		int16_t e[2] = { float_to_snorm16(oct[0]), float_to_snorm16(oct[1]) };
+		if (in_stride == 4)
+			e[1] = (int16_t)((e[1] & ~1) | (in[3] < 0.f ? 1 : 0));
+		memcpy(out, e, sizeof(e));
+	}
+}
+
+static void encode_half(uint8_t *out, uint32_t out_stride, const float *in, uint32_t num_components, uint32_t num_vertices)
+{
+	for (uint32_t v = 0; v < num_vertices; ++v, in += num_components, out += out_stride) {
+		for (uint32_t c = 0; c < num_components; ++c) {
+			const uint16_t h = float_to_half(in[c]);
+			memcpy(out + c * sizeof(h), &h, sizeof(h));
+		}
+	}
+}
+
+static void copy_floats(uint8_t *out, uint32_t out_stride, const float *in, uint32_t num_components, uint32_t num_vertices)
+{
+	const uint32_t element_size = num_components * sizeof(float);
+	if (out_stride == element_size) {
+		memcpy(out, in, (uint64_t)element_size * num_vertices);
+		return;
+	}
+	for (uint32_t v = 0; v < num_vertices; ++v, in += num_components, out += out_stride)
+		memcpy(out, in, element_size);
+}
+
+#define MAX_LOD_COUNT 8
+
+typedef struct lod_mesh_t
+{
+	tm_tt_id_t mesh_id;
+	tm_tt_id_t indices;
+	uint32_t primitive;
+	uint32_t level;
+} lod_mesh_t;
+
+// Accessors of the meshlet sections of a primitive, indexed like `meshlet_semantics`.
+typedef struct meshlet_mesh_t
+{
+	tm_tt_id_t mesh_id;
+	tm_tt_id_t accessors[4];
+} meshlet_mesh_t;
+
+static const uint32_t meshlet_semantics[4] = {
+	TM_TT_VALUE__DCC_ASSET_VERTEX__SEMANTIC__MESHLET_DESCRIPTORS,
+	TM_TT_VALUE__DCC_ASSET_VERTEX__SEMANTIC__MESHLET_BOUNDS,
+	TM_TT_VALUE__DCC_ASSET_VERTEX__SEMANTIC__MESHLET_VERTICES,
+	TM_TT_VALUE__DCC_ASSET_VERTEX__SEMANTIC__MESHLET_TRIANGLES,
+};
+
+// Alignment of the interleaved vertex records, a power of two of at least 4 bytes.
+static inline uint32_t vertex_alignment(const tm_ig_glb_import_settings_t *settings)
+{
+	uint32_t alignment = 4;
+	while (alignment < settings->vertex_alignment && alignment < 256)
+		alignment *= 2;
+	return alignment;
+}
+
+static inline uint32_t meshlet_max_vertices(const tm_ig_glb_import_settings_t *settings)
+{
+	const uint32_t v = settings->meshlet_max_vertices;
+	return v < 3 ? 3 : v > MESHLET_MAX_VERTICES ? MESHLET_MAX_VERTICES : v;
+}
+
+static inline uint32_t meshlet_max_triangles(const tm_ig_glb_import_settings_t *settings)
+{
+	const uint32_t t = settings->meshlet_max_triangles;
+	return t < 1 ? 1 : t > MESHLET_MAX_TRIANGLES ? MESHLET_MAX_TRIANGLES : t;
+}
+
+typedef struct primitive_job_t
+{
+	const cgltf_primitive *primitive;
+	const tm_ig_glb_import_settings_t *settings;
+
+	// Index lists of the LOD levels. Level `l` starts at `lod_indices + l * primitive->indices->count`
+	// and holds `lod_counts[l]` indices.
+	uint32_t *lod_indices;
+	uint32_t lod_counts[MAX_LOD_COUNT];
+	uint32_t num_lods;
+
+	// Meshlets of the primitive, allocated with room for `meshlets_bound()` meshlets.
+	uint32_t num_meshlets;
+	meshlet_t *meshlets;
+	meshlet_bounds_t *meshlet_bounds;
+	uint32_t *meshlet_vertices;
+	uint8_t *meshlet_triangles;
+	uint32_t num_meshlet_vertices;
+	uint32_t num_meshlet_triangles;
+
+	// Set if an index of the primitive is out of range of its vertices. No LODs or meshlets are
+	// built for the primitive then.
+	bool invalid_indices;
+} primitive_job_t;
+
+// Builds the LOD chain and the meshlets of a single triangle primitive. The job only reads from
+// the cgltf data and writes to memory allocated up front, so all primitives can be processed in
+// parallel.
+static void process_primitive_job(void *data)
+{
+	primitive_job_t *job = data;
+	const cgltf_primitive *primitive = job->primitive;
+	if (!job->lod_indices && !job->meshlets)
+		return;
+
+	TM_PROFILER_BEGIN_FUNC_SCOPE();
+	TM_INIT_TEMP_ALLOCATOR(ta);
+	TM_GET_TEMP_ALLOCATOR_ADAPTER(ta, a);
+
+	cgltf_accessor *acc_POSITION = NULL;
+	cgltf_accessor *acc_NORMAL = NULL;
+	cgltf_accessor *acc_TEXCOORD_0 = NULL;
+	cgltf_accessor *acc_WEIGHTS_0 = NULL;
+	cgltf_accessor *acc_JOINTS_0 = NULL;
+
+	for (cgltf_size k = 0; k < primitive->attributes_count; ++k) {
+		const cgltf_attribute *attr = &primitive->attributes[k];
+
+		if (attr->type == cgltf_attribute_type_position) {
+			acc_POSITION = attr->data;
+		} else if (attr->type == cgltf_attribute_type_normal) {
+			acc_NORMAL = attr->data;
+		} else if (strcmp(attr->name, "TEXCOORD_0") == 0) {
+			acc_TEXCOORD_0 = attr->data;
+		} else if (strcmp(attr->name, "WEIGHTS_0") == 0) {
+			acc_WEIGHTS_0 = attr->data;
+		} else if (strcmp(attr->name, "JOINTS_0") == 0) {
+			acc_JOINTS_0 = attr->data;
+		}
+	}
+
+	const uint32_t num_vertices = (uint32_t)acc_POSITION->count;
+	const uint32_t num_indices = (uint32_t)primitive->indices->count;
+	uint32_t *indices = NULL;
+	tm_carray_temp_resize(indices, num_indices, ta);
+	for (cgltf_size k = 0; k < num_indices; ++k) {
+		indices[k] = (uint32_t)cgltf_accessor_read_index(primitive->indices, k);
+		if (indices[k] >= num_vertices) {
+			job->invalid_indices = true;
+			TM_SHUTDOWN_TEMP_ALLOCATOR(ta);
+			TM_PROFILER_END_FUNC_SCOPE();
+			return;
+		}
+	}
+
+	simplify_vertices_t vertices = { .num_vertices = num_vertices };
+
+	cgltf_float *positions = NULL;
+	tm_carray_temp_resize(positions, (cgltf_size)num_vertices * 3, ta);
+	cgltf_accessor_unpack_floats(acc_POSITION, positions, (cgltf_size)num_vertices * 3);
+	vertices.positions = positions;
+
+	if (acc_NORMAL != NULL && acc_NORMAL->count == num_vertices) {
+		cgltf_float *normals = NULL;
+		tm_carray_temp_resize(normals, (cgltf_size)num_vertices * 3, ta);
+		cgltf_accessor_unpack_floats(acc_NORMAL, normals, (cgltf_size)num_vertices * 3);
+		vertices.normals = normals;
+	}
+
+	if (acc_TEXCOORD_0 != NULL && acc_TEXCOORD_0->count == num_vertices) {
+		cgltf_float *texcoords = NULL;
+		tm_carray_temp_resize(texcoords, (cgltf_size)num_vertices * 2, ta);
+		cgltf_accessor_unpack_floats(acc_TEXCOORD_0, texcoords, (cgltf_size)num_vertices * 2);
+		vertices.texcoords = texcoords;
+	}
+
+	if (acc_JOINTS_0 != NULL && acc_WEIGHTS_0 != NULL && acc_JOINTS_0->count == num_vertices && acc_WEIGHTS_0->count == num_vertices) {
+		cgltf_uint *joints = NULL;
+		tm_carray_temp_resize(joints, (cgltf_size)num_vertices * 4, ta);
+		for (cgltf_size k = 0; k < num_vertices; ++k)
+			cgltf_accessor_read_uint(acc_JOINTS_0, k, joints + (k * 4), 4);
+		cgltf_float *weights = NULL;
+		tm_carray_temp_resize(weights, (cgltf_size)num_vertices * 4, ta);
+		cgltf_accessor_unpack_floats(acc_WEIGHTS_0, weights, (cgltf_size)num_vertices * 4);
+		vertices.joints = joints;
+		vertices.weights = weights;
+	}
+
+	const uint32_t lod_count = job->settings->lod_count < MAX_LOD_COUNT ? job->settings->lod_count : MAX_LOD_COUNT;
+	const uint32_t *source = indices;
+	uint32_t source_count = num_indices;
+	for (uint32_t l = 0; l < lod_count; ++l) {
+		uint32_t *lod = job->lod_indices + (uint64_t)l * num_indices;
+		const uint32_t target_count = (uint32_t)((float)source_count * job->settings->lod_reduction);
+		const uint32_t count = simplify_indices(lod, source, source_count, &vertices, target_count, job->settings->lod_target_error, a);
+
+		// Stop once the error limit is reached, further levels would be identical.
+		if (count == 0 || count >= source_count)
+			break;
+
+		job->lod_counts[job->num_lods++] = count;
+		source = lod;
+		source_count = count;
+	}
+
+	if (job->meshlets) {
+		const uint32_t max_vertices = meshlet_max_vertices(job->settings);
+		const uint32_t max_triangles = meshlet_max_triangles(job->settings);
+		job->num_meshlets = build_meshlets(job->meshlets, job->meshlet_vertices, job->meshlet_triangles, indices, num_indices, positions, num_vertices, max_vertices, max_triangles, a);
+		compute_meshlet_bounds(job->meshlet_bounds, job->meshlets, job->num_meshlets, job->meshlet_vertices, job->meshlet_triangles, positions);
+		if (job->num_meshlets) {
+			const meshlet_t *last = job->meshlets + job->num_meshlets - 1;
+			job->num_meshlet_vertices = last->vertex_offset + last->vertex_count;
+			job->num_meshlet_triangles = last->triangle_offset / 3 + last->triangle_count;
+		}
+	}
+
+	TM_SHUTDOWN_TEMP_ALLOCATOR(ta);
+	TM_PROFILER_END_FUNC_SCOPE();
+}
+
 static void import_node(struct tm_the_truth_o *tt, struct tm_the_truth_object_o *asset, struct tm_the_truth_object_o *scene, struct tm_the_truth_object_o *parent, const struct cgltf_node *node,
 	name_to_id_t *node_by_name, struct tm_error_i *error)
 {
@@ -245,61 +690,643 @@ static void import_node(struct tm_the_truth_o *tt, struct tm_the_truth_object_o
 
 }
 
-static tm_tt_id_t extract_texture(struct tm_the_truth_o *tt, name_to_id_t *image_lookup, struct tm_the_truth_object_o *obj, 
-	const struct cgltf_material *material, uint32_t type,
-	struct tm_temp_allocator_i *ta, struct tm_error_i *error)
+// Identifier at the start of every KTX2 file.
+static const uint8_t ktx2_identifier[12] = { 0xab, 'K', 'T', 'X', ' ', '2', '0', 0xbb, '\r', '\n', 0x1a, '\n' };
+
+// Returns the index of the image used by `texture`. The KTX2 source of `KHR_texture_basisu` is
+// preferred over the fallback image, since it can be used without decoding it. cgltf doesn't
+// parse the extension, so the source is read from the raw extension JSON.
+static cgltf_int texture_image_index(const cgltf_data *data, const cgltf_texture *texture)
 {
-	const cgltf_texture *texture = NULL;
+	for (cgltf_size i = 0; i < texture->extensions_count; ++i) {
+		const cgltf_extension *ext = texture->extensions + i;
+		if (strcmp(ext->name, "KHR_texture_basisu") != 0 || !ext->data)
+			continue;
 
+		const char *source = strstr(ext->data, "\"source\"");
+		if (!source)
+			break;
+		source = strchr(source, ':');
+		if (!source)
+			break;
+		const long index = strtol(source + 1, NULL, 10);
+		if (index >= 0 && (cgltf_size)index < data->images_count)
+			return (cgltf_int)index;
+		break;
+	}
+	return texture->image ? texture->image_index : -1;
+}
+
+static uint32_t image_type(const cgltf_image *image, const uint8_t *bytes, cgltf_size size)
+{
+	const char *mime_type = image->mime_type ? image->mime_type : "";
+	if (strcmp(mime_type, "image\\/png") == 0)
+		return TM_TT_VALUE__DCC_ASSET_IMAGE__TYPE__PNG;
+	if (strcmp(mime_type, "image\\/ktx2") == 0 || strcmp(mime_type, "image/ktx2") == 0
+		|| (size >= sizeof(ktx2_identifier) && memcmp(bytes, ktx2_identifier, sizeof(ktx2_identifier)) == 0))
+		return TM_TT_VALUE__DCC_ASSET_IMAGE__TYPE__KTX2;
+	return TM_TT_VALUE__DCC_ASSET_IMAGE__TYPE__UNKNOWN;
+}
+
+// Returns the payload of `image`, or NULL if it isn't stored in a buffer.
+static const uint8_t *image_payload(const cgltf_image *image, uint64_t *size)
+{
+	const cgltf_buffer_view *buffer_view = image->buffer_view;
+	if (!buffer_view || !buffer_view->buffer->data)
+		return NULL;
+	*size = buffer_view->size;
+	return (const uint8_t *)buffer_view->buffer->data + buffer_view->offset;
+}
+
+// Maps each image to the first image with identical content. Exporters often embed the same
+// payload several times under different names, these are imported as a single image.
+static uint32_t *dedup_images(const cgltf_data *data, struct tm_temp_allocator_i *ta)
+{
+	TM_GET_TEMP_ALLOCATOR_ADAPTER(ta, a);
+
+	uint32_t *first = NULL;
+	tm_carray_temp_resize(first, data->images_count, ta);
+	hash_to_index_t lookup = { .allocator = a };
+	for (uint32_t i = 0; i < (uint32_t)data->images_count; ++i) {
+		first[i] = i;
+		uint64_t size;
+		const uint8_t *payload = image_payload(data->images + i, &size);
+		if (!payload)
+			continue;
+
+		// Entries store the image index plus one, so zero means not found. Images whose hashes
+		// collide without an identical payload are kept separate.
+		uint32_t *entry = tm_hash_add_reference(&lookup, tm_murmur_hash_64a(payload, size, size));
+		if (!*entry) {
+			*entry = i + 1;
+			continue;
+		}
+		uint64_t other_size;
+		const uint8_t *other = image_payload(data->images + *entry - 1, &other_size);
+		if (other_size == size && memcmp(other, payload, size) == 0)
+			first[i] = *entry - 1;
+	}
+	return first;
+}
+
+// Returns the texture of `material` used for the texture property `type`, or NULL.
+static const cgltf_texture *material_texture(const struct cgltf_material *material, uint32_t type)
+{
 	if (type == TM_TT_PROP__DCC_ASSET_MATERIAL__NORMAL_TEXTURE && material->normal_texture.texture != NULL) {
-		texture = material->normal_texture.texture;
+		return material->normal_texture.texture;
 	} else if (type == TM_TT_PROP__DCC_ASSET_MATERIAL__EMISSIVE_TEXTURE && material->emissive_texture.texture != NULL) {
-		texture = material->emissive_texture.texture;
+		return material->emissive_texture.texture;
 	} else if (type == TM_TT_PROP__DCC_ASSET_MATERIAL__BASE_COLOR_TEXTURE
 		&& material->has_pbr_metallic_roughness && material->pbr_metallic_roughness.base_color_texture.texture != NULL) {
-		texture = material->pbr_metallic_roughness.base_color_texture.texture;
+		return material->pbr_metallic_roughness.base_color_texture.texture;
 	} else if (type == TM_TT_PROP__DCC_ASSET_MATERIAL_PBR_MR__METALLIC_ROUGHNESS_TEXTURE && material->pbr_metallic_roughness.metallic_roughness_texture.texture != NULL) {
-		texture = material->pbr_metallic_roughness.metallic_roughness_texture.texture;
+		return material->pbr_metallic_roughness.metallic_roughness_texture.texture;
+	}
+	return NULL;
+}
+
+// Texture properties of the materials that are imported.
+static const uint32_t tm_texture_properties[] = { TM_TT_PROP__DCC_ASSET_MATERIAL__BASE_COLOR_TEXTURE, TM_TT_PROP__DCC_ASSET_MATERIAL__NORMAL_TEXTURE, TM_TT_PROP__DCC_ASSET_MATERIAL__EMISSIVE_TEXTURE };
+
+// Decoded images are processed in batches whose RGBA8 mip chains take at most this many bytes, so
+// that the peak memory use of an import doesn't grow with the number of images. Larger images get
+// a batch of their own.
+#define DECODE_BATCH_BYTES (256ull << 20)
+
+typedef struct decode_image_job_t
+{
+	const uint8_t *data;
+	uint64_t size;
+
+	// Header of the RGBA8 mip chain and its size with the levels, 0 if the image isn't decoded.
+	tm_ig_glb_mip_chain_t header;
+	uint64_t mips_bytes;
+
+	// Mip chain header followed by the levels, only allocated while the batch of the image is
+	// decoded and compressed.
+	tm_ig_glb_mip_chain_t *mips;
+
+	// Truth buffer holding the final mip chain, 0 if the image wasn't decoded.
+	uint32_t mips_buffer;
+
+	// Size of the source image, larger than the mip chain if the image is downscaled.
+	uint32_t source_width;
+	uint32_t source_height;
+
+	// Maximum width and height of the mip chain, 0 for no limit.
+	uint32_t max_size;
+
+	uint32_t filter;
+	bool srgb;
+	bool normal_map;
+
+	// Set by the job if the image was successfully decoded and if any of its texels aren't opaque.
+	bool decoded;
+	bool has_alpha;
+} decode_image_job_t;
+
+// Decodes a single image and generates its mip chain. The job only writes to the memory allocated
+// for it, so all images can be decoded in parallel.
+static void decode_image_job(void *data)
+{
+	decode_image_job_t *job = data;
+
+	TM_PROFILER_BEGIN_FUNC_SCOPE();
+	TM_INIT_TEMP_ALLOCATOR(ta);
+	TM_GET_TEMP_ALLOCATOR_ADAPTER(ta, a);
+
+	tm_ig_glb_mip_chain_t *mips = job->mips;
+	uint8_t *levels = (uint8_t *)mips + sizeof(*mips);
+	bool decoded;
+	if (mips->width != job->source_width || mips->height != job->source_height) {
+		const uint64_t source_bytes = (uint64_t)job->source_width * job->source_height * 4;
+		uint8_t *source = tm_alloc(a, source_bytes);
+		decoded = image_decoder_decode_rgba8(source, job->data, job->size, a);
+		if (decoded)
+			mip_chain_downscale(levels, mips->width, mips->height, source, job->source_width, job->source_height, job->srgb, a);
+		tm_free(a, source, source_bytes);
 	} else {
-		return (tm_tt_id_t) { 0 };
+		decoded = image_decoder_decode_rgba8(levels, job->data, job->size, a);
+	}
+
+	if (decoded) {
+		mip_chain_generate(levels, mips->width, mips->height, job->srgb, job->filter, a);
+		job->decoded = true;
+		for (uint64_t i = 3; i < (uint64_t)mips->width * mips->height * 4 && !job->has_alpha; i += 4)
+			job->has_alpha = levels[i] != 255;
+	}
+
+	TM_SHUTDOWN_TEMP_ALLOCATOR(ta);
+	TM_PROFILER_END_FUNC_SCOPE();
+}
+
+// Returns the maximum size of the images used by the material texture property `type`, 0 for no
+// limit.
+static uint32_t texture_max_size(const tm_ig_glb_import_settings_t *settings, uint32_t type)
+{
+	uint32_t slot;
+	switch (type) {
+	case TM_TT_PROP__DCC_ASSET_MATERIAL__NORMAL_TEXTURE:
+		slot = TM_IG_GLB_TEXTURE_SLOT_NORMAL;
+		break;
+	case TM_TT_PROP__DCC_ASSET_MATERIAL__EMISSIVE_TEXTURE:
+		slot = TM_IG_GLB_TEXTURE_SLOT_EMISSIVE;
+		break;
+	case TM_TT_PROP__DCC_ASSET_MATERIAL_PBR_MR__METALLIC_ROUGHNESS_TEXTURE:
+		slot = TM_IG_GLB_TEXTURE_SLOT_METALLIC_ROUGHNESS;
+		break;
+	default:
+		slot = TM_IG_GLB_TEXTURE_SLOT_BASE_COLOR;
+		break;
+	}
+	return settings->texture_slot_max_size[slot] ? settings->texture_slot_max_size[slot] : settings->max_texture_size;
+}
+
+// Sets up the decoding of the images used by the imported material textures. Images larger than
+// their texture slot allows are downscaled by the job before the mip chain is generated. Returns
+// an array with one entry per image in `data`, see `decode_images()`.
+static decode_image_job_t *prepare_images(const struct cgltf_data *data, const uint32_t *first_image, const tm_ig_glb_import_settings_t *settings, struct tm_temp_allocator_i *ta)
+{
+	decode_image_job_t *image_jobs = NULL;
+	tm_carray_temp_resize(image_jobs, data->images_count, ta);
+	memset(image_jobs, 0, data->images_count * sizeof(*image_jobs));
+
+	// Images used as color textures are sRGB encoded, everything else (normal maps) is linear.
+	bool *used = NULL;
+	tm_carray_temp_resize(used, data->images_count, ta);
+	memset(used, 0, data->images_count * sizeof(*used));
+	for (cgltf_size i = 0; i < data->materials_count; ++i) {
+		for (uint32_t t = 0; t != TM_ARRAY_COUNT(tm_texture_properties); ++t) {
+			const cgltf_texture *texture = material_texture(data->materials + i, tm_texture_properties[t]);
+			const cgltf_int texture_image = texture ? texture_image_index(data, texture) : -1;
+			if (texture_image < 0)
+				continue;
+			const uint32_t image_index = first_image[texture_image];
+			decode_image_job_t *job = image_jobs + image_index;
+			const uint32_t max_size = texture_max_size(settings, tm_texture_properties[t]);
+			if (!used[image_index])
+				job->max_size = max_size;
+			else if (job->max_size && (!max_size || max_size > job->max_size))
+				job->max_size = max_size;
+			used[image_index] = true;
+			if (tm_texture_properties[t] == TM_TT_PROP__DCC_ASSET_MATERIAL__NORMAL_TEXTURE)
+				job->normal_map = true;
+			else
+				job->srgb = true;
+		}
+	}
+
+	for (cgltf_size i = 0; i < data->images_count; ++i) {
+		uint64_t size;
+		const uint8_t *payload = image_payload(data->images + i, &size);
+		if (!used[i] || !payload)
+			continue;
+
+		decode_image_job_t *job = image_jobs + i;
+		job->data = payload;
+		job->size = size;
+		job->filter = settings->mip_filter == TM_IG_GLB_MIP_FILTER_KAISER ? MIP_FILTER_KAISER : MIP_FILTER_BOX;
+
+		if (!image_decoder_info(job->data, job->size, &job->source_width, &job->source_height))
+			continue;
+
+		uint32_t width, height;
+		mip_chain_fit(job->source_width, job->source_height, job->max_size, &width, &height);
+
+		tm_ig_glb_mip_chain_t header = { .width = width, .height = height, .srgb = job->srgb, .format = TM_IG_GLB_MIP_FORMAT_RGBA8 };
+		header.source_width = job->source_width;
+		header.source_height = job->source_height;
+		header.num_mips = mip_chain_levels(width, height);
+		const uint64_t levels_bytes = mip_chain_size(width, height, header.mip_offsets);
+		for (uint32_t m = 0; m < header.num_mips; ++m)
+			header.mip_offsets[m] += sizeof(header);
+
+		job->header = header;
+		job->mips_bytes = sizeof(header) + levels_bytes;
+	}
+
+	return image_jobs;
+}
+
+// Number of block rows compressed by a single job.
+#define COMPRESS_BLOCK_ROWS 16
+
+typedef struct compress_job_t
+{
+	const uint8_t *rgba;
+	uint8_t *out;
+	uint32_t width;
+	uint32_t height;
+	uint32_t first_block_row;
+	uint32_t num_block_rows;
+	uint32_t format;
+	uint32_t quality;
+} compress_job_t;
+
+static void compress_job(void *data)
+{
+	TM_PROFILER_BEGIN_FUNC_SCOPE();
+	const compress_job_t *job = data;
+	bc_compress_blocks(job->out, job->rgba, job->width, job->height, job->first_block_row, job->num_block_rows, job->format, job->quality);
+	TM_PROFILER_END_FUNC_SCOPE();
+}
+
+// Returns the block compressed format used for a decoded image, see
+// `tm_ig_glb_import_settings_t.compress_textures`.
+static uint32_t compressed_mip_format(const decode_image_job_t *image, uint32_t quality)
+{
+	if (!image->srgb)
+		return image->normal_map ? TM_IG_GLB_MIP_FORMAT_BC5 : TM_IG_GLB_MIP_FORMAT_BC1;
+	if (quality == TM_IG_GLB_COMPRESSION_QUALITY_FAST)
+		return image->has_alpha ? TM_IG_GLB_MIP_FORMAT_BC3 : TM_IG_GLB_MIP_FORMAT_BC1;
+	return TM_IG_GLB_MIP_FORMAT_BC7;
+}
+
+static enum bc_format bc_format_from_mip_format(uint32_t format)
+{
+	switch (format) {
+	case TM_IG_GLB_MIP_FORMAT_BC3:
+		return BC_FORMAT_BC3;
+	case TM_IG_GLB_MIP_FORMAT_BC5:
+		return BC_FORMAT_BC5;
+	case TM_IG_GLB_MIP_FORMAT_BC7:
+		return BC_FORMAT_BC7;
+	default:
+		return BC_FORMAT_BC1;
+	}
+}
+
+// Block compresses the mip chains of the decoded images and replaces the RGBA8 chains with the
+// compressed ones. The levels are split into jobs of `COMPRESS_BLOCK_ROWS` block rows, so large
+// images are spread over all cores as well.
+static void compress_images(decode_image_job_t **images, uint32_t num_images, const tm_ig_glb_import_settings_t *settings, struct tm_temp_allocator_i *ta)
+{
+	TM_GET_TEMP_ALLOCATOR_ADAPTER(ta, a);
+
+	const uint32_t quality = settings->compression_quality <= TM_IG_GLB_COMPRESSION_QUALITY_HIGH ? settings->compression_quality : TM_IG_GLB_COMPRESSION_QUALITY_HIGH;
+	tm_jobdecl_t *jobs = NULL;
+	compress_job_t *compress_jobs = NULL;
+	for (uint32_t i = 0; i < num_images; ++i) {
+		decode_image_job_t *image = images[i];
+		if (!image->decoded)
+			continue;
+
+		const tm_ig_glb_mip_chain_t *mips = image->mips;
+		tm_ig_glb_mip_chain_t header = *mips;
+		header.format = compressed_mip_format(image, quality);
+		const enum bc_format format = bc_format_from_mip_format(header.format);
+
+		uint64_t bytes = sizeof(header);
+		uint32_t width = mips->width, height = mips->height;
+		for (uint32_t m = 0; m < header.num_mips; ++m) {
+			header.mip_offsets[m] = bytes;
+			bytes += bc_image_size(format, width, height);
+			width = width > 1 ? width / 2 : 1;
+			height = height > 1 ? height / 2 : 1;
+		}
+
+		tm_ig_glb_mip_chain_t *compressed = tm_alloc(a, bytes);
+		*compressed = header;
+
+		width = mips->width;
+		height = mips->height;
+		for (uint32_t m = 0; m < header.num_mips; ++m) {
+			const uint32_t block_rows = (height + 3) / 4;
+			for (uint32_t row = 0; row < block_rows; row += COMPRESS_BLOCK_ROWS) {
+				const compress_job_t job = {
+					.rgba = (const uint8_t *)mips + mips->mip_offsets[m],
+					.out = (uint8_t *)compressed + header.mip_offsets[m],
+					.width = width,
+					.height = height,
+					.first_block_row = row,
+					.num_block_rows = block_rows - row < COMPRESS_BLOCK_ROWS ? block_rows - row : COMPRESS_BLOCK_ROWS,
+					.format = format,
+					.quality = quality,
+				};
+				tm_carray_temp_push(compress_jobs, job, ta);
+			}
+			width = width > 1 ? width / 2 : 1;
+			height = height > 1 ? height / 2 : 1;
+		}
+
+		image->mips = compressed;
+		image->mips_bytes = bytes;
 	}
 
-	char *image_name = texture->image->name;
+	const uint32_t num_jobs = (uint32_t)tm_carray_size(compress_jobs);
+	tm_carray_temp_resize(jobs, num_jobs, ta);
+	for (uint32_t i = 0; i < num_jobs; ++i)
+		jobs[i] = (tm_jobdecl_t){ .task = compress_job, .data = compress_jobs + i };
+	if (num_jobs)
+		tm_job_system_api->wait_for_counter_and_free(tm_job_system_api->run_jobs(jobs, num_jobs));
+}
+
+// Buffer objects keyed by the murmur hash of their content, shared by all imports into the same
+// Truth. The index is built from the dcc_asset buffers in the Truth the first time it is imported
+// into and every successful import adds its new buffers to it. The buffer objects, rather than
+// the buffer ids, are stored so that entries of deleted assets can be detected with `is_alive()`.
+static struct
+{
+	tm_critical_section_o lock;
+	struct tm_allocator_i *allocator;
+	struct tm_the_truth_o *tt;
+	name_to_id_t objects;
+} shared_buffers;
+
+void tm_ig_glb_init_buffer_store(struct tm_allocator_i *a)
+{
+	tm_thread_api->create_critical_section(&shared_buffers.lock);
+	shared_buffers.allocator = a;
+	shared_buffers.objects = (name_to_id_t){ .allocator = a };
+}
+
+void tm_ig_glb_shutdown_buffer_store(void)
+{
+	tm_hash_free(&shared_buffers.objects);
+	tm_thread_api->destroy_critical_section(&shared_buffers.lock);
+	shared_buffers.objects = (name_to_id_t){ 0 };
+	shared_buffers.tt = NULL;
+}
+
+// Builds an index of the buffer objects of `tt`. Buffers that aren't loaded can't be hashed and
+// are left out. Hashing all the buffers takes a while, so this is done without the lock held and
+// the result is swapped in afterwards.
+static name_to_id_t shared_buffers_build(struct tm_the_truth_o *tt, struct tm_temp_allocator_i *ta)
+{
+	tm_buffers_i *buffers = tm_the_truth_api->buffers(tt);
+	name_to_id_t index = { .allocator = shared_buffers.allocator };
+
+	const tm_tt_id_t *objects = tm_the_truth_api->all_objects_of_type(tt, dcc_asset_ti->buffer_type, ta);
+	for (uint64_t i = 0; i < tm_carray_size(objects); ++i) {
+		const uint32_t id = tm_the_truth_api->get_buffer_id(tt, tm_tt_read(tt, objects[i]), TM_TT_PROP__DCC_ASSET_BUFFER__DATA);
+		uint64_t size = 0;
+		const void *data = id ? buffers->get(buffers->inst, id, &size) : NULL;
+		if (data)
+			tm_hash_add(&index, tm_murmur_hash_64a(data, size, 0), objects[i]);
+	}
+	return index;
+}
+
+// Truth buffers of a single import keyed by the murmur hash of their content. Identical payloads
+// are shared within the import and with the buffers of earlier imports into the same Truth, so a
+// body mesh or texture library used by many assets is stored once.
+typedef struct buffer_store_t
+{
+	struct tm_the_truth_o *tt;
+	tm_buffers_i *buffers;
+	hash_to_index_t ids;
+} buffer_store_t;
+
+static void buffer_store_init(buffer_store_t *store, struct tm_the_truth_o *tt, struct tm_allocator_i *a, struct tm_temp_allocator_i *ta)
+{
+	*store = (buffer_store_t){ .tt = tt, .buffers = tm_the_truth_api->buffers(tt), .ids = { .allocator = a } };
+	tm_thread_api->enter_critical_section(&shared_buffers.lock);
+	const bool stale = shared_buffers.tt != tt;
+	tm_thread_api->leave_critical_section(&shared_buffers.lock);
+	if (!stale)
+		return;
+
+	// Another import into `tt` may have swapped in its index while this one was built.
+	name_to_id_t index = shared_buffers_build(tt, ta);
+	tm_thread_api->enter_critical_section(&shared_buffers.lock);
+	if (shared_buffers.tt != tt) {
+		name_to_id_t old = shared_buffers.objects;
+		shared_buffers.objects = index;
+		shared_buffers.tt = tt;
+		index = old;
+	}
+	tm_thread_api->leave_critical_section(&shared_buffers.lock);
+	tm_hash_free(&index);
+}
+
+// Returns the id of a buffer in the Truth whose content matches `data` and `hash`, or 0.
+static uint32_t buffer_store_find(buffer_store_t *store, const void *data, uint64_t size, uint64_t hash)
+{
+	uint32_t id = tm_hash_get(&store->ids, hash);
+	if (!id) {
+		tm_thread_api->enter_critical_section(&shared_buffers.lock);
+		const tm_tt_id_t object = tm_hash_get(&shared_buffers.objects, hash);
+		tm_thread_api->leave_critical_section(&shared_buffers.lock);
+		if (object.u64 && tm_the_truth_api->is_alive(store->tt, object))
+			id = tm_the_truth_api->get_buffer_id(store->tt, tm_tt_read(store->tt, object), TM_TT_PROP__DCC_ASSET_BUFFER__DATA);
+	}
+
+	// Hash collisions and buffers that aren't loaded don't match.
+	uint64_t existing_size = 0;
+	const void *existing_data = id ? store->buffers->get(store->buffers->inst, id, &existing_size) : NULL;
+	return existing_data && existing_size == size && memcmp(existing_data, data, size) == 0 ? id : 0;
+}
+
+// Adds `data`, allocated with `buffers->allocate()`, to the Truth buffers and returns its id. If
+// a buffer with the same content already exists, `data` is released and the existing buffer is
+// returned instead. Either way the caller owns one reference to the returned buffer.
+static uint32_t buffer_store_add(buffer_store_t *store, void *data, uint64_t size)
+{
+	tm_buffers_i *buffers = store->buffers;
+	const uint64_t hash = tm_murmur_hash_64a(data, size, 0);
+	const uint32_t id = buffers->add(buffers->inst, data, size, hash);
+	const uint32_t existing = buffer_store_find(store, data, size, hash);
+	if (existing) {
+		buffers->release(buffers->inst, id);
+		buffers->retain(buffers->inst, existing);
+		return existing;
+	}
+	tm_hash_update(&store->ids, hash, id);
+	return id;
+}
+
+// Adds the buffers created by the import to the shared index, once the import has succeeded and
+// `obj` holds their buffer objects.
+static void buffer_store_publish(buffer_store_t *store, struct tm_the_truth_object_o *obj, struct tm_temp_allocator_i *ta)
+{
+	struct tm_the_truth_o *tt = store->tt;
+	TM_GET_TEMP_ALLOCATOR_ADAPTER(ta, a);
+	name_to_id_t object_by_buffer = { .allocator = a };
+	const tm_tt_id_t *objects = tm_the_truth_api->get_subobject_set(tt, obj, TM_TT_PROP__DCC_ASSET__BUFFERS, ta);
+	for (uint64_t i = 0; i < tm_carray_size(objects); ++i) {
+		const uint32_t id = tm_the_truth_api->get_buffer_id(tt, tm_tt_read(tt, objects[i]), TM_TT_PROP__DCC_ASSET_BUFFER__DATA);
+		if (id)
+			tm_hash_add(&object_by_buffer, id, objects[i]);
+	}
+
+	tm_thread_api->enter_critical_section(&shared_buffers.lock);
+	if (shared_buffers.tt == tt) {
+		for (uint32_t i = 0; i < store->ids.num_buckets; ++i) {
+			if (!tm_hash_use_index(&store->ids, i))
+				continue;
+			const tm_tt_id_t object = tm_hash_get(&object_by_buffer, store->ids.values[i]);
+			const tm_tt_id_t previous = tm_hash_get(&shared_buffers.objects, store->ids.keys[i]);
+			if (object.u64 && !(previous.u64 && tm_the_truth_api->is_alive(tt, previous)))
+				tm_hash_update(&shared_buffers.objects, store->ids.keys[i], object);
+		}
+	}
+	tm_thread_api->leave_critical_section(&shared_buffers.lock);
+}
+
+// Returns a reference to a Truth buffer holding a copy of `data`, see `buffer_store_add()`.
+static uint32_t buffer_store_copy(buffer_store_t *store, const void *data, uint64_t size)
+{
+	uint8_t *buffer_data = store->buffers->allocate(store->buffers->inst, size, 0);
+	memcpy(buffer_data, data, size);
+	return buffer_store_add(store, buffer_data, size);
+}
+
+// Creates a dcc_asset buffer object named `name` in `obj` that takes over the reference to the
+// Truth buffer `buffer_id`.
+static tm_tt_id_t add_buffer_object(struct tm_the_truth_o *tt, struct tm_the_truth_object_o *obj, const char *name, uint32_t buffer_id)
+{
+	const tm_tt_id_t buf_id = tm_the_truth_api->create_object_of_type(tt, dcc_asset_ti->buffer_type, TM_TT_NO_UNDO_SCOPE);
+	tm_the_truth_object_o *buf_o = tm_the_truth_api->write(tt, buf_id);
+	tm_the_truth_api->set_string(tt, buf_o, TM_TT_PROP__DCC_ASSET_BUFFER__NAME, name);
+	tm_the_truth_api->set_buffer(tt, buf_o, TM_TT_PROP__DCC_ASSET_BUFFER__DATA, buffer_id);
+	tm_the_truth_api->add_to_subobject_set(tt, obj, TM_TT_PROP__DCC_ASSET__BUFFERS, &buf_o, 1);
+	tm_the_truth_api->commit(tt, buf_o, TM_TT_NO_UNDO_SCOPE);
+	return buf_id;
+}
+
+// Creates a dcc_asset buffer object named `name` in `obj` that holds a copy of `data`.
+static tm_tt_id_t add_buffer(struct tm_the_truth_o *tt, buffer_store_t *store, struct tm_the_truth_object_o *obj, const char *name, const void *data, uint64_t size)
+{
+	return add_buffer_object(tt, obj, name, buffer_store_copy(store, data, size));
+}
+
+// Decodes the images set up by `prepare_images()`, block compresses them if `compress_textures` is
+// set and stores the resulting mip chains in Truth buffers. The images are decoded and compressed
+// in parallel, one batch of at most `DECODE_BATCH_BYTES` at a time, and the uncompressed chains of
+// a batch are freed before the next batch is decoded.
+static void decode_images(decode_image_job_t *images, uint64_t num_images, const tm_ig_glb_import_settings_t *settings, buffer_store_t *store)
+{
+	uint64_t next = 0;
+	while (next < num_images) {
+		TM_INIT_TEMP_ALLOCATOR(ta);
+		TM_GET_TEMP_ALLOCATOR_ADAPTER(ta, a);
+
+		decode_image_job_t **batch = NULL;
+		tm_jobdecl_t *jobs = NULL;
+		uint64_t batch_bytes = 0;
+		for (; next < num_images; ++next) {
+			decode_image_job_t *image = images + next;
+			if (!image->mips_bytes)
+				continue;
+			if (batch_bytes && batch_bytes + image->mips_bytes > DECODE_BATCH_BYTES)
+				break;
+
+			batch_bytes += image->mips_bytes;
+			image->mips = tm_alloc(a, image->mips_bytes);
+			*image->mips = image->header;
+			tm_carray_temp_push(batch, image, ta);
+			tm_carray_temp_push(jobs, ((tm_jobdecl_t){ .task = decode_image_job, .data = image }), ta);
+		}
+
+		const uint32_t num_jobs = (uint32_t)tm_carray_size(jobs);
+		if (num_jobs)
+			tm_job_system_api->wait_for_counter_and_free(tm_job_system_api->run_jobs(jobs, num_jobs));
+
+		if (settings->compress_textures)
+			compress_images(batch, num_jobs, settings, ta);
+
+		for (uint32_t i = 0; i < num_jobs; ++i) {
+			if (batch[i]->decoded)
+				batch[i]->mips_buffer = buffer_store_copy(store, batch[i]->mips, batch[i]->mips_bytes);
+			batch[i]->mips = NULL;
+		}
+
+		TM_SHUTDOWN_TEMP_ALLOCATOR(ta);
+	}
+}
+
+// Per image state of an import, indexed by the cgltf image index.
+typedef struct image_table_t
+{
+	// Index of the first image with the same content, see `dedup_images()`. Only these images
+	// are imported.
+	const uint32_t *first;
+
+	// Imported image objects, created by the first texture that uses the image.
+	tm_tt_id_t *ids;
+
+	// Decoded mip chains, NULL unless `decode_images` is set.
+	const decode_image_job_t *decoded;
+} image_table_t;
+
+static tm_tt_id_t extract_texture(struct tm_the_truth_o *tt, image_table_t *images, buffer_store_t *store, struct tm_the_truth_object_o *obj, 
+	const struct cgltf_data *data, const struct cgltf_material *material, uint32_t type,
+	struct tm_temp_allocator_i *ta, struct tm_error_i *error)
+{
+	const cgltf_texture *texture = material_texture(material, type);
+	if (!texture)
+		return (tm_tt_id_t) { 0 };
+
+	const cgltf_int texture_image = texture_image_index(data, texture);
+	if (texture_image < 0)
+		return (tm_tt_id_t) { 0 };
+	const uint32_t image_index = images->first[texture_image];
+	const cgltf_image *source_image = data->images + image_index;
+
+	char *image_name = source_image->name;
 
 	if (image_name == NULL || strlen(image_name) == 0) {
-		image_name = tm_temp_allocator_api->printf(ta, "*.%d", texture->image_index);
+		image_name = tm_temp_allocator_api->printf(ta, "*.%d", image_index);
 	}
 
-	uint64_t path_hash = tm_murmur_hash_string(image_name);
-	tm_tt_id_t *image = tm_hash_add_reference(image_lookup, path_hash);
+	tm_tt_id_t *image = images->ids + image_index;
 	if (!image->u64) {
-		tm_buffers_i *buffers = tm_the_truth_api->buffers(tt);
 		tm_tt_id_t tm_image_id = tm_the_truth_api->create_object_of_type(tt, dcc_asset_ti->image_type, TM_TT_NO_UNDO_SCOPE);
 		tm_the_truth_object_o *tm_image = tm_the_truth_api->write(tt, tm_image_id);
 
 		tm_the_truth_api->set_string(tt, tm_image, TM_TT_PROP__DCC_ASSET_IMAGE__NAME, image_name);
 
-		const char *mime_type = texture->image->mime_type;
-		if (strcmp(mime_type, "image\\/png") == 0) {
-			tm_the_truth_api->set_uint32_t(tt, tm_image, TM_TT_PROP__DCC_ASSET_IMAGE__TYPE, TM_TT_VALUE__DCC_ASSET_IMAGE__TYPE__PNG);
-		} else {
-			tm_the_truth_api->set_uint32_t(tt, tm_image, TM_TT_PROP__DCC_ASSET_IMAGE__TYPE, TM_TT_VALUE__DCC_ASSET_IMAGE__TYPE__UNKNOWN);
-		}
-
-		const cgltf_buffer_view* buffer_view = texture->image->buffer_view;
-		uint8_t *buffer_data = buffers->allocate(buffers->inst, buffer_view->size, 0);
-		memcpy(buffer_data, (uint8_t*)(buffer_view->buffer->data) + buffer_view->offset, buffer_view->size);
-		const uint32_t buffer_id = buffers->add(buffers->inst, buffer_data, buffer_view->size, 0);
-
-		const tm_tt_id_t buf_id = tm_the_truth_api->create_object_of_type(tt, dcc_asset_ti->buffer_type, TM_TT_NO_UNDO_SCOPE);
-		tm_the_truth_object_o *buf_o = tm_the_truth_api->write(tt, buf_id);
-		tm_the_truth_api->set_string(tt, buf_o, TM_TT_PROP__DCC_ASSET_BUFFER__NAME, tm_temp_allocator_api->printf(ta, "image.%s", image_name));
-		tm_the_truth_api->set_buffer(tt, buf_o, TM_TT_PROP__DCC_ASSET_BUFFER__DATA, buffer_id);
-		tm_the_truth_api->add_to_subobject_set(tt, obj, TM_TT_PROP__DCC_ASSET__BUFFERS, &buf_o, 1);
-		tm_the_truth_api->commit(tt, buf_o, TM_TT_NO_UNDO_SCOPE);
+		const cgltf_buffer_view* buffer_view = source_image->buffer_view;
+		const uint8_t *source_data = (uint8_t*)(buffer_view->buffer->data) + buffer_view->offset;
+		tm_the_truth_api->set_uint32_t(tt, tm_image, TM_TT_PROP__DCC_ASSET_IMAGE__TYPE, image_type(source_image, source_data, buffer_view->size));
 
+		const tm_tt_id_t buf_id = add_buffer(tt, store, obj, tm_temp_allocator_api->printf(ta, "image.%s", image_name), source_data, buffer_view->size);
 		tm_the_truth_api->set_reference(tt, tm_image, TM_TT_PROP__DCC_ASSET_IMAGE__BUFFER, buf_id);
 
+		const decode_image_job_t *decoded = images->decoded ? images->decoded + image_index : NULL;
+		if (decoded && decoded->mips_buffer)
+			add_buffer_object(tt, obj, tm_temp_allocator_api->printf(ta, "mips.%s", image_name), decoded->mips_buffer);
+
 		tm_the_truth_api->add_to_subobject_set(tt, obj, TM_TT_PROP__DCC_ASSET__IMAGES, &tm_image, 1);
 		tm_the_truth_api->commit(tt, tm_image, TM_TT_NO_UNDO_SCOPE);
 		*image = tm_image_id;
@@ -318,8 +1345,8 @@ static tm_tt_id_t extract_texture(struct tm_the_truth_o *tt, name_to_id_t *image
 }
 
 static bool import_into(struct tm_the_truth_o *tt, struct tm_the_truth_object_o *obj, const struct cgltf_data *data,
-	const char *scene_name, const char *asset_path, struct tm_temp_allocator_i *ta, struct tm_error_i *error,
-	uint64_t task_id)
+	const char *scene_name, const char *asset_path, const tm_ig_glb_import_settings_t *settings,
+	struct tm_temp_allocator_i *ta, struct tm_error_i *error, uint64_t task_id)
 {
 	const tm_tt_type_t dcc_asset_scene_type = tm_the_truth_api->object_type_from_name_hash(tt, TM_TT_TYPE_HASH__DCC_ASSET_SCENE);
 	const tm_tt_id_t scene_id = tm_the_truth_api->create_object_of_type(tt, dcc_asset_scene_type, TM_TT_NO_UNDO_SCOPE);
@@ -333,7 +1360,25 @@ static bool import_into(struct tm_the_truth_o *tt, struct tm_the_truth_object_o
 	tm_buffers_i *buffers = tm_the_truth_api->buffers(tt);
 	TM_GET_TEMP_ALLOCATOR_ADAPTER(ta, a);
 
-	name_to_id_t image_lookup = { .allocator = a };
+	tm_tt_id_t *image_ids = NULL;
+	tm_carray_temp_resize(image_ids, data->images_count, ta);
+	memset(image_ids, 0, data->images_count * sizeof(*image_ids));
+	image_table_t images = { .first = dedup_images(data, ta), .ids = image_ids };
+
+	buffer_store_t buffer_store;
+	buffer_store_init(&buffer_store, tt, a, ta);
+
+	if (tm_task_system_api->is_task_canceled(task_id))
+		return false;
+
+	// Decoded images
+	decode_image_job_t *decoded_images = NULL;
+	if (settings->decode_images && data->images_count) {
+		tm_progress_report_api->set_task_progress(task_id, tm_temp_allocator_api->printf(ta, "%s - decoding images..", scene_name), 0.f);
+		decoded_images = prepare_images(data, images.first, settings, ta);
+		decode_images(decoded_images, data->images_count, settings, &buffer_store);
+		images.decoded = decoded_images;
+	}
 
 	if (tm_task_system_api->is_task_canceled(task_id))
 		return false;
@@ -377,7 +1422,7 @@ static bool import_into(struct tm_the_truth_o *tt, struct tm_the_truth_object_o
 		tm_the_truth_object_o *tm_pbr_mr = tm_the_truth_api->write(tt, tm_the_truth_api->create_object_of_type(tt, dcc_asset_ti->pbr_mr_type, TM_TT_NO_UNDO_SCOPE));
 		if (material->has_pbr_metallic_roughness) {
 			// TODO: Uncomment following disables asset preview for some reason
-			//tm_tt_id_t texture = extract_texture(tt, &image_lookup, obj, &material, TM_TT_PROP__DCC_ASSET_MATERIAL_PBR_MR__METALLIC_ROUGHNESS_TEXTURE, ta, error);
+			//tm_tt_id_t texture = extract_texture(tt, &images, &buffer_store, obj, data, &material, TM_TT_PROP__DCC_ASSET_MATERIAL_PBR_MR__METALLIC_ROUGHNESS_TEXTURE, ta, error);
 			//if (texture.u64) {
 			//	tm_the_truth_api->set_subobject_id(tt, tm_pbr_mr, TM_TT_PROP__DCC_ASSET_MATERIAL_PBR_MR__METALLIC_ROUGHNESS_TEXTURE, texture, TM_TT_NO_UNDO_SCOPE);
 			//}
@@ -401,9 +1446,8 @@ static bool import_into(struct tm_the_truth_o *tt, struct tm_the_truth_object_o
 		tm_the_truth_api->set_subobject(tt, tm_material, TM_TT_PROP__DCC_ASSET_MATERIAL__BASE_COLOR_FACTOR, tm_color);
 		tm_the_truth_api->commit(tt, tm_color, TM_TT_NO_UNDO_SCOPE);
 
-		const uint32_t tm_texture_properties[] = { TM_TT_PROP__DCC_ASSET_MATERIAL__BASE_COLOR_TEXTURE, TM_TT_PROP__DCC_ASSET_MATERIAL__NORMAL_TEXTURE, TM_TT_PROP__DCC_ASSET_MATERIAL__EMISSIVE_TEXTURE };
 		for (uint32_t t = 0; t != TM_ARRAY_COUNT(tm_texture_properties); ++t) {
-			tm_tt_id_t texture = extract_texture(tt, &image_lookup, obj, material, tm_texture_properties[t], ta, error);
+			tm_tt_id_t texture = extract_texture(tt, &images, &buffer_store, obj, data, material, tm_texture_properties[t], ta, error);
 			if (texture.u64)
 				tm_the_truth_api->set_subobject_id(tt, tm_material, tm_texture_properties[t], texture, TM_TT_NO_UNDO_SCOPE);
 		}
@@ -415,6 +1459,50 @@ static bool import_into(struct tm_the_truth_o *tt, struct tm_the_truth_object_o
 	const tm_tt_id_t *tm_materials = tm_the_truth_api->get_subobject_set(tt, obj, TM_TT_PROP__DCC_ASSET__MATERIALS, ta);
 	uint32_t n_materials = (uint32_t)tm_carray_size(tm_materials);
 
+	if (tm_task_system_api->is_task_canceled(task_id))
+		return false;
+
+	// LODs and meshlets
+	primitive_job_t *primitive_jobs = NULL;
+	uint32_t *first_primitive_job = NULL;
+	if (settings->lod_count > 0 || settings->generate_meshlets) {
+		tm_progress_report_api->set_task_progress(task_id, tm_temp_allocator_api->printf(ta, "%s - processing primitives..", scene_name), 0.f);
+		tm_carray_temp_resize(first_primitive_job, data->meshes_count, ta);
+		const uint32_t lod_count = settings->lod_count < MAX_LOD_COUNT ? settings->lod_count : MAX_LOD_COUNT;
+		for (cgltf_size i = 0; i < data->meshes_count; ++i) {
+			const cgltf_mesh *mesh = &data->meshes[i];
+			first_primitive_job[i] = (uint32_t)tm_carray_size(primitive_jobs);
+			for (cgltf_size j = 0; j < mesh->primitives_count; ++j) {
+				const cgltf_primitive *primitive = &mesh->primitives[j];
+				primitive_job_t job = { .primitive = primitive, .settings = settings };
+				bool has_positions = false;
+				for (cgltf_size k = 0; k < primitive->attributes_count; ++k)
+					has_positions = has_positions || (primitive->attributes[k].type == cgltf_attribute_type_position && primitive->attributes[k].data->count <= UINT32_MAX);
+				if (primitive->type == cgltf_primitive_type_triangles && primitive->indices != NULL && has_positions) {
+					const uint32_t num_indices = (uint32_t)primitive->indices->count;
+					if (lod_count)
+						job.lod_indices = tm_alloc(a, (uint64_t)lod_count * num_indices * sizeof(uint32_t));
+					if (settings->generate_meshlets) {
+						const uint32_t bound = meshlets_bound(num_indices, meshlet_max_vertices(settings), meshlet_max_triangles(settings));
+						job.meshlets = tm_alloc(a, bound * sizeof(meshlet_t));
+						job.meshlet_bounds = tm_alloc(a, bound * sizeof(meshlet_bounds_t));
+						job.meshlet_vertices = tm_alloc(a, num_indices * sizeof(uint32_t));
+						job.meshlet_triangles = tm_alloc(a, num_indices);
+					}
+				}
+				tm_carray_temp_push(primitive_jobs, job, ta);
+			}
+		}
+
+		const uint32_t num_primitive_jobs = (uint32_t)tm_carray_size(primitive_jobs);
+		tm_jobdecl_t *jobs = NULL;
+		tm_carray_temp_resize(jobs, num_primitive_jobs, ta);
+		for (uint32_t i = 0; i < num_primitive_jobs; ++i)
+			jobs[i] = (tm_jobdecl_t){ .task = process_primitive_job, .data = primitive_jobs + i };
+		if (num_primitive_jobs)
+			tm_job_system_api->wait_for_counter_and_free(tm_job_system_api->run_jobs(jobs, num_primitive_jobs));
+	}
+
 	if (tm_task_system_api->is_task_canceled(task_id))
 		return false;
 
@@ -432,6 +1520,14 @@ static bool import_into(struct tm_the_truth_o *tt, struct tm_the_truth_object_o
 		// Used to keep reference to tm_mesh
 		mesh->ext_0 = tt_total_mesh_count;
 
+		// LOD levels of the primitives, imported after all the primitives of the mesh so that the
+		// primitives keep consecutive mesh indices.
+		lod_mesh_t *lod_meshes = NULL;
+
+		// Meshlets of the primitives, referenced from the meshes once the LOD meshes have been
+		// cloned from them.
+		meshlet_mesh_t *meshlet_meshes = NULL;
+
 		for (cgltf_size j = 0; j < mesh->primitives_count; ++j) {
 			const tm_tt_id_t mesh_id = tm_the_truth_api->create_object_of_type(tt, dcc_asset_ti->mesh_type, TM_TT_NO_UNDO_SCOPE);
 			tm_the_truth_object_o *tm_mesh = tm_the_truth_api->write(tt, mesh_id);
@@ -451,37 +1547,91 @@ static bool import_into(struct tm_the_truth_o *tt, struct tm_the_truth_object_o
 				tm_the_truth_object_o *idata = tm_the_truth_api->write(tt, idata_id);
 				tm_the_truth_api->set_string(tt, idata, TM_TT_PROP__DCC_ASSET_BUFFER__NAME, tm_temp_allocator_api->printf(ta, "ibuf.%s", mesh->name));
 
-				size_t ibuf_size = primitive->indices->count * sizeof(uint32_t);
+				// The LOD levels are stored after the indices of the primitive in the same buffer.
+				const primitive_job_t *primitive_job = primitive_jobs ? primitive_jobs + first_primitive_job[mesh - data->meshes] + j : NULL;
+				if (primitive_job && primitive_job->invalid_indices)
+					TM_ERROR(tm_error_api->def, "Indices of mesh: %s exceed its vertex count, skipping LODs and meshlets!", mesh->name);
+				const uint32_t num_lods = primitive_job ? primitive_job->num_lods : 0;
+				uint32_t num_indices = (uint32_t)primitive->indices->count;
+				for (uint32_t l = 0; l < num_lods; ++l)
+					num_indices += primitive_job->lod_counts[l];
+
+				size_t ibuf_size = num_indices * sizeof(uint32_t);
 				uint32_t *data_start = buffers->allocate(buffers->inst, ibuf_size, 0);
 				uint32_t *indices_data = data_start;
 				for (cgltf_size k = 0; k < primitive->indices->count; ++k) {
 					indices_data[k] = (uint32_t)cgltf_accessor_read_index(primitive->indices, k);
 				}
-				const uint32_t ibuf_id = buffers->add(buffers->inst, data_start, ibuf_size, 0);
+				uint32_t lod_offset = (uint32_t)primitive->indices->count;
+				for (uint32_t l = 0; l < num_lods; ++l) {
+					memcpy(indices_data + lod_offset, primitive_job->lod_indices + l * primitive->indices->count, primitive_job->lod_counts[l] * sizeof(uint32_t));
+					lod_offset += primitive_job->lod_counts[l];
+				}
+				const uint32_t ibuf_id = buffer_store_add(&buffer_store, data_start, ibuf_size);
 
 				tm_the_truth_api->set_buffer(tt, idata, TM_TT_PROP__DCC_ASSET_BUFFER__DATA, ibuf_id);
 				tm_the_truth_api->add_to_subobject_set(tt, obj, TM_TT_PROP__DCC_ASSET__BUFFERS, &idata, 1);
 				tm_the_truth_api->commit(tt, idata, TM_TT_NO_UNDO_SCOPE);
 
-				const tm_tt_id_t access_id = tm_the_truth_api->create_object_of_type(tt, dcc_asset_ti->accessor_type, TM_TT_NO_UNDO_SCOPE);
-				tm_the_truth_object_o *access = tm_the_truth_api->write(tt, access_id);
-				tm_the_truth_api->set_uint32_t(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__OFFSET, 0);
-				tm_the_truth_api->set_uint32_t(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__COUNT, (uint32_t)primitive->indices->count);
-				tm_the_truth_api->set_bool(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__IS_FLOAT, false);
-				tm_the_truth_api->set_bool(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__IS_SIGNED, false);
-				tm_the_truth_api->set_bool(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__IS_NORMALIZED, false);
-				tm_the_truth_api->set_uint32_t(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__BITS, 32);
-				tm_the_truth_api->set_uint32_t(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__COMPONENT_COUNT, 1);
-				tm_the_truth_api->set_reference(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__BUFFER, idata_id);
-				tm_the_truth_api->add_to_subobject_set(tt, obj, TM_TT_PROP__DCC_ASSET__ACCESSORS, &access, 1);
-				tm_the_truth_api->commit(tt, access, TM_TT_NO_UNDO_SCOPE);
+				const tm_tt_id_t access_id = add_accessor(tt, obj, idata_id, 0, (uint32_t)primitive->indices->count, (vertex_format_t){ .bits = 32, .component_count = 1 }, 0);
 				tm_the_truth_api->set_reference(tt, tm_mesh, TM_TT_PROP__DCC_ASSET_MESH__INDICES, access_id);
+
+				lod_offset = (uint32_t)primitive->indices->count;
+				for (uint32_t l = 0; l < num_lods; ++l) {
+					const lod_mesh_t lod_mesh = {
+						.mesh_id = mesh_id,
+						.indices = add_accessor(tt, obj, idata_id, lod_offset * sizeof(uint32_t), primitive_job->lod_counts[l], (vertex_format_t){ .bits = 32, .component_count = 1 }, 0),
+						.primitive = (uint32_t)j,
+						.level = l + 1,
+					};
+					tm_carray_temp_push(lod_meshes, lod_mesh, ta);
+					lod_offset += primitive_job->lod_counts[l];
+				}
+
+				// Meshlets: descriptors, bounds, vertex indices and local triangles in one buffer,
+				// with an accessor for each section.
+				const uint32_t num_meshlets = primitive_job ? primitive_job->num_meshlets : 0;
+				const uint64_t bounds_offset = (uint64_t)num_meshlets * sizeof(meshlet_t);
+				const uint64_t vertices_offset = bounds_offset + (uint64_t)num_meshlets * sizeof(meshlet_bounds_t);
+				const uint64_t triangles_offset = vertices_offset + (num_meshlets ? (uint64_t)primitive_job->num_meshlet_vertices * sizeof(uint32_t) : 0);
+				if (triangles_offset > UINT32_MAX) {
+					TM_ERROR(tm_error_api->def, "Meshlets of mesh: %s exceed the 32-bit accessor offsets, skipping!", mesh->name);
+				} else if (num_meshlets) {
+					const uint64_t mbuf_size = triangles_offset + (((uint64_t)primitive_job->num_meshlet_triangles * 3 + 3) & ~3ull);
+
+					const tm_tt_id_t mdata_id = tm_the_truth_api->create_object_of_type(tt, dcc_asset_ti->buffer_type, TM_TT_NO_UNDO_SCOPE);
+					tm_the_truth_object_o *mdata = tm_the_truth_api->write(tt, mdata_id);
+					tm_the_truth_api->set_string(tt, mdata, TM_TT_PROP__DCC_ASSET_BUFFER__NAME, tm_temp_allocator_api->printf(ta, "meshlets.%s.%d", mesh->name, j));
+
+					uint8_t *mbuf_data = buffers->allocate(buffers->inst, mbuf_size, 0);
+					memset(mbuf_data, 0, mbuf_size);
+					memcpy(mbuf_data, primitive_job->meshlets, num_meshlets * sizeof(meshlet_t));
+					memcpy(mbuf_data + bounds_offset, primitive_job->meshlet_bounds, num_meshlets * sizeof(meshlet_bounds_t));
+					memcpy(mbuf_data + vertices_offset, primitive_job->meshlet_vertices, (uint64_t)primitive_job->num_meshlet_vertices * sizeof(uint32_t));
+					memcpy(mbuf_data + triangles_offset, primitive_job->meshlet_triangles, (uint64_t)primitive_job->num_meshlet_triangles * 3);
+					const uint32_t mbuf_id = buffer_store_add(&buffer_store, mbuf_data, mbuf_size);
+
+					tm_the_truth_api->set_buffer(tt, mdata, TM_TT_PROP__DCC_ASSET_BUFFER__DATA, mbuf_id);
+					tm_the_truth_api->add_to_subobject_set(tt, obj, TM_TT_PROP__DCC_ASSET__BUFFERS, &mdata, 1);
+					tm_the_truth_api->commit(tt, mdata, TM_TT_NO_UNDO_SCOPE);
+
+					const meshlet_mesh_t meshlet_mesh = {
+						.mesh_id = mesh_id,
+						.accessors = {
+							add_accessor(tt, obj, mdata_id, 0, num_meshlets, (vertex_format_t){ .bits = 32, .component_count = 4 }, 0),
+							add_accessor(tt, obj, mdata_id, (uint32_t)bounds_offset, num_meshlets * 2, (vertex_format_t){ .bits = 32, .component_count = 4, .is_float = true, .is_signed = true }, 0),
+							add_accessor(tt, obj, mdata_id, (uint32_t)vertices_offset, primitive_job->num_meshlet_vertices, (vertex_format_t){ .bits = 32, .component_count = 1 }, 0),
+							add_accessor(tt, obj, mdata_id, (uint32_t)triangles_offset, primitive_job->num_meshlet_triangles, (vertex_format_t){ .bits = 8, .component_count = 3 }, 0),
+						},
+					};
+					tm_carray_temp_push(meshlet_meshes, meshlet_mesh, ta);
+				}
 			}
 
 			const tm_tt_id_t vdata_id = tm_the_truth_api->create_object_of_type(tt, dcc_asset_ti->buffer_type, TM_TT_NO_UNDO_SCOPE);
-			uint32_t vbuf_size = 0;
+			uint64_t vbuf_size = 0;
 			tm_bone_weight_t **skin_data = 0;
-			uint32_t total_weights = 0;
+			uint32_t skin_bits = 32;
 
 			cgltf_accessor *acc_POSITION = NULL;
 			cgltf_accessor *acc_NORMAL = NULL;
@@ -505,6 +1655,13 @@ static bool import_into(struct tm_the_truth_o *tt, struct tm_the_truth_object_o
 				}
 			}
 
+			// Vertex counts are 32-bit in the dcc_asset accessors and the index buffers, larger
+			// primitives have to be split with `split_max_vertices`.
+			if (acc_POSITION != NULL && acc_POSITION->count > UINT32_MAX) {
+				TM_ERROR(tm_error_api->def, "Mesh: %s has more than 2^32 vertices, skipping its vertex data!", mesh->name);
+				acc_POSITION = NULL;
+			}
+
 			uint32_t num_vertices = 0;
 
 			if (acc_POSITION != NULL) {
@@ -607,8 +1764,8 @@ static bool import_into(struct tm_the_truth_o *tt, struct tm_the_truth_object_o
 					}
 				}
 
-				total_weights = num_vertices * 4;
-
+				skin_bits = skin_weight_bits(settings, bone_idx);
+				uint64_t total_skin_data_size = (uint64_t)num_vertices * sizeof(uint32_t);
 				for (uint32_t v = 0; v < num_vertices; ++v) {
 					const uint32_t v_begin = v * 4;
 					for (uint8_t idx = 0; idx < 4; idx++) {
@@ -619,29 +1776,17 @@ static bool import_into(struct tm_the_truth_o *tt, struct tm_the_truth_object_o
 							tm_carray_temp_push(skin_data[v], ((tm_bone_weight_t){.bone_idx = 0, .weight = 0.f }), ta);						
 						}
 					}
+					const uint32_t n = prune_bone_weights(skin_data[v], 4, settings->skin_weight_threshold, settings->skin_max_influences);
+					tm_carray_temp_resize(skin_data[v], n, ta);
+					total_skin_data_size += skin_record_size(n, skin_bits);
 				}
 
-				const uint32_t total_skin_data_size = (num_vertices * sizeof(uint32_t)) + (total_weights * sizeof(tm_bone_weight_t));
 				if (total_skin_data_size < 64 * 1024 * 1024) {
-					tm_the_truth_object_o *attr = tm_the_truth_api->write(tt, tm_the_truth_api->create_object_of_type(tt, dcc_asset_ti->attribute_type, TM_TT_NO_UNDO_SCOPE));
-					tm_the_truth_api->set_uint32_t(tt, attr, TM_TT_PROP__DCC_ASSET_ATTRIBUTE__SEMANTIC, TM_TT_VALUE__DCC_ASSET_VERTEX__SEMANTIC__SKIN_DATA);
-					tm_the_truth_api->set_uint32_t(tt, attr, TM_TT_PROP__DCC_ASSET_ATTRIBUTE__SET, 0);
-
-					const tm_tt_id_t access_id = tm_the_truth_api->create_object_of_type(tt, dcc_asset_ti->accessor_type, TM_TT_NO_UNDO_SCOPE);
-					tm_the_truth_object_o *access = tm_the_truth_api->write(tt, access_id);
-					tm_the_truth_api->set_uint32_t(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__OFFSET, vbuf_size);
-					tm_the_truth_api->set_uint32_t(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__COUNT, num_vertices);
-					tm_the_truth_api->set_bool(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__IS_FLOAT, false);
-					tm_the_truth_api->set_bool(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__IS_SIGNED, false);
-					tm_the_truth_api->set_bool(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__IS_NORMALIZED, false);
-					tm_the_truth_api->set_uint32_t(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__BITS, 32);
-					tm_the_truth_api->set_uint32_t(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__COMPONENT_COUNT, 1);
-					tm_the_truth_api->set_reference(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__BUFFER, vdata_id);
-					tm_the_truth_api->set_reference(tt, attr, TM_TT_PROP__DCC_ASSET_ATTRIBUTE__ACCESSOR, access_id);
-					tm_the_truth_api->add_to_subobject_set(tt, obj, TM_TT_PROP__DCC_ASSET__ACCESSORS, &access, 1);
-					tm_the_truth_api->commit(tt, access, TM_TT_NO_UNDO_SCOPE);
-					tm_the_truth_api->add_to_subobject_set(tt, tm_mesh, TM_TT_PROP__DCC_ASSET_MESH__ATTRIBUTES, &attr, 1);
-					tm_the_truth_api->commit(tt, attr, TM_TT_NO_UNDO_SCOPE);
+					const vertex_format_t skin_format = skin_bits == 32
+						? (vertex_format_t){ .bits = 32, .component_count = 1 }
+						: (vertex_format_t){ .bits = skin_bits, .component_count = 1, .is_normalized = true };
+					const uint32_t skin_semantic = skin_bits == 32 ? TM_TT_VALUE__DCC_ASSET_VERTEX__SEMANTIC__SKIN_DATA : TM_TT_VALUE__DCC_ASSET_VERTEX__SEMANTIC__SKIN_DATA_QUANTIZED;
+					add_vertex_attribute(tt, obj, tm_mesh, skin_semantic, vdata_id, 0, num_vertices, skin_format, 0);
 
 					vbuf_size += total_skin_data_size;
 				} else {
@@ -650,147 +1795,84 @@ static bool import_into(struct tm_the_truth_o *tt, struct tm_the_truth_object_o
 				}
 			}
 
-			if (acc_POSITION != NULL) {
-				tm_the_truth_object_o *attr = tm_the_truth_api->write(tt, tm_the_truth_api->create_object_of_type(tt, dcc_asset_ti->attribute_type, TM_TT_NO_UNDO_SCOPE));
-				tm_the_truth_api->set_uint32_t(tt, attr, TM_TT_PROP__DCC_ASSET_ATTRIBUTE__SEMANTIC, TM_TT_VALUE__DCC_ASSET_VERTEX__SEMANTIC__POSITION);
-				tm_the_truth_api->set_uint32_t(tt, attr, TM_TT_PROP__DCC_ASSET_ATTRIBUTE__SET, 0);
-
-				const tm_tt_id_t access_id = tm_the_truth_api->create_object_of_type(tt, dcc_asset_ti->accessor_type, TM_TT_NO_UNDO_SCOPE);
-				tm_the_truth_object_o *access = tm_the_truth_api->write(tt, access_id);
-				tm_the_truth_api->set_uint32_t(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__OFFSET, vbuf_size);
-				tm_the_truth_api->set_uint32_t(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__COUNT, num_vertices);
-				tm_the_truth_api->set_bool(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__IS_FLOAT, true);
-				tm_the_truth_api->set_bool(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__IS_SIGNED, true);
-				tm_the_truth_api->set_bool(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__IS_NORMALIZED, false);
-				tm_the_truth_api->set_uint32_t(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__BITS, 32);
-				tm_the_truth_api->set_uint32_t(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__COMPONENT_COUNT, 3);
-				tm_the_truth_api->set_reference(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__BUFFER, vdata_id);
-				tm_the_truth_api->set_reference(tt, attr, TM_TT_PROP__DCC_ASSET_ATTRIBUTE__ACCESSOR, access_id);
-				tm_the_truth_api->add_to_subobject_set(tt, obj, TM_TT_PROP__DCC_ASSET__ACCESSORS, &access, 1);
-				tm_the_truth_api->commit(tt, access, TM_TT_NO_UNDO_SCOPE);
-				tm_the_truth_api->add_to_subobject_set(tt, tm_mesh, TM_TT_PROP__DCC_ASSET_MESH__ATTRIBUTES, &attr, 1);
-
-				tm_the_truth_api->commit(tt, attr, TM_TT_NO_UNDO_SCOPE);
-				vbuf_size += num_vertices * sizeof(float) * 3;
-			}
-
-			if (acc_NORMAL != NULL && num_vertices > 0) {
-				tm_the_truth_object_o *attr = tm_the_truth_api->write(tt, tm_the_truth_api->create_object_of_type(tt, dcc_asset_ti->attribute_type, TM_TT_NO_UNDO_SCOPE));
-				tm_the_truth_api->set_uint32_t(tt, attr, TM_TT_PROP__DCC_ASSET_ATTRIBUTE__SEMANTIC, TM_TT_VALUE__DCC_ASSET_VERTEX__SEMANTIC__NORMAL);
-				tm_the_truth_api->set_uint32_t(tt, attr, TM_TT_PROP__DCC_ASSET_ATTRIBUTE__SET, 0);
-
-				const tm_tt_id_t access_id = tm_the_truth_api->create_object_of_type(tt, dcc_asset_ti->accessor_type, TM_TT_NO_UNDO_SCOPE);
-				tm_the_truth_object_o *access = tm_the_truth_api->write(tt, access_id);
-				tm_the_truth_api->set_uint32_t(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__OFFSET, vbuf_size);
-				tm_the_truth_api->set_uint32_t(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__COUNT, num_vertices);
-				tm_the_truth_api->set_bool(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__IS_FLOAT, true);
-				tm_the_truth_api->set_bool(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__IS_SIGNED, true);
-				tm_the_truth_api->set_bool(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__IS_NORMALIZED, false);
-				tm_the_truth_api->set_uint32_t(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__BITS, 32);
-				tm_the_truth_api->set_uint32_t(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__COMPONENT_COUNT, 3);
-				tm_the_truth_api->set_reference(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__BUFFER, vdata_id);
-				tm_the_truth_api->set_reference(tt, attr, TM_TT_PROP__DCC_ASSET_ATTRIBUTE__ACCESSOR, access_id);
-				tm_the_truth_api->add_to_subobject_set(tt, obj, TM_TT_PROP__DCC_ASSET__ACCESSORS, &access, 1);
-				tm_the_truth_api->commit(tt, access, TM_TT_NO_UNDO_SCOPE);
-				tm_the_truth_api->add_to_subobject_set(tt, tm_mesh, TM_TT_PROP__DCC_ASSET_MESH__ATTRIBUTES, &attr, 1);
-
-				tm_the_truth_api->commit(tt, attr, TM_TT_NO_UNDO_SCOPE);
-				vbuf_size += (uint32_t)(acc_NORMAL->count * sizeof(float) * 3);
-			}
-
-			if (acc_TEXCOORD_0 != NULL && num_vertices > 0) {
-				tm_the_truth_object_o *attr = tm_the_truth_api->write(tt, tm_the_truth_api->create_object_of_type(tt, dcc_asset_ti->attribute_type, TM_TT_NO_UNDO_SCOPE));
-				tm_the_truth_api->set_uint32_t(tt, attr, TM_TT_PROP__DCC_ASSET_ATTRIBUTE__SEMANTIC, TM_TT_VALUE__DCC_ASSET_VERTEX__SEMANTIC__TEXCOORD);
-				tm_the_truth_api->set_uint32_t(tt, attr, TM_TT_PROP__DCC_ASSET_ATTRIBUTE__SET, 0);
-
-				const tm_tt_id_t access_id = tm_the_truth_api->create_object_of_type(tt, dcc_asset_ti->accessor_type, TM_TT_NO_UNDO_SCOPE);
-				tm_the_truth_object_o *access = tm_the_truth_api->write(tt, access_id);
-				tm_the_truth_api->set_uint32_t(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__OFFSET, vbuf_size);
-				tm_the_truth_api->set_uint32_t(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__COUNT, num_vertices);
-				tm_the_truth_api->set_bool(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__IS_FLOAT, true);
-				tm_the_truth_api->set_bool(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__IS_SIGNED, true);
-				tm_the_truth_api->set_bool(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__IS_NORMALIZED, false);
-				tm_the_truth_api->set_uint32_t(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__BITS, 32);
-				tm_the_truth_api->set_uint32_t(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__COMPONENT_COUNT, 2);
-				tm_the_truth_api->set_reference(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__BUFFER, vdata_id);
-				tm_the_truth_api->set_reference(tt, attr, TM_TT_PROP__DCC_ASSET_ATTRIBUTE__ACCESSOR, access_id);
-				tm_the_truth_api->add_to_subobject_set(tt, obj, TM_TT_PROP__DCC_ASSET__ACCESSORS, &access, 1);
-				tm_the_truth_api->commit(tt, access, TM_TT_NO_UNDO_SCOPE);
-				tm_the_truth_api->add_to_subobject_set(tt, tm_mesh, TM_TT_PROP__DCC_ASSET_MESH__ATTRIBUTES, &attr, 1);
-
-				tm_the_truth_api->commit(tt, attr, TM_TT_NO_UNDO_SCOPE);
-				vbuf_size += (uint32_t)(acc_TEXCOORD_0->count * sizeof(float) * 2);
-			}
-
-			// TANGENT
-			if (acc_NORMAL != NULL && num_vertices > 0) {
-				tm_the_truth_object_o *attr = tm_the_truth_api->write(tt, tm_the_truth_api->create_object_of_type(tt, dcc_asset_ti->attribute_type, TM_TT_NO_UNDO_SCOPE));
-				tm_the_truth_api->set_uint32_t(tt, attr, TM_TT_PROP__DCC_ASSET_ATTRIBUTE__SEMANTIC, TM_TT_VALUE__DCC_ASSET_VERTEX__SEMANTIC__TANGENT);
-				tm_the_truth_api->set_uint32_t(tt, attr, TM_TT_PROP__DCC_ASSET_ATTRIBUTE__SET, 0);
-
-				const tm_tt_id_t access_id = tm_the_truth_api->create_object_of_type(tt, dcc_asset_ti->accessor_type, TM_TT_NO_UNDO_SCOPE);
-				tm_the_truth_object_o *access = tm_the_truth_api->write(tt, access_id);
-				tm_the_truth_api->set_uint32_t(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__OFFSET, vbuf_size);
-				tm_the_truth_api->set_uint32_t(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__COUNT, num_vertices);
-				tm_the_truth_api->set_bool(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__IS_FLOAT, true);
-				tm_the_truth_api->set_bool(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__IS_SIGNED, true);
-				tm_the_truth_api->set_bool(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__IS_NORMALIZED, false);
-				tm_the_truth_api->set_uint32_t(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__BITS, 32);
-				tm_the_truth_api->set_uint32_t(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__COMPONENT_COUNT, 4);
-				tm_the_truth_api->set_reference(tt, access, TM_TT_PROP__DCC_ASSET_ACCESSOR__BUFFER, vdata_id);
-				tm_the_truth_api->set_reference(tt, attr, TM_TT_PROP__DCC_ASSET_ATTRIBUTE__ACCESSOR, access_id);
-				tm_the_truth_api->add_to_subobject_set(tt, obj, TM_TT_PROP__DCC_ASSET__ACCESSORS, &access, 1);
-				tm_the_truth_api->commit(tt, access, TM_TT_NO_UNDO_SCOPE);
-				tm_the_truth_api->add_to_subobject_set(tt, tm_mesh, TM_TT_PROP__DCC_ASSET_MESH__ATTRIBUTES, &attr, 1);
-
-				tm_the_truth_api->commit(tt, attr, TM_TT_NO_UNDO_SCOPE);
-				vbuf_size += num_vertices * sizeof(float) * 4;
-			}
+			// Vertex stream formats, see `tm_ig_glb_import_settings_t`.
+			const vertex_format_t position_format = settings->quantize_positions
+				? (vertex_format_t){ .bits = 16, .component_count = 3, .is_normalized = true }
+				: (vertex_format_t){ .bits = 32, .component_count = 3, .is_float = true, .is_signed = true };
+			const vertex_format_t normal_format = settings->octahedral_normals
+				? (vertex_format_t){ .bits = 16, .component_count = 2, .is_signed = true, .is_normalized = true }
+				: (vertex_format_t){ .bits = 32, .component_count = 3, .is_float = true, .is_signed = true };
+			const vertex_format_t texcoord_format = settings->half_float_uvs
+				? (vertex_format_t){ .bits = 16, .component_count = 2, .is_float = true, .is_signed = true }
+				: (vertex_format_t){ .bits = 32, .component_count = 2, .is_float = true, .is_signed = true };
+			const vertex_format_t tangent_format = settings->octahedral_normals
+				? (vertex_format_t){ .bits = 16, .component_count = 2, .is_signed = true, .is_normalized = true }
+				: (vertex_format_t){ .bits = 32, .component_count = 4, .is_float = true, .is_signed = true };
+
+			const bool has_position = acc_POSITION != NULL;
+			const bool has_normal = acc_NORMAL != NULL && num_vertices > 0;
+			const bool has_texcoord = acc_TEXCOORD_0 != NULL && num_vertices > 0;
+			const bool has_tangent = has_normal;
+
+			// The vertex streams follow the skin data, see `vertex_layout_plan()`.
+			const vertex_format_t stream_formats[VERTEX_STREAM_COUNT] = {
+				[VERTEX_STREAM_POSITION] = has_position ? position_format : (vertex_format_t){ 0 },
+				[VERTEX_STREAM_NORMAL] = has_normal ? normal_format : (vertex_format_t){ 0 },
+				[VERTEX_STREAM_TEXCOORD] = has_texcoord ? texcoord_format : (vertex_format_t){ 0 },
+				[VERTEX_STREAM_TANGENT] = has_tangent ? tangent_format : (vertex_format_t){ 0 },
+			};
+			vertex_layout_t layout;
+			vbuf_size = vertex_layout_plan(&layout, stream_formats, num_vertices, vbuf_size, settings->interleave_vertices, settings->vertex_stride, vertex_alignment(settings));
+
+			if (has_position)
+				add_vertex_attribute(tt, obj, tm_mesh, TM_TT_VALUE__DCC_ASSET_VERTEX__SEMANTIC__POSITION, vdata_id, (uint32_t)layout.position_offset, num_vertices, position_format, layout.stride);
+			if (has_normal)
+				add_vertex_attribute(tt, obj, tm_mesh, TM_TT_VALUE__DCC_ASSET_VERTEX__SEMANTIC__NORMAL, vdata_id, (uint32_t)layout.normal_offset, num_vertices, normal_format, layout.stride);
+			if (has_texcoord)
+				add_vertex_attribute(tt, obj, tm_mesh, TM_TT_VALUE__DCC_ASSET_VERTEX__SEMANTIC__TEXCOORD, vdata_id, (uint32_t)layout.texcoord_offset, num_vertices, texcoord_format, layout.stride);
+			if (has_tangent)
+				add_vertex_attribute(tt, obj, tm_mesh, TM_TT_VALUE__DCC_ASSET_VERTEX__SEMANTIC__TANGENT, vdata_id, (uint32_t)layout.tangent_offset, num_vertices, tangent_format, layout.stride);
 
 			tm_the_truth_object_o *vdata = tm_the_truth_api->write(tt, vdata_id);
 			tm_the_truth_api->set_string(tt, vdata, TM_TT_PROP__DCC_ASSET_BUFFER__NAME, tm_temp_allocator_api->printf(ta, "vbuf.%s", mesh->name));
-			uint8_t *vbuf_data = buffers->allocate(buffers->inst, vbuf_size, 0);
-			const uint8_t *data_begins = vbuf_data;
+			// Zero initialized, so that the padding between the streams doesn't defeat the buffer
+			// store.
+			uint8_t *vbuf_data = buffers->allocate(buffers->inst, vbuf_size, true);
+			uint8_t *data_begins = vbuf_data;
+			memset(data_begins, 0, vbuf_size);
 
-			if (skin != NULL && acc_JOINTS_0 != NULL && acc_JOINTS_0->count > 0) {
+			if (skin_data != NULL) {
 				// Note: Currently this code assumes we can fit all skin weights for all vertices in less than 64MB
 				uint32_t skin_offset = num_vertices * sizeof(uint32_t);
 				for (uint32_t b = 0; b != num_vertices; ++b, vbuf_data += sizeof(uint32_t)) {
 					const uint8_t n_bone_influences = (uint8_t)tm_carray_size(skin_data[b]);
 					*(uint32_t *)vbuf_data = (((skin_offset / 4) & 0xffffff) << 8) | n_bone_influences;
-					skin_offset += n_bone_influences * sizeof(tm_bone_weight_t);
+					skin_offset += skin_record_size(n_bone_influences, skin_bits);
 				}
 
+				// The weights were normalized by `prune_bone_weights()`.
 				for (uint32_t b = 0; b != num_vertices; ++b) {
 					const uint8_t n_bone_influences = (uint8_t)tm_carray_size(skin_data[b]);
-					// Normalize skin weights.
-					float total_weight = 0.f;
-					for (uint32_t bi = 0; bi != n_bone_influences; ++bi)
-						total_weight += skin_data[b][bi].weight;
-					if (total_weight > 0.f) {
-						for (uint32_t bi = 0; bi != n_bone_influences; ++bi)
-							skin_data[b][bi].weight /= total_weight;
-					}
-					uint32_t stored_size = n_bone_influences * sizeof(tm_bone_weight_t);
-					memcpy(vbuf_data, skin_data[b], stored_size);
-					vbuf_data += stored_size;
+					encode_skin_record(vbuf_data, skin_data[b], n_bone_influences, skin_bits);
+					vbuf_data += skin_record_size(n_bone_influences, skin_bits);
 				}
 			}
 
+			// Attributes are unpacked to floats first, since tangent generation needs the full
+			// precision data, and then encoded into the vertex buffer in their stored format.
 			cgltf_float *vertices_data = NULL;
+			tm_vec3_t bounds[2] = {
+				{ FLT_MAX, FLT_MAX, FLT_MAX },
+				{ -FLT_MAX, -FLT_MAX, -FLT_MAX }
+			};
 			if (acc_POSITION != NULL && num_vertices > 0) {
-				const cgltf_size unpack_count = num_vertices * 3;
-				vertices_data = (cgltf_float *)vbuf_data;
+				const cgltf_size unpack_count = (cgltf_size)num_vertices * 3;
+				tm_carray_temp_resize(vertices_data, unpack_count, ta);
 				cgltf_accessor_unpack_floats(acc_POSITION, vertices_data, unpack_count);
 
 				// calc bounds
-				tm_vec3_t bounds[2] = {
-					{ FLT_MAX, FLT_MAX, FLT_MAX },
-					{ -FLT_MAX, -FLT_MAX, -FLT_MAX }
-				};
-
 				for (cgltf_size p = 0; p != num_vertices; ++p) {
-					float *v = (float *)vbuf_data + (p * 3);
+					float *v = vertices_data + (p * 3);
 					bounds[0] = v3_min(bounds[0], v);
 					bounds[1] = v3_max(bounds[1], v);
 				}
@@ -806,33 +1888,37 @@ static bool import_into(struct tm_the_truth_o *tt, struct tm_the_truth_object_o
 				tm_set_float_array(tt, max_w, TM_TT_PROP__VEC3__X, &bounds[1].x, 3);
 				tm_the_truth_api->set_subobject(tt, tm_mesh, TM_TT_PROP__DCC_ASSET_MESH__BOUNDS_MAX, max_w);
 				tm_the_truth_api->commit(tt, max_w, TM_TT_NO_UNDO_SCOPE);
-				vbuf_data += unpack_count * sizeof(float);
 			}
 
 			cgltf_float *normals_data = NULL;
-			if (acc_NORMAL != NULL) {
-				const cgltf_size unpack_count = acc_NORMAL->count * 3;
-				cgltf_accessor_unpack_floats(acc_NORMAL, (cgltf_float *)vbuf_data, unpack_count);
-				normals_data = (cgltf_float *)vbuf_data;
-				vbuf_data += unpack_count * sizeof(float);
+			if (acc_NORMAL != NULL && num_vertices > 0) {
+				const cgltf_size unpack_count = (cgltf_size)num_vertices * 3;
+				tm_carray_temp_resize(normals_data, unpack_count, ta);
+				memset(normals_data, 0, unpack_count * sizeof(float));
+				cgltf_accessor_unpack_floats(acc_NORMAL, normals_data, unpack_count);
 			}
 
 			cgltf_float *texcoord_data = NULL;
-			if (acc_TEXCOORD_0 != NULL) {
-				const cgltf_size unpack_count = acc_TEXCOORD_0->count * 2;
-				texcoord_data = (cgltf_float *)vbuf_data;
+			if (acc_TEXCOORD_0 != NULL && num_vertices > 0) {
+				const cgltf_size unpack_count = (cgltf_size)num_vertices * 2;
+				tm_carray_temp_resize(texcoord_data, unpack_count, ta);
+				memset(texcoord_data, 0, unpack_count * sizeof(float));
 				cgltf_accessor_unpack_floats(acc_TEXCOORD_0, texcoord_data, unpack_count);
-				vbuf_data += unpack_count * sizeof(float);
 			}
 
 			// Tangents
+			cgltf_float *tangents_data = NULL;
+			if (normals_data != NULL) {
+				tm_carray_temp_resize(tangents_data, (cgltf_size)num_vertices * 4, ta);
+				memset(tangents_data, 0, (cgltf_size)num_vertices * 4 * sizeof(float));
+			}
 			if (normals_data != NULL && vertices_data != NULL && texcoord_data != NULL) {
 				smikktspace_data_t mikk_data = {
 					.normals = normals_data,
 					.vertices = vertices_data,
 					.texcoord = texcoord_data,
 					.face_count = num_vertices,
-					.buffer = vbuf_data
+					.buffer = (uint8_t *)tangents_data
 				};
 				SMikkTSpaceInterface mikk_i = {
 					.m_getNumFaces = tm_mikk_getNumFaces,
@@ -844,11 +1930,45 @@ static bool import_into(struct tm_the_truth_o *tt, struct tm_the_truth_object_o
 				};
 				SMikkTSpaceContext mikk_ctx = { .m_pInterface = &mikk_i, .m_pUserData = &mikk_data };
 				genTangSpaceDefault(&mikk_ctx);
+			}
+
+			if (vertices_data != NULL) {
+				uint8_t *out = data_begins + layout.position_offset;
+				const uint32_t out_stride = vertex_layout_stride(&layout, position_format);
+				if (settings->quantize_positions)
+					encode_positions_unorm16(out, out_stride, vertices_data, num_vertices, bounds);
+				else
+					copy_floats(out, out_stride, vertices_data, 3, num_vertices);
+			}
 
-				vbuf_data += mikk_data.face_count * 4 * sizeof(float);
+			if (normals_data != NULL) {
+				uint8_t *out = data_begins + layout.normal_offset;
+				const uint32_t out_stride = vertex_layout_stride(&layout, normal_format);
+				if (settings->octahedral_normals)
+					encode_octahedral_snorm16(out, out_stride, normals_data, 3, num_vertices);
+				else
+					copy_floats(out, out_stride, normals_data, 3, num_vertices);
 			}
 
-			const uint32_t vbuf_id = buffers->add(buffers->inst, data_begins, vbuf_size, 0);
+			if (texcoord_data != NULL) {
+				uint8_t *out = data_begins + layout.texcoord_offset;
+				const uint32_t out_stride = vertex_layout_stride(&layout, texcoord_format);
+				if (settings->half_float_uvs)
+					encode_half(out, out_stride, texcoord_data, 2, num_vertices);
+				else
+					copy_floats(out, out_stride, texcoord_data, 2, num_vertices);
+			}
+
+			if (tangents_data != NULL) {
+				uint8_t *out = data_begins + layout.tangent_offset;
+				const uint32_t out_stride = vertex_layout_stride(&layout, tangent_format);
+				if (settings->octahedral_normals)
+					encode_octahedral_snorm16(out, out_stride, tangents_data, 4, num_vertices);
+				else
+					copy_floats(out, out_stride, tangents_data, 4, num_vertices);
+			}
+
+			const uint32_t vbuf_id = buffer_store_add(&buffer_store, data_begins, vbuf_size);
 			tm_the_truth_api->set_buffer(tt, vdata, TM_TT_PROP__DCC_ASSET_BUFFER__DATA, vbuf_id);
 			tm_the_truth_api->add_to_subobject_set(tt, obj, TM_TT_PROP__DCC_ASSET__BUFFERS, &vdata, 1);
 
@@ -858,6 +1978,28 @@ static bool import_into(struct tm_the_truth_o *tt, struct tm_the_truth_object_o
 			tm_the_truth_api->add_to_subobject_set(tt, obj, TM_TT_PROP__DCC_ASSET__MESHES, &tm_mesh, 1);
 			tm_the_truth_api->commit(tt, tm_mesh, TM_TT_NO_UNDO_SCOPE);
 		}
+
+		// The LOD meshes are copies of the primitive (attributes, bones, bounds and material) that
+		// reference the simplified indices instead.
+		for (uint32_t l = 0; l < tm_carray_size(lod_meshes); ++l) {
+			const lod_mesh_t *lod_mesh = lod_meshes + l;
+			const tm_tt_id_t lod_mesh_id = tm_the_truth_api->clone_object(tt, lod_mesh->mesh_id, TM_TT_NO_UNDO_SCOPE);
+			tm_the_truth_object_o *tm_lod_mesh = tm_the_truth_api->write(tt, lod_mesh_id);
+			tm_the_truth_api->set_string(tt, tm_lod_mesh, TM_TT_PROP__DCC_ASSET_MESH__NAME, tm_temp_allocator_api->printf(ta, "%s.%d.lod%u", mesh->name, lod_mesh->primitive, lod_mesh->level));
+			tm_the_truth_api->set_reference(tt, tm_lod_mesh, TM_TT_PROP__DCC_ASSET_MESH__INDICES, lod_mesh->indices);
+
+			tt_total_mesh_count++;
+			tm_the_truth_api->add_to_subobject_set(tt, obj, TM_TT_PROP__DCC_ASSET__MESHES, &tm_lod_mesh, 1);
+			tm_the_truth_api->commit(tt, tm_lod_mesh, TM_TT_NO_UNDO_SCOPE);
+		}
+
+		for (uint32_t m = 0; m < tm_carray_size(meshlet_meshes); ++m) {
+			const meshlet_mesh_t *meshlet_mesh = meshlet_meshes + m;
+			tm_the_truth_object_o *tm_mesh = tm_the_truth_api->write(tt, meshlet_mesh->mesh_id);
+			for (uint32_t k = 0; k < TM_ARRAY_COUNT(meshlet_semantics); ++k)
+				add_attribute(tt, tm_mesh, meshlet_semantics[k], meshlet_mesh->accessors[k]);
+			tm_the_truth_api->commit(tt, tm_mesh, TM_TT_NO_UNDO_SCOPE);
+		}
 	}
 
 	name_to_id_t node_by_name = { .allocator = a };
@@ -891,12 +2033,513 @@ static bool import_into(struct tm_the_truth_o *tt, struct tm_the_truth_object_o
 		return false;
 
 	tm_the_truth_api->commit(tt, scene_obj, TM_TT_NO_UNDO_SCOPE);
+	buffer_store_publish(&buffer_store, obj, ta);
 
 	tm_progress_report_api->set_task_progress(task_id, 0, 0.99f);
 
 	return true;
 }
 
+typedef struct meshopt_job_t
+{
+	cgltf_buffer_view *view;
+	bool result;
+	TM_PAD(7);
+} meshopt_job_t;
+
+static void decode_meshopt_job(void *data)
+{
+	TM_PROFILER_BEGIN_FUNC_SCOPE();
+
+	meshopt_job_t *job = (meshopt_job_t *)data;
+	const cgltf_meshopt_compression *mc = &job->view->meshopt_compression;
+	const uint8_t *source = (const uint8_t *)mc->buffer->data + mc->offset;
+	const uint32_t count = (uint32_t)mc->count;
+	const uint32_t stride = (uint32_t)mc->stride;
+
+	switch (mc->mode) {
+	case cgltf_meshopt_compression_mode_attributes:
+		job->result = meshopt_decode_vertex_buffer(job->view->data, count, stride, source, mc->size);
+		break;
+	case cgltf_meshopt_compression_mode_triangles:
+		job->result = meshopt_decode_index_buffer(job->view->data, count, stride, source, mc->size);
+		break;
+	case cgltf_meshopt_compression_mode_indices:
+		job->result = meshopt_decode_index_sequence(job->view->data, count, stride, source, mc->size);
+		break;
+	default:
+		job->result = false;
+		break;
+	}
+
+	if (job->result) {
+		switch (mc->filter) {
+		case cgltf_meshopt_compression_filter_octahedral:
+			meshopt_decode_filter_oct(job->view->data, count, stride);
+			break;
+		case cgltf_meshopt_compression_filter_quaternion:
+			meshopt_decode_filter_quat(job->view->data, count, stride);
+			break;
+		case cgltf_meshopt_compression_filter_exponential:
+			meshopt_decode_filter_exp(job->view->data, count, stride);
+			break;
+		default:
+			break;
+		}
+	}
+
+	TM_PROFILER_END_FUNC_SCOPE();
+}
+
+// Decodes all the buffer views that use `EXT_meshopt_compression`, one job per buffer view. The
+// decoded data is stored in `cgltf_buffer_view::data`, which cgltf reads in place of the buffer
+// and frees in `cgltf_free()`.
+static bool decode_meshopt_buffer_views(cgltf_data *data, struct tm_temp_allocator_i *ta, const char *filename)
+{
+	TM_PROFILER_BEGIN_FUNC_SCOPE();
+
+	meshopt_job_t *meshopt_jobs = NULL;
+	for (cgltf_size i = 0; i < data->buffer_views_count; ++i) {
+		cgltf_buffer_view *view = data->buffer_views + i;
+		if (!view->has_meshopt_compression || view->data)
+			continue;
+
+		const cgltf_meshopt_compression *mc = &view->meshopt_compression;
+		if (!mc->buffer->data || mc->offset + mc->size > mc->buffer->size || view->size != mc->count * mc->stride) {
+			tm_logger_api->printf(TM_LOG_TYPE_ERROR, "Compressed buffer view %u of %s is invalid", (uint32_t)i, filename);
+			TM_PROFILER_END_FUNC_SCOPE();
+			return false;
+		}
+
+		view->data = data->memory.alloc(data->memory.user_data, mc->count * mc->stride);
+		tm_carray_temp_push(meshopt_jobs, ((meshopt_job_t){ .view = view }), ta);
+	}
+
+	const uint32_t num_meshopt_jobs = (uint32_t)tm_carray_size(meshopt_jobs);
+	tm_jobdecl_t *jobs = NULL;
+	tm_carray_temp_resize(jobs, num_meshopt_jobs, ta);
+	for (uint32_t i = 0; i < num_meshopt_jobs; ++i)
+		jobs[i] = (tm_jobdecl_t){ .task = decode_meshopt_job, .data = meshopt_jobs + i };
+	if (num_meshopt_jobs)
+		tm_job_system_api->wait_for_counter_and_free(tm_job_system_api->run_jobs(jobs, num_meshopt_jobs));
+
+	bool success = true;
+	for (uint32_t i = 0; i < num_meshopt_jobs; ++i) {
+		if (!meshopt_jobs[i].result) {
+			tm_logger_api->printf(TM_LOG_TYPE_ERROR, "Decoding of compressed buffer view %u of %s failed", (uint32_t)(meshopt_jobs[i].view - data->buffer_views), filename);
+			success = false;
+		}
+	}
+
+	TM_PROFILER_END_FUNC_SCOPE();
+	return success;
+}
+
+typedef struct draco_job_t
+{
+	const cgltf_primitive *primitive;
+	uint32_t mesh_index;
+	uint32_t primitive_index;
+	uint32_t vertex_count;
+	uint32_t index_count;
+	uint32_t index_size;
+	uint32_t num_attributes;
+	void *indices;
+	draco_attribute_output_t *attributes;
+
+	// Time spent decoding the primitive, in seconds.
+	double decode_time;
+	bool result;
+	TM_PAD(7);
+} draco_job_t;
+
+static void decode_draco_job(void *data)
+{
+	TM_PROFILER_BEGIN_FUNC_SCOPE();
+
+	draco_job_t *job = (draco_job_t *)data;
+	const cgltf_buffer_view *view = job->primitive->draco_mesh_compression.buffer_view;
+
+	const tm_clock_o start = tm_os_api->time->now();
+	job->result = draco_decode_mesh(cgltf_buffer_view_data(view), view->size, job->vertex_count, job->indices, job->index_count, job->index_size, job->attributes, job->num_attributes);
+	job->decode_time = tm_os_api->time->delta(tm_os_api->time->now(), start);
+
+	TM_PROFILER_END_FUNC_SCOPE();
+}
+
+static bool draco_component_type(cgltf_component_type type, uint32_t *out)
+{
+	switch (type) {
+	case cgltf_component_type_r_8: *out = DRACO_COMPONENT_TYPE_INT8; return true;
+	case cgltf_component_type_r_8u: *out = DRACO_COMPONENT_TYPE_UINT8; return true;
+	case cgltf_component_type_r_16: *out = DRACO_COMPONENT_TYPE_INT16; return true;
+	case cgltf_component_type_r_16u: *out = DRACO_COMPONENT_TYPE_UINT16; return true;
+	case cgltf_component_type_r_32u: *out = DRACO_COMPONENT_TYPE_UINT32; return true;
+	case cgltf_component_type_r_32f: *out = DRACO_COMPONENT_TYPE_FLOAT32; return true;
+	default: return false;
+	}
+}
+
+// Points `accessor` at a new, tightly packed buffer view and returns its data. Used for the
+// accessors of Draco compressed primitives, which have no buffer view of their own, and of split
+// primitives. Once the data is written here the rest of the importer reads them like any other
+// accessor.
+static void *accessor_alloc_data(cgltf_accessor *accessor, tm_allocator_i *a)
+{
+	const cgltf_size element_size = cgltf_calc_size(accessor->type, accessor->component_type);
+	cgltf_buffer_view *view = tm_alloc(a, sizeof(*view));
+	*view = (cgltf_buffer_view){ .size = accessor->count * element_size };
+	view->data = tm_alloc(a, view->size);
+	accessor->buffer_view = view;
+	accessor->offset = 0;
+	accessor->stride = element_size;
+	return view->data;
+}
+
+// Decodes all the primitives that use `KHR_draco_mesh_compression`, one job per primitive. The
+// decoded buffer views are allocated from `ta`, so they must not outlive it.
+static bool decode_draco_primitives(cgltf_data *data, struct tm_temp_allocator_i *ta, const char *filename)
+{
+	TM_PROFILER_BEGIN_FUNC_SCOPE();
+	TM_GET_TEMP_ALLOCATOR_ADAPTER(ta, a);
+
+	draco_job_t *draco_jobs = NULL;
+	for (cgltf_size i = 0; i < data->meshes_count; ++i) {
+		for (cgltf_size j = 0; j < data->meshes[i].primitives_count; ++j) {
+			cgltf_primitive *primitive = data->meshes[i].primitives + j;
+			if (!primitive->has_draco_mesh_compression)
+				continue;
+
+			if (!draco_decoder_available()) {
+				tm_logger_api->printf(TM_LOG_TYPE_ERROR, "%s uses KHR_draco_mesh_compression, but the importer was built without Draco support", filename);
+				TM_PROFILER_END_FUNC_SCOPE();
+				return false;
+			}
+
+			const cgltf_draco_mesh_compression *dc = &primitive->draco_mesh_compression;
+			if (!dc->buffer_view || !cgltf_buffer_view_data(dc->buffer_view) || !primitive->attributes_count) {
+				tm_logger_api->printf(TM_LOG_TYPE_ERROR, "Draco compressed primitive %u of mesh %u in %s is invalid", (uint32_t)j, (uint32_t)i, filename);
+				TM_PROFILER_END_FUNC_SCOPE();
+				return false;
+			}
+
+			draco_job_t job = {
+				.primitive = primitive,
+				.mesh_index = (uint32_t)i,
+				.primitive_index = (uint32_t)j,
+				.vertex_count = (uint32_t)primitive->attributes[0].data->count,
+			};
+
+			// Accessors that already have a buffer view are either uncompressed fallbacks or shared
+			// with a primitive that is decoded by another job.
+			if (primitive->indices && !primitive->indices->buffer_view) {
+				job.index_count = (uint32_t)primitive->indices->count;
+				job.index_size = (uint32_t)cgltf_calc_size(cgltf_type_scalar, primitive->indices->component_type);
+				job.indices = accessor_alloc_data(primitive->indices, a);
+			}
+
+			for (cgltf_size k = 0; k < dc->attributes_count; ++k) {
+				// cgltf resolves the Draco attribute ids as if they were accessor indices.
+				const uint32_t unique_id = (uint32_t)(dc->attributes[k].data - data->accessors);
+				for (cgltf_size l = 0; l < primitive->attributes_count; ++l) {
+					cgltf_accessor *accessor = primitive->attributes[l].data;
+					if (strcmp(primitive->attributes[l].name, dc->attributes[k].name) != 0 || accessor->buffer_view)
+						continue;
+
+					draco_attribute_output_t output = {
+						.unique_id = unique_id,
+						.num_components = (uint32_t)cgltf_num_components(accessor->type),
+					};
+					if (!draco_component_type(accessor->component_type, &output.component_type) || accessor->count != job.vertex_count) {
+						tm_logger_api->printf(TM_LOG_TYPE_ERROR, "Draco compressed attribute %s of mesh %u in %s is invalid", dc->attributes[k].name, (uint32_t)i, filename);
+						TM_PROFILER_END_FUNC_SCOPE();
+						return false;
+					}
+					output.data = accessor_alloc_data(accessor, a);
+					tm_carray_temp_push(job.attributes, output, ta);
+				}
+			}
+
+			job.num_attributes = (uint32_t)tm_carray_size(job.attributes);
+			if (job.indices || job.num_attributes)
+				tm_carray_temp_push(draco_jobs, job, ta);
+		}
+	}
+
+	const uint32_t num_draco_jobs = (uint32_t)tm_carray_size(draco_jobs);
+	if (!num_draco_jobs) {
+		TM_PROFILER_END_FUNC_SCOPE();
+		return true;
+	}
+
+	const tm_clock_o start = tm_os_api->time->now();
+	tm_jobdecl_t *jobs = NULL;
+	tm_carray_temp_resize(jobs, num_draco_jobs, ta);
+	for (uint32_t i = 0; i < num_draco_jobs; ++i)
+		jobs[i] = (tm_jobdecl_t){ .task = decode_draco_job, .data = draco_jobs + i };
+	tm_job_system_api->wait_for_counter_and_free(tm_job_system_api->run_jobs(jobs, num_draco_jobs));
+	const double wall_time = tm_os_api->time->delta(tm_os_api->time->now(), start);
+
+	bool success = true;
+	double decode_time = 0.0;
+	for (uint32_t i = 0; i < num_draco_jobs; ++i) {
+		decode_time += draco_jobs[i].decode_time;
+		if (!draco_jobs[i].result) {
+			tm_logger_api->printf(TM_LOG_TYPE_ERROR, "Decoding of Draco compressed primitive %u of mesh %u in %s failed", draco_jobs[i].primitive_index, draco_jobs[i].mesh_index, filename);
+			success = false;
+		}
+	}
+
+	tm_logger_api->printf(TM_LOG_TYPE_INFO, "Decoded %u Draco compressed primitives of %s in %.2f ms (%.2f ms decode time)", num_draco_jobs, filename, wall_time * 1000.0, decode_time * 1000.0);
+
+	TM_PROFILER_END_FUNC_SCOPE();
+	return success;
+}
+
+// Original primitives of a mesh whose primitives were split by `split_primitives()`.
+typedef struct split_mesh_t
+{
+	cgltf_mesh *mesh;
+	cgltf_primitive *primitives;
+	cgltf_size primitives_count;
+} split_mesh_t;
+
+static cgltf_accessor *primitive_attribute(const cgltf_primitive *primitive, const char *name)
+{
+	for (cgltf_size i = 0; i < primitive->attributes_count; ++i) {
+		if (strcmp(primitive->attributes[i].name, name) == 0)
+			return primitive->attributes[i].data;
+	}
+	return NULL;
+}
+
+// Returns a new accessor with the elements `vertices` of `source`. Sparse accessors and accessors
+// without data are converted to floats.
+static cgltf_accessor *gather_accessor(const cgltf_accessor *source, const uint32_t *vertices, uint32_t count, tm_allocator_i *a)
+{
+	const uint8_t *in = source->buffer_view && !source->is_sparse ? cgltf_buffer_view_data(source->buffer_view) : NULL;
+	cgltf_accessor *accessor = tm_alloc(a, sizeof(*accessor));
+	*accessor = (cgltf_accessor){
+		.component_type = in ? source->component_type : cgltf_component_type_r_32f,
+		.normalized = in && source->normalized,
+		.type = source->type,
+		.count = count,
+	};
+	uint8_t *out = accessor_alloc_data(accessor, a);
+	if (in) {
+		in += source->offset;
+		for (uint32_t i = 0; i < count; ++i)
+			memcpy(out + i * accessor->stride, in + vertices[i] * source->stride, accessor->stride);
+	} else {
+		const cgltf_size num_components = cgltf_num_components(source->type);
+		for (uint32_t i = 0; i < count; ++i)
+			cgltf_accessor_read_float(source, vertices[i], (float *)out + i * num_components, num_components);
+	}
+	return accessor;
+}
+
+// Counts the vertices of the triangle `indices` that aren't in split `split` yet, and writes the
+// number of bones they add to the split to `new_bones`.
+static uint32_t split_new_vertices(const uint32_t *indices, const uint32_t *vertex_split, const uint32_t *joints, const uint32_t *bone_split,
+	uint32_t split, uint32_t *new_bones)
+{
+	uint32_t num_vertices = 0;
+	uint32_t bones[12];
+	uint32_t num_bones = 0;
+	for (uint32_t k = 0; k < 3; ++k) {
+		const uint32_t v = indices[k];
+		if (vertex_split[v] == split || (k > 0 && v == indices[0]) || (k > 1 && v == indices[1]))
+			continue;
+		++num_vertices;
+		for (uint32_t j = 0; joints && j < 4; ++j) {
+			const uint32_t b = joints[v * 4 + j];
+			bool seen = bone_split[b] == split;
+			for (uint32_t i = 0; i < num_bones && !seen; ++i)
+				seen = bones[i] == b;
+			if (!seen)
+				bones[num_bones++] = b;
+		}
+	}
+	*new_bones = num_bones;
+	return num_vertices;
+}
+
+// Splits `primitive` into primitives with at most `max_vertices` vertices and `max_bones` bones and
+// pushes them to `out`. The triangles are assigned in order, so the splits are as coherent as the
+// index buffer. Returns the number of primitives pushed, 0 if the primitive is within the budget
+// or can't be split.
+static uint32_t split_primitive(cgltf_primitive **out, const cgltf_primitive *primitive, uint32_t max_vertices, uint32_t max_bones,
+	struct tm_temp_allocator_i *ta)
+{
+	TM_GET_TEMP_ALLOCATOR_ADAPTER(ta, a);
+
+	const cgltf_accessor *positions = primitive_attribute(primitive, "POSITION");
+	if (primitive->type != cgltf_primitive_type_triangles || !positions || !positions->count)
+		return 0;
+
+	const uint32_t num_vertices = (uint32_t)positions->count;
+	const uint32_t num_indices = primitive->indices ? (uint32_t)primitive->indices->count : num_vertices;
+	const cgltf_accessor *acc_JOINTS_0 = primitive_attribute(primitive, "JOINTS_0");
+	const cgltf_accessor *acc_WEIGHTS_0 = primitive_attribute(primitive, "WEIGHTS_0");
+	const bool skinned = acc_JOINTS_0 && acc_WEIGHTS_0 && acc_JOINTS_0->count == num_vertices && acc_WEIGHTS_0->count == num_vertices;
+	if (num_vertices <= max_vertices && (!skinned || max_bones == UINT32_MAX))
+		return 0;
+
+	uint32_t *indices = NULL;
+	tm_carray_temp_resize(indices, num_indices, ta);
+	for (uint32_t i = 0; i < num_indices; ++i) {
+		indices[i] = primitive->indices ? (uint32_t)cgltf_accessor_read_index(primitive->indices, i) : i;
+		if (indices[i] >= num_vertices)
+			return 0;
+	}
+
+	// Bones of each vertex. Only influences with a weight count against the budget, so the unused
+	// influences are pointed at the first used bone of the vertex.
+	uint32_t *joints = NULL;
+	uint32_t num_joints = 0;
+	if (skinned) {
+		tm_carray_temp_resize(joints, (cgltf_size)num_vertices * 4, ta);
+		float *weights = NULL;
+		tm_carray_temp_resize(weights, (cgltf_size)num_vertices * 4, ta);
+		cgltf_accessor_unpack_floats(acc_WEIGHTS_0, weights, (cgltf_size)num_vertices * 4);
+		for (uint32_t v = 0; v < num_vertices; ++v) {
+			uint32_t *vj = joints + v * 4;
+			const float *vw = weights + v * 4;
+			cgltf_accessor_read_uint(acc_JOINTS_0, v, vj, 4);
+			uint32_t first = vj[0];
+			for (uint32_t j = 4; j-- > 0;)
+				first = vw[j] > 0.f ? vj[j] : first;
+			for (uint32_t j = 0; j < 4; ++j) {
+				vj[j] = vw[j] > 0.f ? vj[j] : first;
+				num_joints = vj[j] + 1 > num_joints ? vj[j] + 1 : num_joints;
+			}
+		}
+	}
+
+	// Split of each vertex and bone, 0 if not yet used, and the index of the vertex in its split.
+	uint32_t *vertex_split = NULL, *vertex_local = NULL, *bone_split = NULL;
+	tm_carray_temp_resize(vertex_split, num_vertices, ta);
+	tm_carray_temp_resize(vertex_local, num_vertices, ta);
+	tm_carray_temp_resize(bone_split, num_joints, ta);
+	memset(vertex_split, 0, num_vertices * sizeof(*vertex_split));
+	memset(bone_split, 0, num_joints * sizeof(*bone_split));
+
+	// The vertices of all splits and the first vertex and index of each split.
+	uint32_t *split_vertices = NULL, *first_vertex = NULL, *first_index = NULL;
+	tm_carray_temp_push(first_vertex, 0, ta);
+	tm_carray_temp_push(first_index, 0, ta);
+
+	uint32_t split = 1, num_split_vertices = 0, num_split_bones = 0;
+	for (uint32_t t = 0; t + 3 <= num_indices; t += 3) {
+		uint32_t new_bones;
+		const uint32_t new_vertices = split_new_vertices(indices + t, vertex_split, joints, bone_split, split, &new_bones);
+		if (num_split_vertices && (num_split_vertices + new_vertices > max_vertices || num_split_bones + new_bones > max_bones)) {
+			++split;
+			num_split_vertices = num_split_bones = 0;
+			tm_carray_temp_push(first_vertex, (uint32_t)tm_carray_size(split_vertices), ta);
+			tm_carray_temp_push(first_index, t, ta);
+		}
+
+		for (uint32_t k = 0; k < 3; ++k) {
+			const uint32_t v = indices[t + k];
+			if (vertex_split[v] != split) {
+				vertex_split[v] = split;
+				vertex_local[v] = num_split_vertices++;
+				tm_carray_temp_push(split_vertices, v, ta);
+				for (uint32_t j = 0; joints && j < 4; ++j) {
+					const uint32_t b = joints[v * 4 + j];
+					num_split_bones += bone_split[b] != split;
+					bone_split[b] = split;
+				}
+			}
+			indices[t + k] = vertex_local[v];
+		}
+	}
+
+	if (split == 1)
+		return 0;
+
+	const uint32_t num_triangle_indices = num_indices / 3 * 3;
+	for (uint32_t s = 0; s < split; ++s) {
+		const uint32_t vertex_count = (s + 1 < split ? first_vertex[s + 1] : (uint32_t)tm_carray_size(split_vertices)) - first_vertex[s];
+		const uint32_t index_count = (s + 1 < split ? first_index[s + 1] : num_triangle_indices) - first_index[s];
+		const uint32_t *vertices = split_vertices + first_vertex[s];
+
+		cgltf_primitive p = *primitive;
+		p.has_draco_mesh_compression = false;
+		p.targets = NULL;
+		p.targets_count = 0;
+
+		cgltf_accessor *index_accessor = tm_alloc(a, sizeof(*index_accessor));
+		*index_accessor = (cgltf_accessor){ .component_type = cgltf_component_type_r_32u, .type = cgltf_type_scalar, .count = index_count };
+		memcpy(accessor_alloc_data(index_accessor, a), indices + first_index[s], index_count * sizeof(uint32_t));
+		p.indices = index_accessor;
+
+		p.attributes = tm_alloc(a, primitive->attributes_count * sizeof(*p.attributes));
+		for (cgltf_size k = 0; k < primitive->attributes_count; ++k) {
+			p.attributes[k] = primitive->attributes[k];
+			if (skinned && primitive->attributes[k].data == acc_JOINTS_0) {
+				cgltf_accessor *accessor = tm_alloc(a, sizeof(*accessor));
+				*accessor = (cgltf_accessor){ .component_type = cgltf_component_type_r_32u, .type = cgltf_type_vec4, .count = vertex_count };
+				uint32_t *data = accessor_alloc_data(accessor, a);
+				for (uint32_t i = 0; i < vertex_count; ++i)
+					memcpy(data + i * 4, joints + vertices[i] * 4, 4 * sizeof(uint32_t));
+				p.attributes[k].data = accessor;
+			} else {
+				p.attributes[k].data = gather_accessor(primitive->attributes[k].data, vertices, vertex_count, a);
+			}
+		}
+		tm_carray_temp_push(*out, p, ta);
+	}
+	return split;
+}
+
+// Splits the triangle primitives that exceed `split_max_vertices` or `split_max_bones`. The splits
+// replace the primitive in `cgltf_mesh::primitives`, so the rest of the importer treats them like
+// any other primitive and each gets its own compact bone list. The split data is allocated from
+// `ta`. Returns the original primitives, which must be put back by `restore_split_meshes()`
+// before `cgltf_free()`.
+static split_mesh_t *split_primitives(cgltf_data *data, const tm_ig_glb_import_settings_t *settings, struct tm_temp_allocator_i *ta)
+{
+	if (!settings->split_max_vertices && !settings->split_max_bones)
+		return NULL;
+
+	TM_PROFILER_BEGIN_FUNC_SCOPE();
+
+	// A single triangle can have 3 vertices with 4 bones each.
+	const uint32_t max_vertices = settings->split_max_vertices ? (settings->split_max_vertices > 3 ? settings->split_max_vertices : 3) : UINT32_MAX;
+	const uint32_t max_bones = settings->split_max_bones ? (settings->split_max_bones > 12 ? settings->split_max_bones : 12) : UINT32_MAX;
+
+	split_mesh_t *split_meshes = NULL;
+	for (cgltf_size i = 0; i < data->meshes_count; ++i) {
+		cgltf_mesh *mesh = data->meshes + i;
+		cgltf_primitive *primitives = NULL;
+		bool split = false;
+		for (cgltf_size j = 0; j < mesh->primitives_count; ++j) {
+			if (split_primitive(&primitives, mesh->primitives + j, max_vertices, max_bones, ta))
+				split = true;
+			else
+				tm_carray_temp_push(primitives, mesh->primitives[j], ta);
+		}
+		if (split) {
+			tm_carray_temp_push(split_meshes, ((split_mesh_t){ .mesh = mesh, .primitives = mesh->primitives, .primitives_count = mesh->primitives_count }), ta);
+			mesh->primitives = primitives;
+			mesh->primitives_count = tm_carray_size(primitives);
+		}
+	}
+
+	TM_PROFILER_END_FUNC_SCOPE();
+	return split_meshes;
+}
+
+static void restore_split_meshes(const split_mesh_t *split_meshes)
+{
+	for (uint64_t i = 0; i < tm_carray_size(split_meshes); ++i) {
+		split_meshes[i].mesh->primitives = split_meshes[i].primitives;
+		split_meshes[i].mesh->primitives_count = split_meshes[i].primitives_count;
+	}
+}
+
 static void import_glb_task(void *task_data, uint64_t task_id)
 {
 	TM_PROFILER_BEGIN_FUNC_SCOPE();
@@ -937,6 +2580,17 @@ static void import_glb_task(void *task_data, uint64_t task_id)
 		return;
 	}
 
+	if (!decode_meshopt_buffer_views(glb_data, ta, filename) || !decode_draco_primitives(glb_data, ta, filename)) {
+		tm_progress_report_api->set_task_progress(task_id, 0, 1.f);
+		cgltf_free(glb_data);
+		tm_free(args->allocator, task, task->bytes);
+		TM_SHUTDOWN_TEMP_ALLOCATOR(ta);
+		TM_PROFILER_END_FUNC_SCOPE();
+		return;
+	}
+
+	const split_mesh_t *split_meshes = split_primitives(glb_data, &task->settings, ta);
+
 	tm_the_truth_o *tt = args->tt;
 
 	const tm_tt_type_t dcc_asset_type = tm_the_truth_api->object_type_from_name_hash(tt, TM_TT_TYPE_HASH__DCC_ASSET);
@@ -951,7 +2605,7 @@ static void import_glb_task(void *task_data, uint64_t task_id)
 
 	tm_progress_report_api->set_task_progress(task_id, 0, 0.99f);
 
-	if (import_into(tt, asset_obj, glb_data, asset_name, asset_path, ta, tm_error_api->def, task_id)) {
+	if (import_into(tt, asset_obj, glb_data, asset_name, asset_path, &task->settings, ta, tm_error_api->def, task_id)) {
 		if (args->reimport_into.u64) {
 			tm_the_truth_api->retarget_write(tt, asset_obj, args->reimport_into);
 			tm_the_truth_api->commit(tt, asset_obj, args->undo_scope);
@@ -968,6 +2622,7 @@ static void import_glb_task(void *task_data, uint64_t task_id)
 
 	tm_progress_report_api->set_task_progress(task_id, 0, 1.f);
 
+	restore_split_meshes(split_meshes);
 	cgltf_free(glb_data);
 	tm_free(args->allocator, task, task->bytes);
 
@@ -975,6 +2630,13 @@ static void import_glb_task(void *task_data, uint64_t task_id)
 	TM_PROFILER_END_FUNC_SCOPE();
 }
 
+static tm_ig_glb_import_settings_t import_settings = {
+	.lod_reduction = 0.5f,
+	.lod_target_error = 0.05f,
+	.meshlet_max_vertices = 64,
+	.meshlet_max_triangles = 124,
+};
+
 static uint64_t import(const char *file, const struct tm_asset_io_import *args)
 {
 	// allocate string data together with the rest of the struct.
@@ -983,6 +2645,7 @@ static uint64_t import(const char *file, const struct tm_asset_io_import *args)
 	*task = (import_glb_task_t){
 		.bytes = bytes,
 		.args = *args,
+		.settings = import_settings,
 	};
 	strcpy(task->filename, file);
 	return tm_task_system_api->run_task(import_glb_task, task, "GLB Import");
@@ -1034,8 +2697,14 @@ static struct tm_asset_io_i *io_interface()
 	return glb_importer;
 }
 
+static tm_ig_glb_import_settings_t *get_import_settings(void)
+{
+	return &import_settings;
+}
+
 struct tm_ig_glb_api *tm_ig_glb_api = &(struct tm_ig_glb_api)
 {
 	.import = import,
-	.io_interface = io_interface
+	.io_interface = io_interface,
+	.import_settings = get_import_settings
 };
@@ -7,6 +7,220 @@ struct tm_the_truth_o;
 struct tm_ui_o;
 struct tm_asset_io_import;
 
+// Value of `TM_TT_PROP__DCC_ASSET_IMAGE__TYPE` for images stored as KTX2 containers, typically with
+// Basis Universal supercompression (`KHR_texture_basisu`). The image buffer holds the unmodified
+// KTX2 file, which can be transcoded to a GPU format without decoding it to pixels first. The
+// value is the `KTX2` fourcc, so it doesn't collide with the image types of the dcc_asset plugin.
+#define TM_TT_VALUE__DCC_ASSET_IMAGE__TYPE__KTX2 0x3258544bu
+
+// Values of `TM_TT_PROP__DCC_ASSET_ATTRIBUTE__SEMANTIC` for the meshlet sections of a mesh, see
+// `tm_ig_glb_import_settings_t.generate_meshlets`. The values are fourccs, so they don't collide
+// with the vertex semantics of the dcc_asset plugin.
+#define TM_TT_VALUE__DCC_ASSET_VERTEX__SEMANTIC__MESHLET_DESCRIPTORS 0x44544c4du
+#define TM_TT_VALUE__DCC_ASSET_VERTEX__SEMANTIC__MESHLET_BOUNDS 0x42544c4du
+#define TM_TT_VALUE__DCC_ASSET_VERTEX__SEMANTIC__MESHLET_VERTICES 0x56544c4du
+#define TM_TT_VALUE__DCC_ASSET_VERTEX__SEMANTIC__MESHLET_TRIANGLES 0x54544c4du
+
+// Value of `TM_TT_PROP__DCC_ASSET_ATTRIBUTE__SEMANTIC` for skin data with quantized bone indices
+// and weights, see `tm_ig_glb_import_settings_t.skin_weight_bits`. The consumers of
+// `TM_TT_VALUE__DCC_ASSET_VERTEX__SEMANTIC__SKIN_DATA` expect uint32 indices and float weights,
+// so the quantized records use their own fourcc.
+#define TM_TT_VALUE__DCC_ASSET_VERTEX__SEMANTIC__SKIN_DATA_QUANTIZED 0x514e4b53u
+
+// Filters used to generate the mip chains of decoded images, see
+// `tm_ig_glb_import_settings_t.mip_filter`.
+enum tm_ig_glb_mip_filter {
+    // Average of 2x2 texels.
+    TM_IG_GLB_MIP_FILTER_BOX,
+
+    // Kaiser windowed sinc. Keeps the smaller levels sharper than the box filter, but is slower.
+    TM_IG_GLB_MIP_FILTER_KAISER,
+};
+
+// Texel formats of a `tm_ig_glb_mip_chain_t`.
+enum tm_ig_glb_mip_format {
+    TM_IG_GLB_MIP_FORMAT_RGBA8,
+    TM_IG_GLB_MIP_FORMAT_BC1,
+    TM_IG_GLB_MIP_FORMAT_BC3,
+    TM_IG_GLB_MIP_FORMAT_BC5,
+    TM_IG_GLB_MIP_FORMAT_BC7,
+};
+
+// Speed and quality presets of the block compression, see
+// `tm_ig_glb_import_settings_t.compress_textures`.
+enum tm_ig_glb_compression_quality {
+    // Uses BC1 (BC3 with alpha) instead of BC7 for color textures and skips the end point
+    // refinement.
+    TM_IG_GLB_COMPRESSION_QUALITY_FAST,
+    TM_IG_GLB_COMPRESSION_QUALITY_NORMAL,
+    TM_IG_GLB_COMPRESSION_QUALITY_HIGH,
+};
+
+// Material texture slots, see `tm_ig_glb_import_settings_t.texture_slot_max_size`.
+enum tm_ig_glb_texture_slot {
+    TM_IG_GLB_TEXTURE_SLOT_BASE_COLOR,
+    TM_IG_GLB_TEXTURE_SLOT_NORMAL,
+    TM_IG_GLB_TEXTURE_SLOT_EMISSIVE,
+
+    // The metallic-roughness texture isn't imported yet, so this limit currently has no effect.
+    TM_IG_GLB_TEXTURE_SLOT_METALLIC_ROUGHNESS,
+
+    TM_IG_GLB_TEXTURE_SLOT_COUNT,
+};
+
+// Maximum number of levels in a mip chain, enough for 16384 x 16384 images.
+#define TM_IG_GLB_MAX_MIPS 15
+
+// Header at the start of the `mips.<image>` buffers created when
+// `tm_ig_glb_import_settings_t.decode_images` is set. The header is followed by the texels of each
+// level, largest first and with the rows tightly packed. The block compressed formats store rows
+// of 4 x 4 texel blocks, with the blocks at the right and bottom edges padded.
+typedef struct tm_ig_glb_mip_chain_t
+{
+    // Size of the first level. Each following level is half the size of the previous one, rounded
+    // down and at least one texel.
+    uint32_t width;
+    uint32_t height;
+
+    uint32_t num_mips;
+
+    // Set if the color channels are sRGB encoded, i.e. the image is used as a base color or
+    // emissive texture. Alpha is always linear.
+    uint32_t srgb;
+
+    // Format of the texels, see `enum tm_ig_glb_mip_format`.
+    uint32_t format;
+
+    // Size of the source image. Larger than `width` and `height` if the image was downscaled, see
+    // `tm_ig_glb_import_settings_t.max_texture_size`.
+    uint32_t source_width;
+    uint32_t source_height;
+    TM_PAD(4);
+
+    // Offset of each level from the start of the buffer.
+    uint64_t mip_offsets[TM_IG_GLB_MAX_MIPS];
+} tm_ig_glb_mip_chain_t;
+
+// Options that control how `import_into` stores the imported data. The settings are copied when an
+// import is started, so changing them does not affect imports that are already running.
+typedef struct tm_ig_glb_import_settings_t
+{
+    // Stores NORMAL and TANGENT as octahedral encoded 16-bit snorm pairs instead of float3 and
+    // float4. The handedness of the tangent frame is stored in the lowest bit of the second
+    // component of the tangent (set when the bitangent sign is negative).
+    bool octahedral_normals;
+
+    // Stores TEXCOORD_0 as 16-bit half floats.
+    bool half_float_uvs;
+
+    // Stores POSITION as 16-bit unorm values relative to the mesh bounds. Use
+    // `TM_TT_PROP__DCC_ASSET_MESH__BOUNDS_MIN` and `TM_TT_PROP__DCC_ASSET_MESH__BOUNDS_MAX` to
+    // reconstruct the positions.
+    bool quantize_positions;
+
+    // Partitions each triangle primitive into meshlets for cluster culling, see
+    // `meshlet_max_vertices` and `meshlet_max_triangles`. The meshlets of a primitive are stored
+    // in an additional buffer named `meshlets.<mesh>.<primitive>`, which holds four sections. Each
+    // section is described by an accessor into the buffer, which the mesh of the primitive
+    // references through an attribute with one of the meshlet semantics:
+    //
+    // * `MESHLET_DESCRIPTORS`: four uint32 per meshlet: vertex offset, triangle offset (in bytes),
+    //   vertex count and triangle count.
+    // * `MESHLET_BOUNDS`: eight floats per meshlet: bounding sphere center and radius, normal cone
+    //   axis and cutoff. The meshlet faces away from view direction `d` when
+    //   `dot(d, axis) > cutoff`.
+    // * `MESHLET_VERTICES`: the meshlet vertices, uint32 indices into the vertex buffer of the
+    //   primitive.
+    // * `MESHLET_TRIANGLES`: the meshlet triangles, three uint8 indices into the vertices of the
+    //   meshlet.
+    //
+    // The meshlets only cover the full detail indices, so the LOD meshes don't reference them.
+    bool generate_meshlets;
+
+    // Stores the POSITION, NORMAL, TEXCOORD_0 and TANGENT attributes of each vertex together in one
+    // record instead of in separate streams, see `vertex_stride` and `vertex_alignment`. The
+    // accessors of the attributes get the record size as their stride. The skin data is stored in
+    // front of the records as before. Primitives whose streams would start more than 4 GB into the
+    // vertex buffer are always interleaved, since the accessor offsets are 32-bit.
+    bool interleave_vertices;
+
+    // Decodes the embedded PNG and JPEG images and stores a full mip chain of each in an additional
+    // buffer named `mips.<image>`, see `tm_ig_glb_mip_chain_t`. The unmodified image buffer is kept.
+    // The images are decoded in parallel, color textures are filtered in linear space. Images that
+    // can't be decoded (KTX2, CMYK or arithmetic coded JPEG) only get the image buffer.
+    bool decode_images;
+
+    // Block compresses the decoded mip chains on the CPU (requires `decode_images`). Normal maps
+    // are stored as BC5, color textures as BC7 (BC1 or BC3 with the fast preset) and other linear
+    // data as BC1.
+    bool compress_textures;
+    TM_PAD(1);
+
+    // Filter used to downsample the mip levels, see `enum tm_ig_glb_mip_filter`.
+    uint32_t mip_filter;
+
+    // Block compression preset, see `enum tm_ig_glb_compression_quality`.
+    uint32_t compression_quality;
+
+    // Maximum width and height of the decoded images (requires `decode_images`), 0 for no limit.
+    // Larger images are downscaled before their mip chain is generated, keeping the aspect ratio.
+    // The unmodified image buffer is kept at full size.
+    uint32_t max_texture_size;
+
+    // Limits for the images used by each texture slot, indexed by `enum tm_ig_glb_texture_slot`.
+    // Overrides `max_texture_size` unless 0. An image used by several slots gets the largest of
+    // their limits.
+    uint32_t texture_slot_max_size[TM_IG_GLB_TEXTURE_SLOT_COUNT];
+
+    // Number of simplified LOD levels generated for each triangle primitive, at most 8. Each level
+    // is imported as an additional mesh named `<mesh>.<primitive>.lod<level>`, that shares the
+    // vertex data of the primitive and references its own accessor into the index buffer.
+    uint32_t lod_count;
+
+    // Target index count of each LOD level, relative to the previous level.
+    float lod_reduction;
+
+    // Maximum simplification error of the LOD levels, relative to the extents of the primitive.
+    float lod_target_error;
+
+    // Maximum number of vertices (at most 255) and triangles (at most 512) of a meshlet.
+    uint32_t meshlet_max_vertices;
+    uint32_t meshlet_max_triangles;
+
+    // Minimum size in bytes of the interleaved vertex records. The records are padded to this size
+    // if they are smaller, for example to keep the stride the same across meshes with different
+    // attributes. 0 uses the size of the attributes.
+    uint32_t vertex_stride;
+
+    // Alignment of the start and the stride of the interleaved vertex records, rounded up to a
+    // power of two of at least 4 bytes (at most 256).
+    uint32_t vertex_alignment;
+
+    // Splits triangle primitives into several meshes with at most `split_max_vertices` vertices
+    // (at least 3) and at most `split_max_bones` bones with a weight (at least 12) each, 0 for no
+    // limit. The splits are imported in place of the primitive, named like primitives, and each
+    // only lists the bones it uses, so the skinning palettes stay within the GPU limits.
+    uint32_t split_max_vertices;
+    uint32_t split_max_bones;
+
+    // Influences with a weight at or below this are dropped from the skin data, which includes the
+    // zero weight padding of `JOINTS_0`. The largest influence of a vertex is always kept and the
+    // remaining weights are renormalized.
+    float skin_weight_threshold;
+
+    // Maximum number of influences per vertex, 0 for no limit. The largest weights are kept.
+    uint32_t skin_max_influences;
+
+    // Size of the bone indices and weights in the skin data. With 32 (or 0), each influence is a
+    // uint32 bone index followed by a float weight. With 8 or 16, the bone index and a unorm weight
+    // of that size are stored, and the influences of each vertex are padded to 4 bytes. The
+    // quantized weights of a vertex sum up to exactly one. Meshes with more than 256 bones use
+    // 16 bits. Quantized skin data is stored with the
+    // `TM_TT_VALUE__DCC_ASSET_VERTEX__SEMANTIC__SKIN_DATA_QUANTIZED` semantic, and the `BITS` of
+    // its accessor is the size used.
+    uint32_t skin_weight_bits;
+} tm_ig_glb_import_settings_t;
+
 struct tm_ig_glb_api
 {
     // Creates the types used to represent ASSIMP objects in The Truth.
@@ -17,8 +231,15 @@ struct tm_ig_glb_api
 
     // Returns the asset io interface which can be registered to the `tm_asset_io_api`.
     struct tm_asset_io_i *(*io_interface)();
+
+    // Returns the settings used by subsequent imports. Modify the returned struct to change them.
+    tm_ig_glb_import_settings_t *(*import_settings)(void);
 };
 
 #if defined(TM_LINKS_IG_GLB)
 extern struct tm_ig_glb_api* tm_ig_glb_api;
+
+// Sets up and frees the index of Truth buffers that imports share identical payloads through.
+void tm_ig_glb_init_buffer_store(struct tm_allocator_i *a);
+void tm_ig_glb_shutdown_buffer_store(void);
 #endif
@@ -72,12 +72,22 @@ const struct dcc_asset_type_info_t *dcc_asset_ti;
 static void init(struct tm_plugin_o *inst, tm_allocator_i *allocator)
 {
     dcc_asset_ti = tm_dcc_asset_api->truth_type_info();
+    tm_ig_glb_init_buffer_store(allocator);
 }
 
 struct tm_plugin_init_i init_i = {
     .init = init
 };
 
+static void shutdown(struct tm_plugin_o *inst)
+{
+    tm_ig_glb_shutdown_buffer_store();
+}
+
+struct tm_plugin_shutdown_i shutdown_i = {
+    .shutdown = shutdown
+};
+
 static tm_localizer_strings_t localizer__get_strings(uint64_t language)
 {
     typedef struct
@@ -140,6 +150,7 @@ TM_DLL_EXPORT void tm_load_plugin(struct tm_api_registry_api *reg, bool load)
 
     tm_add_or_remove_implementation(reg, load, TM_LOCALIZER_STRINGS_INTERFACE_NAME, localizer__get_strings);
     tm_add_or_remove_implementation(reg, load, TM_PLUGIN_INIT_INTERFACE_NAME, &init_i);
+    tm_add_or_remove_implementation(reg, load, TM_PLUGIN_SHUTDOWN_INTERFACE_NAME, &shutdown_i);
 
     if (load)
         tm_asset_io_api->add_asset_io(tm_ig_glb_api->io_interface());
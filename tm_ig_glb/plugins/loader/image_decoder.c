@@ -0,0 +1,1265 @@
+#include "image_decoder.h"
+
+#include <foundation/allocator.h>
+
+#include <math.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define IMAGE_DECODER_SSE 1
+#include <emmintrin.h>
+#endif
+
+static inline uint32_t read_be16(const uint8_t *p)
+{
+	return (uint32_t)p[0] << 8 | p[1];
+}
+
+static inline uint32_t read_be32(const uint8_t *p)
+{
+	return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+static inline uint8_t clamp_u8(int32_t v)
+{
+	return (uint8_t)(v < 0 ? 0 : v > 255 ? 255 : v);
+}
+
+// Inflate
+
+#define INFLATE_FAST_BITS 9
+
+typedef struct inflate_huffman_t
+{
+	// Codes of at most `INFLATE_FAST_BITS` bits, indexed by the next bits of the stream. Each entry
+	// is `symbol << 4 | length`, or 0 for codes that are longer.
+	uint16_t fast[1 << INFLATE_FAST_BITS];
+
+	// Canonical decoding tables: the number of codes of each length and the symbols ordered by code.
+	uint16_t count[16];
+	uint16_t symbol[288];
+} inflate_huffman_t;
+
+typedef struct inflate_bits_t
+{
+	const uint8_t *p;
+	const uint8_t *end;
+	uint64_t buf;
+	uint32_t count;
+
+	// Zero bytes appended after the end of the data.
+	uint32_t padding;
+} inflate_bits_t;
+
+static inline void inflate_refill(inflate_bits_t *b)
+{
+	while (b->count <= 56) {
+		if (b->p < b->end)
+			b->buf |= (uint64_t)*b->p++ << b->count;
+		else
+			++b->padding;
+		b->count += 8;
+	}
+}
+
+static inline uint32_t inflate_bits(inflate_bits_t *b, uint32_t n)
+{
+	inflate_refill(b);
+	const uint32_t v = (uint32_t)(b->buf & ((1ull << n) - 1));
+	b->buf >>= n;
+	b->count -= n;
+	return v;
+}
+
+static inline uint32_t reverse_bits(uint32_t v, uint32_t n)
+{
+	uint32_t r = 0;
+	for (uint32_t i = 0; i < n; ++i)
+		r |= ((v >> i) & 1) << (n - 1 - i);
+	return r;
+}
+
+static bool inflate_build(inflate_huffman_t *h, const uint8_t *lengths, uint32_t n)
+{
+	memset(h, 0, sizeof(*h));
+	for (uint32_t i = 0; i < n; ++i)
+		++h->count[lengths[i]];
+	h->count[0] = 0;
+
+	// Reject over-subscribed codes, incomplete codes are allowed.
+	int32_t left = 1;
+	for (uint32_t len = 1; len < 16; ++len) {
+		left = (left << 1) - h->count[len];
+		if (left < 0)
+			return false;
+	}
+
+	uint16_t offsets[16];
+	uint32_t next_code[16];
+	offsets[1] = 0;
+	next_code[1] = 0;
+	for (uint32_t len = 1; len < 15; ++len) {
+		offsets[len + 1] = offsets[len] + h->count[len];
+		next_code[len + 1] = (next_code[len] + h->count[len]) << 1;
+	}
+
+	for (uint32_t i = 0; i < n; ++i) {
+		const uint32_t len = lengths[i];
+		if (!len)
+			continue;
+		h->symbol[offsets[len]++] = (uint16_t)i;
+		const uint32_t code = next_code[len]++;
+		if (len <= INFLATE_FAST_BITS) {
+			for (uint32_t j = reverse_bits(code, len); j < (1u << INFLATE_FAST_BITS); j += 1u << len)
+				h->fast[j] = (uint16_t)(i << 4 | len);
+		}
+	}
+	return true;
+}
+
+static int32_t inflate_decode(inflate_bits_t *b, const inflate_huffman_t *h)
+{
+	inflate_refill(b);
+	const uint32_t e = h->fast[b->buf & ((1u << INFLATE_FAST_BITS) - 1)];
+	if (e) {
+		b->buf >>= e & 15;
+		b->count -= e & 15;
+		return e >> 4;
+	}
+
+	int32_t code = 0, first = 0, index = 0;
+	uint64_t bits = b->buf;
+	for (uint32_t len = 1; len < 16; ++len) {
+		code |= (int32_t)(bits & 1);
+		bits >>= 1;
+		const int32_t count = h->count[len];
+		if (code - count < first) {
+			b->buf >>= len;
+			b->count -= len;
+			return h->symbol[index + (code - first)];
+		}
+		index += count;
+		first = (first + count) << 1;
+		code <<= 1;
+	}
+	return -1;
+}
+
+static const uint16_t length_base[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8_t length_extra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const uint16_t dist_base[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const uint8_t dist_extra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+static bool inflate_dynamic_tables(inflate_bits_t *b, inflate_huffman_t *lit, inflate_huffman_t *dist)
+{
+	static const uint8_t order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+	const uint32_t hlit = inflate_bits(b, 5) + 257;
+	const uint32_t hdist = inflate_bits(b, 5) + 1;
+	const uint32_t hclen = inflate_bits(b, 4) + 4;
+	if (hlit > 286 || hdist > 30)
+		return false;
+
+	uint8_t lengths[286 + 30] = { 0 };
+	for (uint32_t i = 0; i < hclen; ++i)
+		lengths[order[i]] = (uint8_t)inflate_bits(b, 3);
+
+	inflate_huffman_t code_lengths;
+	if (!inflate_build(&code_lengths, lengths, 19))
+		return false;
+
+	memset(lengths, 0, sizeof(lengths));
+	uint32_t n = 0;
+	while (n < hlit + hdist) {
+		const int32_t sym = inflate_decode(b, &code_lengths);
+		if (sym < 0)
+			return false;
+		if (sym < 16) {
+			lengths[n++] = (uint8_t)sym;
+			continue;
+		}
+
+		uint8_t value = 0;
+		uint32_t repeat;
+		if (sym == 16) {
+			if (!n)
+				return false;
+			value = lengths[n - 1];
+			repeat = 3 + inflate_bits(b, 2);
+		} else if (sym == 17) {
+			repeat = 3 + inflate_bits(b, 3);
+		} else {
+			repeat = 11 + inflate_bits(b, 7);
+		}
+		if (n + repeat > hlit + hdist)
+			return false;
+		memset(lengths + n, value, repeat);
+		n += repeat;
+	}
+
+	// The end of block code must exist.
+	if (!lengths[256])
+		return false;
+	return inflate_build(lit, lengths, hlit) && inflate_build(dist, lengths + hlit, hdist);
+}
+
+// Decompresses the zlib stream in `data` to exactly `out_size` bytes.
+static bool inflate_zlib(uint8_t *out, uint64_t out_size, const uint8_t *data, uint64_t size)
+{
+	if (size < 2 || (data[0] & 15) != 8 || (data[0] * 256u + data[1]) % 31 != 0 || (data[1] & 32))
+		return false;
+
+	inflate_bits_t b = { .p = data + 2, .end = data + size };
+	inflate_huffman_t lit, dist;
+	uint64_t pos = 0;
+
+	bool final = false;
+	while (!final) {
+		final = inflate_bits(&b, 1);
+		const uint32_t type = inflate_bits(&b, 2);
+
+		if (type == 0) {
+			// Stored block, starts at the next byte boundary.
+			inflate_bits(&b, b.count & 7);
+			const uint32_t len = inflate_bits(&b, 16);
+			const uint32_t nlen = inflate_bits(&b, 16);
+			if ((len ^ 0xffff) != nlen || len > out_size - pos)
+				return false;
+			for (uint32_t i = 0; i < len; ++i)
+				out[pos++] = (uint8_t)inflate_bits(&b, 8);
+		} else if (type == 1 || type == 2) {
+			if (type == 1) {
+				uint8_t lengths[288 + 30];
+				memset(lengths, 8, 144);
+				memset(lengths + 144, 9, 112);
+				memset(lengths + 256, 7, 24);
+				memset(lengths + 280, 8, 8);
+				memset(lengths + 288, 5, 30);
+				inflate_build(&lit, lengths, 288);
+				inflate_build(&dist, lengths + 288, 30);
+			} else if (!inflate_dynamic_tables(&b, &lit, &dist)) {
+				return false;
+			}
+
+			for (;;) {
+				const int32_t sym = inflate_decode(&b, &lit);
+				if (sym < 0 || b.padding > 8)
+					return false;
+				if (sym < 256) {
+					if (pos == out_size)
+						return false;
+					out[pos++] = (uint8_t)sym;
+				} else if (sym == 256) {
+					break;
+				} else {
+					if (sym > 285)
+						return false;
+					const uint32_t len = length_base[sym - 257] + inflate_bits(&b, length_extra[sym - 257]);
+					const int32_t d = inflate_decode(&b, &dist);
+					if (d < 0 || d > 29)
+						return false;
+					const uint32_t distance = dist_base[d] + inflate_bits(&b, dist_extra[d]);
+					if (distance > pos || len > out_size - pos)
+						return false;
+					const uint8_t *src = out + pos - distance;
+					for (uint32_t i = 0; i < len; ++i)
+						out[pos + i] = src[i];
+					pos += len;
+				}
+			}
+		} else {
+			return false;
+		}
+
+		if (b.padding > 8)
+			return false;
+	}
+
+	return pos == out_size;
+}
+
+// PNG
+
+static const uint8_t png_signature[8] = { 137, 'P', 'N', 'G', '\r', '\n', 26, '\n' };
+
+typedef struct png_header_t
+{
+	uint32_t width;
+	uint32_t height;
+	uint8_t bit_depth;
+	uint8_t color_type;
+	uint8_t interlace;
+	uint8_t channels;
+} png_header_t;
+
+static bool png_read_header(const uint8_t *data, uint64_t size, png_header_t *h)
+{
+	if (size < 33 || memcmp(data, png_signature, 8) != 0)
+		return false;
+	if (read_be32(data + 8) != 13 || memcmp(data + 12, "IHDR", 4) != 0)
+		return false;
+
+	const uint8_t *ihdr = data + 16;
+	h->width = read_be32(ihdr);
+	h->height = read_be32(ihdr + 4);
+	h->bit_depth = ihdr[8];
+	h->color_type = ihdr[9];
+	h->interlace = ihdr[12];
+	if (!h->width || !h->height || h->width > IMAGE_DECODER_MAX_DIMENSION || h->height > IMAGE_DECODER_MAX_DIMENSION)
+		return false;
+	if (ihdr[10] != 0 || ihdr[11] != 0 || h->interlace > 1)
+		return false;
+
+	const uint32_t d = h->bit_depth;
+	switch (h->color_type) {
+	case 0:
+		h->channels = 1;
+		return d == 1 || d == 2 || d == 4 || d == 8 || d == 16;
+	case 3:
+		h->channels = 1;
+		return d == 1 || d == 2 || d == 4 || d == 8;
+	case 2:
+		h->channels = 3;
+		return d == 8 || d == 16;
+	case 4:
+		h->channels = 2;
+		return d == 8 || d == 16;
+	case 6:
+		h->channels = 4;
+		return d == 8 || d == 16;
+	default:
+		return false;
+	}
+}
+
+static inline uint8_t paeth(uint8_t a, uint8_t b, uint8_t c)
+{
+	const int32_t p = (int32_t)a + b - c;
+	const int32_t pa = p > a ? p - a : a - p;
+	const int32_t pb = p > b ? p - b : b - p;
+	const int32_t pc = p > c ? p - c : c - p;
+	return pa <= pb && pa <= pc ? a : pb <= pc ? b : c;
+}
+
+// Reverses the filter of `row` in place, `prior` is the previous unfiltered row or NULL.
+static bool png_unfilter(uint8_t *row, const uint8_t *prior, uint32_t row_bytes, uint32_t bpp, uint8_t filter)
+{
+	switch (filter) {
+	case 0:
+		return true;
+	case 1:
+		for (uint32_t i = bpp; i < row_bytes; ++i)
+			row[i] = (uint8_t)(row[i] + row[i - bpp]);
+		return true;
+	case 2:
+		if (prior) {
+			for (uint32_t i = 0; i < row_bytes; ++i)
+				row[i] = (uint8_t)(row[i] + prior[i]);
+		}
+		return true;
+	case 3:
+		for (uint32_t i = 0; i < row_bytes; ++i) {
+			const uint32_t left = i >= bpp ? row[i - bpp] : 0;
+			const uint32_t up = prior ? prior[i] : 0;
+			row[i] = (uint8_t)(row[i] + ((left + up) >> 1));
+		}
+		return true;
+	case 4:
+		for (uint32_t i = 0; i < row_bytes; ++i) {
+			const uint8_t left = i >= bpp ? row[i - bpp] : 0;
+			const uint8_t up = prior ? prior[i] : 0;
+			const uint8_t up_left = prior && i >= bpp ? prior[i - bpp] : 0;
+			row[i] = (uint8_t)(row[i] + paeth(left, up, up_left));
+		}
+		return true;
+	default:
+		return false;
+	}
+}
+
+typedef struct png_palette_t
+{
+	uint8_t rgba[256][4];
+	uint32_t count;
+
+	// Transparent color of gray and RGB images, at the bit depth of the image.
+	uint16_t key[3];
+	bool has_key;
+	TM_PAD(1);
+} png_palette_t;
+
+// Returns sample `i` of `row`, at the bit depth of the image.
+static inline uint32_t png_sample(const uint8_t *row, uint32_t i, uint32_t bit_depth)
+{
+	switch (bit_depth) {
+	case 16:
+		return read_be16(row + i * 2);
+	case 8:
+		return row[i];
+	default: {
+		const uint32_t bit = i * bit_depth;
+		return (row[bit / 8] >> (8 - bit_depth - bit % 8)) & ((1u << bit_depth) - 1);
+	}
+	}
+}
+
+static void png_expand_row(uint8_t *out, uint32_t out_step, const uint8_t *row, uint32_t width, const png_header_t *h, const png_palette_t *palette)
+{
+	const uint32_t d = h->bit_depth;
+	const uint32_t shift = d == 16 ? 8 : 0;
+	for (uint32_t x = 0; x < width; ++x, out += out_step) {
+		switch (h->color_type) {
+		case 0: {
+			const uint32_t g = png_sample(row, x, d);
+			const uint8_t v = d == 16 ? (uint8_t)(g >> 8) : (uint8_t)(g * 255 / ((1u << d) - 1));
+			out[0] = out[1] = out[2] = v;
+			out[3] = palette->has_key && g == palette->key[0] ? 0 : 255;
+			break;
+		}
+		case 2: {
+			const uint32_t r = png_sample(row, x * 3 + 0, d);
+			const uint32_t g = png_sample(row, x * 3 + 1, d);
+			const uint32_t b = png_sample(row, x * 3 + 2, d);
+			out[0] = (uint8_t)(r >> shift);
+			out[1] = (uint8_t)(g >> shift);
+			out[2] = (uint8_t)(b >> shift);
+			out[3] = palette->has_key && r == palette->key[0] && g == palette->key[1] && b == palette->key[2] ? 0 : 255;
+			break;
+		}
+		case 3: {
+			const uint32_t i = png_sample(row, x, d);
+			static const uint8_t black[4] = { 0, 0, 0, 255 };
+			memcpy(out, i < palette->count ? palette->rgba[i] : black, 4);
+			break;
+		}
+		case 4:
+			out[0] = out[1] = out[2] = (uint8_t)(png_sample(row, x * 2 + 0, d) >> shift);
+			out[3] = (uint8_t)(png_sample(row, x * 2 + 1, d) >> shift);
+			break;
+		default:
+			for (uint32_t c = 0; c < 4; ++c)
+				out[c] = (uint8_t)(png_sample(row, x * 4 + c, d) >> shift);
+			break;
+		}
+	}
+}
+
+static bool png_decode(uint8_t *pixels, const uint8_t *data, uint64_t size, tm_allocator_i *a)
+{
+	png_header_t h;
+	if (!png_read_header(data, size, &h))
+		return false;
+
+	png_palette_t palette = { 0 };
+	for (uint32_t i = 0; i < 256; ++i)
+		palette.rgba[i][3] = 255;
+
+	// Collect the palette and the size of the compressed data.
+	uint64_t idat_size = 0;
+	const uint8_t *chunk = data + 8;
+	const uint8_t *end = data + size;
+	while (end - chunk >= 12) {
+		const uint32_t len = read_be32(chunk);
+		if (len > (uint64_t)(end - chunk) - 12)
+			return false;
+		const uint8_t *payload = chunk + 8;
+		if (memcmp(chunk + 4, "PLTE", 4) == 0) {
+			if (len % 3 || len > 768)
+				return false;
+			palette.count = len / 3;
+			for (uint32_t i = 0; i < palette.count; ++i)
+				memcpy(palette.rgba[i], payload + i * 3, 3);
+		} else if (memcmp(chunk + 4, "tRNS", 4) == 0) {
+			if (h.color_type == 3) {
+				for (uint32_t i = 0; i < len && i < 256; ++i)
+					palette.rgba[i][3] = payload[i];
+			} else if (h.color_type == 0 && len >= 2) {
+				palette.has_key = true;
+				palette.key[0] = (uint16_t)read_be16(payload);
+			} else if (h.color_type == 2 && len >= 6) {
+				palette.has_key = true;
+				for (uint32_t c = 0; c < 3; ++c)
+					palette.key[c] = (uint16_t)read_be16(payload + c * 2);
+			}
+		} else if (memcmp(chunk + 4, "IDAT", 4) == 0) {
+			idat_size += len;
+		} else if (memcmp(chunk + 4, "IEND", 4) == 0) {
+			break;
+		}
+		chunk += 12 + len;
+	}
+	if (!idat_size || (h.color_type == 3 && !palette.count))
+		return false;
+
+	uint8_t *idat = tm_alloc(a, idat_size);
+	uint64_t idat_pos = 0;
+	for (chunk = data + 8; end - chunk >= 12; chunk += 12 + read_be32(chunk)) {
+		const uint32_t len = read_be32(chunk);
+		if (memcmp(chunk + 4, "IDAT", 4) == 0) {
+			memcpy(idat + idat_pos, chunk + 8, len);
+			idat_pos += len;
+		} else if (memcmp(chunk + 4, "IEND", 4) == 0) {
+			break;
+		}
+	}
+
+	// Adam7 passes, a non-interlaced image is a single pass.
+	static const uint8_t x_start[7] = { 0, 4, 0, 2, 0, 1, 0 };
+	static const uint8_t y_start[7] = { 0, 0, 4, 0, 2, 0, 1 };
+	static const uint8_t x_step[7] = { 8, 8, 4, 4, 2, 2, 1 };
+	static const uint8_t y_step[7] = { 8, 8, 8, 4, 4, 2, 2 };
+	const uint32_t num_passes = h.interlace ? 7 : 1;
+
+	const uint32_t bits_per_pixel = h.channels * h.bit_depth;
+	const uint32_t bpp = bits_per_pixel < 8 ? 1 : bits_per_pixel / 8;
+
+	uint32_t pass_w[7], pass_h[7];
+	uint64_t raw_size = 0;
+	for (uint32_t p = 0; p < num_passes; ++p) {
+		const uint32_t xs = h.interlace ? x_start[p] : 0, ys = h.interlace ? y_start[p] : 0;
+		const uint32_t xd = h.interlace ? x_step[p] : 1, yd = h.interlace ? y_step[p] : 1;
+		pass_w[p] = h.width > xs ? (h.width - xs + xd - 1) / xd : 0;
+		pass_h[p] = h.height > ys ? (h.height - ys + yd - 1) / yd : 0;
+		if (pass_w[p] && pass_h[p])
+			raw_size += (uint64_t)pass_h[p] * (1 + ((uint64_t)pass_w[p] * bits_per_pixel + 7) / 8);
+	}
+
+	uint8_t *raw = tm_alloc(a, raw_size);
+	bool ok = inflate_zlib(raw, raw_size, idat, idat_size);
+
+	uint8_t *row = raw;
+	for (uint32_t p = 0; ok && p < num_passes; ++p) {
+		if (!pass_w[p] || !pass_h[p])
+			continue;
+		const uint32_t xs = h.interlace ? x_start[p] : 0, ys = h.interlace ? y_start[p] : 0;
+		const uint32_t xd = h.interlace ? x_step[p] : 1, yd = h.interlace ? y_step[p] : 1;
+		const uint32_t row_bytes = (uint32_t)(((uint64_t)pass_w[p] * bits_per_pixel + 7) / 8);
+
+		const uint8_t *prior = NULL;
+		for (uint32_t y = 0; y < pass_h[p]; ++y) {
+			const uint8_t filter = row[0];
+			uint8_t *cur = row + 1;
+			if (!png_unfilter(cur, prior, row_bytes, bpp, filter)) {
+				ok = false;
+				break;
+			}
+			uint8_t *out = pixels + ((uint64_t)(ys + y * yd) * h.width + xs) * 4;
+			png_expand_row(out, xd * 4, cur, pass_w[p], &h, &palette);
+			prior = cur;
+			row = cur + row_bytes;
+		}
+	}
+
+	tm_free(a, raw, raw_size);
+	tm_free(a, idat, idat_size);
+	return ok;
+}
+
+// JPEG
+
+#define JPEG_FAST_BITS 9
+
+typedef struct jpeg_huffman_t
+{
+	// Codes of at most `JPEG_FAST_BITS` bits, indexed by the next bits of the stream. Each entry is
+	// `symbol << 4 | length`, or 0 for codes that are longer.
+	uint16_t fast[1 << JPEG_FAST_BITS];
+
+	uint8_t values[256];
+	int32_t max_code[18];
+	int32_t val_offset[17];
+	bool defined;
+	TM_PAD(3);
+} jpeg_huffman_t;
+
+typedef struct jpeg_component_t
+{
+	uint32_t id;
+	uint32_t h;
+	uint32_t v;
+	uint32_t tq;
+	uint32_t td;
+	uint32_t ta;
+
+	// Blocks covered by the component and the number of allocated blocks, which is rounded up to
+	// whole MCUs.
+	uint32_t blocks_w;
+	uint32_t blocks_h;
+	uint32_t stride_blocks;
+	uint32_t rows_blocks;
+
+	int32_t dc_pred;
+	TM_PAD(4);
+
+	// Coefficients of each block in zigzag order.
+	int16_t *coefs;
+	uint8_t *plane;
+} jpeg_component_t;
+
+typedef struct jpeg_bits_t
+{
+	const uint8_t *p;
+	const uint8_t *end;
+	uint64_t buf;
+	uint32_t count;
+
+	// Set when a marker has been reached, no more data is read until the reader is reset.
+	bool marker;
+	TM_PAD(3);
+} jpeg_bits_t;
+
+typedef struct jpeg_t
+{
+	uint32_t width;
+	uint32_t height;
+	uint32_t num_components;
+	uint32_t h_max;
+	uint32_t v_max;
+	uint32_t mcus_x;
+	uint32_t mcus_y;
+	uint32_t restart_interval;
+	bool progressive;
+	bool rgb;
+	TM_PAD(2);
+	uint32_t eob_run;
+
+	uint16_t quant[4][64];
+
+	// T[x][u] = C(u) / 2 * cos((2x + 1) * u * pi / 16), the 2D IDCT of block F is T * F * T^T.
+	float idct[8][8];
+
+	jpeg_huffman_t dc[4];
+	jpeg_huffman_t ac[4];
+	jpeg_component_t components[3];
+} jpeg_t;
+
+static const uint8_t zigzag_to_natural[64 + 16] = {
+	0, 1, 8, 16, 9, 2, 3, 10, 17, 24, 32, 25, 18, 11, 4, 5,
+	12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6, 7, 14, 21, 28,
+	35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+	58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63,
+	// Padding for corrupt streams that run past the end of the block.
+	63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63
+};
+
+static void jpeg_build_huffman(jpeg_huffman_t *h, const uint8_t *counts)
+{
+	memset(h->fast, 0, sizeof(h->fast));
+	int32_t code = 0;
+	int32_t k = 0;
+	for (uint32_t len = 1; len <= 16; ++len) {
+		h->val_offset[len] = k - code;
+		for (uint32_t i = 0; i < counts[len - 1]; ++i, ++code, ++k) {
+			if (len <= JPEG_FAST_BITS) {
+				const uint32_t first = (uint32_t)code << (JPEG_FAST_BITS - len);
+				for (uint32_t j = 0; j < 1u << (JPEG_FAST_BITS - len); ++j)
+					h->fast[first + j] = (uint16_t)(h->values[k] << 4 | len);
+			}
+		}
+		h->max_code[len] = counts[len - 1] ? code - 1 : -1;
+		code <<= 1;
+	}
+	h->max_code[17] = INT32_MAX;
+	h->defined = true;
+}
+
+static inline void jpeg_refill(jpeg_bits_t *b)
+{
+	while (b->count <= 56) {
+		uint32_t byte = 0;
+		if (!b->marker && b->p < b->end) {
+			byte = *b->p;
+			if (byte == 0xff) {
+				const uint32_t next = b->p + 1 < b->end ? b->p[1] : 0xd9;
+				if (next == 0) {
+					b->p += 2;
+				} else {
+					b->marker = true;
+					byte = 0;
+				}
+			} else {
+				++b->p;
+			}
+		}
+		b->buf |= (uint64_t)byte << (56 - b->count);
+		b->count += 8;
+	}
+}
+
+static inline uint32_t jpeg_bits(jpeg_bits_t *b, uint32_t n)
+{
+	if (!n)
+		return 0;
+	jpeg_refill(b);
+	const uint32_t v = (uint32_t)(b->buf >> (64 - n));
+	b->buf <<= n;
+	b->count -= n;
+	return v;
+}
+
+static inline int32_t jpeg_extend(uint32_t v, uint32_t s)
+{
+	return s && v < (1u << (s - 1)) ? (int32_t)v - (int32_t)(1u << s) + 1 : (int32_t)v;
+}
+
+static inline int32_t jpeg_decode(jpeg_bits_t *b, const jpeg_huffman_t *h)
+{
+	jpeg_refill(b);
+	const uint32_t e = h->fast[b->buf >> (64 - JPEG_FAST_BITS)];
+	if (e) {
+		b->buf <<= e & 15;
+		b->count -= e & 15;
+		return e >> 4;
+	}
+
+	const uint32_t peek = (uint32_t)(b->buf >> 48);
+	for (uint32_t len = JPEG_FAST_BITS + 1; len <= 16; ++len) {
+		const int32_t code = (int32_t)(peek >> (16 - len));
+		if (code <= h->max_code[len]) {
+			b->buf <<= len;
+			b->count -= len;
+			return h->values[(code + h->val_offset[len]) & 255];
+		}
+	}
+	return -1;
+}
+
+static bool jpeg_decode_block(jpeg_t *j, jpeg_bits_t *b, jpeg_component_t *c, int16_t *coefs, uint32_t ss, uint32_t se, uint32_t ah, uint32_t al)
+{
+	if (ss == 0) {
+		// DC coefficient.
+		if (ah == 0) {
+			const int32_t t = jpeg_decode(b, j->dc + c->td);
+			if (t < 0 || t > 16)
+				return false;
+			c->dc_pred += jpeg_extend(jpeg_bits(b, (uint32_t)t), (uint32_t)t);
+			coefs[0] = (int16_t)(c->dc_pred * (1 << al));
+		} else if (jpeg_bits(b, 1)) {
+			coefs[0] = (int16_t)(coefs[0] | (1 << al));
+		}
+		if (!j->progressive) {
+			ss = 1;
+		} else {
+			return true;
+		}
+	}
+
+	const jpeg_huffman_t *ac = j->ac + c->ta;
+	if (ah == 0) {
+		if (j->eob_run) {
+			--j->eob_run;
+			return true;
+		}
+		for (uint32_t k = ss; k <= se;) {
+			const int32_t rs = jpeg_decode(b, ac);
+			if (rs < 0)
+				return false;
+			const uint32_t r = (uint32_t)rs >> 4, s = (uint32_t)rs & 15;
+			if (s == 0) {
+				if (r < 15) {
+					if (j->progressive)
+						j->eob_run = (1u << r) - 1 + jpeg_bits(b, r);
+					break;
+				}
+				k += 16;
+			} else {
+				k += r;
+				if (k > 63)
+					return false;
+				coefs[k++] = (int16_t)(jpeg_extend(jpeg_bits(b, s), s) * (1 << al));
+			}
+		}
+		return true;
+	}
+
+	// Successive approximation refinement of the AC coefficients.
+	const int32_t p1 = 1 << al;
+	const int32_t m1 = -p1;
+	uint32_t k = ss;
+	if (!j->eob_run) {
+		for (; k <= se; ++k) {
+			const int32_t rs = jpeg_decode(b, ac);
+			if (rs < 0)
+				return false;
+			int32_t r = rs >> 4;
+			const uint32_t s = (uint32_t)rs & 15;
+			int32_t v = 0;
+			if (s) {
+				v = jpeg_bits(b, 1) ? p1 : m1;
+			} else if (r != 15) {
+				j->eob_run = (1u << r) + jpeg_bits(b, (uint32_t)r);
+				break;
+			}
+
+			do {
+				int16_t *coef = coefs + k;
+				if (*coef) {
+					if (jpeg_bits(b, 1) && (*coef & p1) == 0)
+						*coef = (int16_t)(*coef + (*coef >= 0 ? p1 : m1));
+				} else {
+					if (--r < 0)
+						break;
+				}
+				++k;
+			} while (k <= se);
+
+			if (v && k <= 63)
+				coefs[k] = (int16_t)v;
+		}
+	}
+
+	if (j->eob_run) {
+		for (; k <= se; ++k) {
+			int16_t *coef = coefs + k;
+			if (*coef && jpeg_bits(b, 1) && (*coef & p1) == 0)
+				*coef = (int16_t)(*coef + (*coef >= 0 ? p1 : m1));
+		}
+		--j->eob_run;
+	}
+	return true;
+}
+
+// Skips to the restart marker that follows the current interval.
+static bool jpeg_restart(jpeg_t *j, jpeg_bits_t *b)
+{
+	if (b->p + 1 >= b->end || b->p[0] != 0xff || b->p[1] < 0xd0 || b->p[1] > 0xd7)
+		return false;
+	b->p += 2;
+	b->buf = 0;
+	b->count = 0;
+	b->marker = false;
+	j->eob_run = 0;
+	for (uint32_t i = 0; i < j->num_components; ++i)
+		j->components[i].dc_pred = 0;
+	return true;
+}
+
+static const uint8_t *jpeg_decode_scan(jpeg_t *j, const uint8_t *p, const uint8_t *end)
+{
+	if (end - p < 2)
+		return NULL;
+	const uint32_t len = read_be16(p);
+	const uint32_t ns = p[2];
+	if (ns < 1 || ns > j->num_components || len != 6 + 2 * ns || (uint64_t)(end - p) < len)
+		return NULL;
+
+	jpeg_component_t *scan[3];
+	for (uint32_t i = 0; i < ns; ++i) {
+		const uint32_t id = p[3 + i * 2];
+		scan[i] = NULL;
+		for (uint32_t c = 0; c < j->num_components; ++c) {
+			if (j->components[c].id == id)
+				scan[i] = j->components + c;
+		}
+		if (!scan[i])
+			return NULL;
+		scan[i]->td = p[4 + i * 2] >> 4;
+		scan[i]->ta = p[4 + i * 2] & 15;
+		if (scan[i]->td > 3 || scan[i]->ta > 3)
+			return NULL;
+	}
+	const uint32_t ss = p[3 + ns * 2];
+	const uint32_t se = p[4 + ns * 2];
+	const uint32_t ah = p[5 + ns * 2] >> 4;
+	const uint32_t al = p[5 + ns * 2] & 15;
+	if (j->progressive) {
+		if (ss > se || se > 63 || (ss == 0 && se != 0) || (ss > 0 && ns != 1) || al > 13)
+			return NULL;
+	} else if (ss != 0 || se != 63 || ah != 0 || al != 0) {
+		return NULL;
+	}
+
+	// Check that the tables needed by the scan are defined.
+	for (uint32_t i = 0; i < ns; ++i) {
+		if ((ss == 0 && ah == 0 && !j->dc[scan[i]->td].defined) || (se > 0 && !j->ac[scan[i]->ta].defined))
+			return NULL;
+		scan[i]->dc_pred = 0;
+	}
+
+	jpeg_bits_t b = { .p = p + len, .end = end };
+	j->eob_run = 0;
+
+	uint32_t todo = j->restart_interval ? j->restart_interval : UINT32_MAX;
+	if (ns == 1) {
+		// Non-interleaved scan, an MCU is a single block.
+		jpeg_component_t *c = scan[0];
+		const uint64_t num_blocks = (uint64_t)c->blocks_w * c->blocks_h;
+		for (uint64_t i = 0; i < num_blocks; ++i) {
+			const uint32_t bx = (uint32_t)(i % c->blocks_w), by = (uint32_t)(i / c->blocks_w);
+			int16_t *coefs = c->coefs + ((uint64_t)by * c->stride_blocks + bx) * 64;
+			if (!jpeg_decode_block(j, &b, c, coefs, ss, se, ah, al))
+				return NULL;
+			if (--todo == 0 && i + 1 < num_blocks) {
+				if (!jpeg_restart(j, &b))
+					return NULL;
+				todo = j->restart_interval;
+			}
+		}
+	} else {
+		const uint64_t num_mcus = (uint64_t)j->mcus_x * j->mcus_y;
+		for (uint64_t m = 0; m < num_mcus; ++m) {
+			const uint32_t mx = (uint32_t)(m % j->mcus_x), my = (uint32_t)(m / j->mcus_x);
+			for (uint32_t i = 0; i < ns; ++i) {
+				jpeg_component_t *c = scan[i];
+				for (uint32_t y = 0; y < c->v; ++y) {
+					for (uint32_t x = 0; x < c->h; ++x) {
+						const uint64_t bx = mx * c->h + x, by = my * c->v + y;
+						int16_t *coefs = c->coefs + (by * c->stride_blocks + bx) * 64;
+						if (!jpeg_decode_block(j, &b, c, coefs, ss, se, ah, al))
+							return NULL;
+					}
+				}
+			}
+			if (--todo == 0 && m + 1 < num_mcus) {
+				if (!jpeg_restart(j, &b))
+					return NULL;
+				todo = j->restart_interval;
+			}
+		}
+	}
+
+	// Continue with the marker that ended the entropy coded data.
+	const uint8_t *next = b.p;
+	while (next + 1 < end && !(next[0] == 0xff && next[1] != 0 && (next[1] < 0xd0 || next[1] > 0xd7)))
+		++next;
+	return next;
+}
+
+static bool jpeg_read_frame(jpeg_t *j, const uint8_t *p, uint32_t len)
+{
+	if (len < 8 || p[2] != 8)
+		return false;
+	j->height = read_be16(p + 3);
+	j->width = read_be16(p + 5);
+	j->num_components = p[7];
+	if (!j->width || !j->height || j->width > IMAGE_DECODER_MAX_DIMENSION || j->height > IMAGE_DECODER_MAX_DIMENSION)
+		return false;
+	if ((j->num_components != 1 && j->num_components != 3) || len != 8 + 3 * j->num_components)
+		return false;
+
+	j->h_max = j->v_max = 1;
+	for (uint32_t i = 0; i < j->num_components; ++i) {
+		jpeg_component_t *c = j->components + i;
+		c->id = p[8 + i * 3];
+		c->h = p[9 + i * 3] >> 4;
+		c->v = p[9 + i * 3] & 15;
+		c->tq = p[10 + i * 3];
+		if (c->h < 1 || c->h > 4 || c->v < 1 || c->v > 4 || c->tq > 3)
+			return false;
+		j->h_max = c->h > j->h_max ? c->h : j->h_max;
+		j->v_max = c->v > j->v_max ? c->v : j->v_max;
+	}
+	// A single component image has no interleaved scans, so its sampling factors don't matter.
+	if (j->num_components == 1)
+		j->components[0].h = j->components[0].v = j->h_max = j->v_max = 1;
+
+	j->mcus_x = (j->width + 8 * j->h_max - 1) / (8 * j->h_max);
+	j->mcus_y = (j->height + 8 * j->v_max - 1) / (8 * j->v_max);
+	for (uint32_t i = 0; i < j->num_components; ++i) {
+		jpeg_component_t *c = j->components + i;
+		c->blocks_w = ((j->width * c->h + j->h_max - 1) / j->h_max + 7) / 8;
+		c->blocks_h = ((j->height * c->v + j->v_max - 1) / j->v_max + 7) / 8;
+		c->stride_blocks = j->mcus_x * c->h;
+		c->rows_blocks = j->mcus_y * c->v;
+	}
+	return true;
+}
+
+static void jpeg_init_idct(float idct_table[8][8])
+{
+	for (uint32_t x = 0; x < 8; ++x) {
+		for (uint32_t u = 0; u < 8; ++u) {
+			const float cu = u == 0 ? 0.70710678f : 1.f;
+			idct_table[x][u] = 0.5f * cu * cosf((float)((2 * x + 1) * u) * 3.14159265f / 16.f);
+		}
+	}
+}
+
+// Dequantizes the zigzag ordered `coefs`, applies the inverse DCT and writes the 8x8 samples to
+// `out`.
+static void jpeg_idct_block(uint8_t *out, uint32_t stride, const int16_t *coefs, const uint16_t *quant, const float idct_table[8][8])
+{
+	float f[64];
+	for (uint32_t k = 0; k < 64; ++k)
+		f[zigzag_to_natural[k]] = (float)coefs[k] * (float)quant[k];
+
+#if IMAGE_DECODER_SSE
+	// Rows: g[v][x] = sum_u f[v][u] * T[x][u], then columns: o[y][x] = sum_v T[y][v] * g[v][x].
+	__m128 t[8][2];
+	for (uint32_t u = 0; u < 8; ++u) {
+		t[u][0] = _mm_setr_ps(idct_table[0][u], idct_table[1][u], idct_table[2][u], idct_table[3][u]);
+		t[u][1] = _mm_setr_ps(idct_table[4][u], idct_table[5][u], idct_table[6][u], idct_table[7][u]);
+	}
+	__m128 g[8][2];
+	for (uint32_t v = 0; v < 8; ++v) {
+		__m128 lo = _mm_setzero_ps(), hi = _mm_setzero_ps();
+		for (uint32_t u = 0; u < 8; ++u) {
+			const __m128 s = _mm_set1_ps(f[v * 8 + u]);
+			lo = _mm_add_ps(lo, _mm_mul_ps(s, t[u][0]));
+			hi = _mm_add_ps(hi, _mm_mul_ps(s, t[u][1]));
+		}
+		g[v][0] = lo;
+		g[v][1] = hi;
+	}
+	const __m128 bias = _mm_set1_ps(128.f);
+	for (uint32_t y = 0; y < 8; ++y) {
+		__m128 lo = bias, hi = bias;
+		for (uint32_t v = 0; v < 8; ++v) {
+			const __m128 s = _mm_set1_ps(idct_table[y][v]);
+			lo = _mm_add_ps(lo, _mm_mul_ps(s, g[v][0]));
+			hi = _mm_add_ps(hi, _mm_mul_ps(s, g[v][1]));
+		}
+		const __m128i i16 = _mm_packs_epi32(_mm_cvtps_epi32(lo), _mm_cvtps_epi32(hi));
+		_mm_storel_epi64((__m128i *)(out + y * stride), _mm_packus_epi16(i16, i16));
+	}
+#else
+	float g[64];
+	for (uint32_t v = 0; v < 8; ++v) {
+		for (uint32_t x = 0; x < 8; ++x) {
+			float s = 0.f;
+			for (uint32_t u = 0; u < 8; ++u)
+				s += f[v * 8 + u] * idct_table[x][u];
+			g[v * 8 + x] = s;
+		}
+	}
+	for (uint32_t y = 0; y < 8; ++y) {
+		for (uint32_t x = 0; x < 8; ++x) {
+			float s = 128.f;
+			for (uint32_t v = 0; v < 8; ++v)
+				s += idct_table[y][v] * g[v * 8 + x];
+			out[y * stride + x] = clamp_u8((int32_t)lrintf(s));
+		}
+	}
+#endif
+}
+
+static bool jpeg_info(const uint8_t *data, uint64_t size, jpeg_t *j)
+{
+	if (size < 4 || data[0] != 0xff || data[1] != 0xd8)
+		return false;
+
+	const uint8_t *p = data + 2;
+	const uint8_t *end = data + size;
+	while (end - p >= 4) {
+		if (p[0] != 0xff) {
+			++p;
+			continue;
+		}
+		const uint8_t marker = p[1];
+		if (marker == 0xff) {
+			++p;
+			continue;
+		}
+		const uint32_t len = read_be16(p + 2);
+		if (len < 2 || len > (uint64_t)(end - p) - 2)
+			return false;
+		if (marker == 0xc0 || marker == 0xc1 || marker == 0xc2) {
+			j->progressive = marker == 0xc2;
+			return jpeg_read_frame(j, p + 2, len);
+		}
+		// Lossless, hierarchical and arithmetic coded frames are not supported.
+		if ((marker >= 0xc3 && marker <= 0xcf && marker != 0xc4 && marker != 0xc8 && marker != 0xcc) || marker == 0xda)
+			return false;
+		p += 2 + len;
+	}
+	return false;
+}
+
+static bool jpeg_decode_image(uint8_t *pixels, const uint8_t *data, uint64_t size, tm_allocator_i *a)
+{
+	jpeg_t *j = tm_alloc(a, sizeof(jpeg_t));
+	memset(j, 0, sizeof(*j));
+	bool ok = jpeg_info(data, size, j);
+	bool adobe_rgb = false;
+	bool frame_read = false;
+
+	if (ok) {
+		for (uint32_t i = 0; i < j->num_components; ++i) {
+			jpeg_component_t *c = j->components + i;
+			const uint64_t n = (uint64_t)c->stride_blocks * c->rows_blocks * 64;
+			c->coefs = tm_alloc(a, n * sizeof(int16_t));
+			memset(c->coefs, 0, n * sizeof(int16_t));
+		}
+	}
+
+	const uint8_t *p = data + 2;
+	const uint8_t *end = data + size;
+	while (ok && end - p >= 2) {
+		if (p[0] != 0xff) {
+			++p;
+			continue;
+		}
+		const uint8_t marker = p[1];
+		if (marker == 0xff || (marker >= 0xd0 && marker <= 0xd7)) {
+			++p;
+			continue;
+		}
+		if (marker == 0xd9)
+			break;
+		if (end - p < 4) {
+			ok = false;
+			break;
+		}
+
+		const uint32_t len = read_be16(p + 2);
+		const uint8_t *seg = p + 4;
+		const uint8_t *seg_end = p + 2 + len;
+		if (len < 2 || seg_end > end) {
+			ok = false;
+			break;
+		}
+
+		switch (marker) {
+		case 0xdb:
+			// Quantization tables.
+			while (seg < seg_end) {
+				const uint32_t pq = seg[0] >> 4, tq = seg[0] & 15;
+				const uint32_t bytes = 1 + 64 * (pq ? 2 : 1);
+				if (tq > 3 || pq > 1 || seg + bytes > seg_end) {
+					ok = false;
+					break;
+				}
+				for (uint32_t k = 0; k < 64; ++k)
+					j->quant[tq][k] = (uint16_t)(pq ? read_be16(seg + 1 + k * 2) : seg[1 + k]);
+				seg += bytes;
+			}
+			break;
+		case 0xc4:
+			// Huffman tables.
+			while (seg < seg_end) {
+				if (seg_end - seg < 17) {
+					ok = false;
+					break;
+				}
+				const uint32_t tc = seg[0] >> 4, th = seg[0] & 15;
+				uint32_t total = 0;
+				for (uint32_t i = 0; i < 16; ++i)
+					total += seg[1 + i];
+				if (tc > 1 || th > 3 || total > 256 || seg + 17 + total > seg_end) {
+					ok = false;
+					break;
+				}
+				jpeg_huffman_t *h = tc ? j->ac + th : j->dc + th;
+				memcpy(h->values, seg + 17, total);
+				jpeg_build_huffman(h, seg + 1);
+				seg += 17 + total;
+			}
+			break;
+		case 0xdd:
+			j->restart_interval = len >= 4 ? read_be16(seg) : 0;
+			break;
+		case 0xee:
+			// Adobe segment, a transform of 0 means that three components are RGB.
+			if (len >= 14 && memcmp(seg, "Adobe", 5) == 0)
+				adobe_rgb = seg[11] == 0;
+			break;
+		case 0xc0:
+		case 0xc1:
+		case 0xc2:
+			frame_read = true;
+			break;
+		case 0xda: {
+			if (!frame_read) {
+				ok = false;
+				break;
+			}
+			const uint8_t *next = jpeg_decode_scan(j, p + 2, end);
+			if (!next) {
+				ok = false;
+				break;
+			}
+			p = next;
+			continue;
+		}
+		default:
+			break;
+		}
+		p = seg_end;
+	}
+
+	if (ok && frame_read) {
+		j->rgb = j->num_components == 3 && (adobe_rgb || (j->components[0].id == 'R' && j->components[1].id == 'G' && j->components[2].id == 'B'));
+		jpeg_init_idct(j->idct);
+
+		for (uint32_t i = 0; i < j->num_components; ++i) {
+			jpeg_component_t *c = j->components + i;
+			const uint32_t stride = c->stride_blocks * 8;
+			c->plane = tm_alloc(a, (uint64_t)stride * c->rows_blocks * 8);
+			for (uint32_t by = 0; by < c->blocks_h; ++by) {
+				for (uint32_t bx = 0; bx < c->blocks_w; ++bx) {
+					const int16_t *coefs = c->coefs + ((uint64_t)by * c->stride_blocks + bx) * 64;
+					jpeg_idct_block(c->plane + ((uint64_t)by * 8 * stride + bx * 8), stride, coefs, j->quant[c->tq], (const float (*)[8])j->idct);
+				}
+			}
+		}
+
+		// Upsample the chroma planes (nearest sample) and convert to RGB.
+		for (uint32_t y = 0; y < j->height; ++y) {
+			const uint8_t *rows[3];
+			uint32_t x_scale[3];
+			for (uint32_t i = 0; i < j->num_components; ++i) {
+				const jpeg_component_t *c = j->components + i;
+				rows[i] = c->plane + (uint64_t)(y * c->v / j->v_max) * c->stride_blocks * 8;
+				x_scale[i] = c->h;
+			}
+			uint8_t *out = pixels + (uint64_t)y * j->width * 4;
+			for (uint32_t x = 0; x < j->width; ++x, out += 4) {
+				if (j->num_components == 1) {
+					out[0] = out[1] = out[2] = rows[0][x];
+				} else {
+					const int32_t c0 = rows[0][x * x_scale[0] / j->h_max];
+					const int32_t c1 = rows[1][x * x_scale[1] / j->h_max];
+					const int32_t c2 = rows[2][x * x_scale[2] / j->h_max];
+					if (j->rgb) {
+						out[0] = (uint8_t)c0;
+						out[1] = (uint8_t)c1;
+						out[2] = (uint8_t)c2;
+					} else {
+						// JFIF YCbCr to RGB in 16.16 fixed point.
+						const int32_t cb = c1 - 128, cr = c2 - 128;
+						const int32_t yy = (c0 << 16) + 32768;
+						out[0] = clamp_u8((yy + 91881 * cr) >> 16);
+						out[1] = clamp_u8((yy - 22554 * cb - 46802 * cr) >> 16);
+						out[2] = clamp_u8((yy + 116130 * cb) >> 16);
+					}
+				}
+				out[3] = 255;
+			}
+		}
+	}
+
+	for (uint32_t i = 0; i < j->num_components; ++i) {
+		jpeg_component_t *c = j->components + i;
+		if (c->coefs)
+			tm_free(a, c->coefs, (uint64_t)c->stride_blocks * c->rows_blocks * 64 * sizeof(int16_t));
+		if (c->plane)
+			tm_free(a, c->plane, (uint64_t)c->stride_blocks * 8 * c->rows_blocks * 8);
+	}
+	tm_free(a, j, sizeof(jpeg_t));
+	return ok && frame_read;
+}
+
+bool image_decoder_info(const uint8_t *data, uint64_t size, uint32_t *width, uint32_t *height)
+{
+	png_header_t png;
+	if (png_read_header(data, size, &png)) {
+		*width = png.width;
+		*height = png.height;
+		return true;
+	}
+
+	jpeg_t jpeg = { 0 };
+	if (jpeg_info(data, size, &jpeg)) {
+		*width = jpeg.width;
+		*height = jpeg.height;
+		return true;
+	}
+	return false;
+}
+
+bool image_decoder_decode_rgba8(uint8_t *pixels, const uint8_t *data, uint64_t size, tm_allocator_i *a)
+{
+	if (size >= 8 && memcmp(data, png_signature, 8) == 0)
+		return png_decode(pixels, data, size, a);
+	return jpeg_decode_image(pixels, data, size, a);
+}
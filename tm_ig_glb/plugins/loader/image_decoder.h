@@ -0,0 +1,22 @@
+#pragma once
+
+#include <foundation/api_types.h>
+
+struct tm_allocator_i;
+
+// Decoders for the PNG and JPEG images embedded in glTF files.
+//
+// PNG supports all color types, bit depths and interlacing. JPEG supports baseline and progressive
+// Huffman coded images with one (grayscale) or three (YCbCr or RGB) components. Everything else
+// (arithmetic coding, 12-bit precision, CMYK) is rejected.
+
+// Largest width and height accepted by the decoders.
+#define IMAGE_DECODER_MAX_DIMENSION 16384
+
+// Reads the size of the PNG or JPEG image in `data`. Returns false if the data isn't a supported
+// image or if the image is larger than `IMAGE_DECODER_MAX_DIMENSION`.
+bool image_decoder_info(const uint8_t *data, uint64_t size, uint32_t *width, uint32_t *height);
+
+// Decodes the image in `data` to `width * height` tightly packed RGBA8 pixels in `pixels`, with
+// the size returned by `image_decoder_info()`. Returns false if the data is malformed.
+bool image_decoder_decode_rgba8(uint8_t *pixels, const uint8_t *data, uint64_t size, struct tm_allocator_i *allocator);
@@ -0,0 +1,686 @@
+#include "meshopt_decoder.h"
+
+#include <math.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define MESHOPT_SSE 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX__)
+#define MESHOPT_AVX 1
+#include <immintrin.h>
+#endif
+
+// Vertex codec
+
+#define VERTEX_HEADER 0xa0
+#define VERTEX_BLOCK_SIZE_BYTES 8192
+#define VERTEX_BLOCK_MAX_SIZE 256
+#define BYTE_GROUP_SIZE 16
+#define BYTE_GROUP_DECODE_LIMIT 24
+#define TAIL_MAX_SIZE 32
+
+static uint32_t vertex_block_size(uint32_t vertex_size)
+{
+	uint32_t result = VERTEX_BLOCK_SIZE_BYTES / vertex_size;
+	result &= ~(BYTE_GROUP_SIZE - 1);
+	return result < VERTEX_BLOCK_MAX_SIZE ? result : VERTEX_BLOCK_MAX_SIZE;
+}
+
+// Decodes a group of 16 bytes that are stored with 0, 2, 4 or 8 bits each. Values that don't fit
+// in 2 or 4 bits are stored as a sentinel followed by the full byte.
+static const uint8_t *decode_bytes_group(const uint8_t *data, uint8_t *buffer, uint32_t bitslog2)
+{
+	switch (bitslog2) {
+	case 0:
+		memset(buffer, 0, BYTE_GROUP_SIZE);
+		return data;
+	case 1:
+	case 2: {
+		const uint32_t bits = 1u << bitslog2;
+		const uint32_t sentinel = (1u << bits) - 1;
+		const uint8_t *data_var = data + bits * 2;
+		for (uint32_t i = 0; i < BYTE_GROUP_SIZE; ++i) {
+			const uint32_t byte = data[(i * bits) / 8];
+			const uint32_t enc = (byte >> (8 - bits - (i * bits) % 8)) & sentinel;
+			buffer[i] = enc == sentinel ? *data_var : (uint8_t)enc;
+			data_var += enc == sentinel;
+		}
+		return data_var;
+	}
+	default:
+		memcpy(buffer, data, BYTE_GROUP_SIZE);
+		return data + BYTE_GROUP_SIZE;
+	}
+}
+
+static const uint8_t *decode_bytes(const uint8_t *data, const uint8_t *data_end, uint8_t *buffer, uint32_t buffer_size)
+{
+	const uint32_t header_size = (buffer_size / BYTE_GROUP_SIZE + 3) / 4;
+	if ((uint64_t)(data_end - data) < header_size)
+		return NULL;
+
+	const uint8_t *header = data;
+	data += header_size;
+
+	for (uint32_t i = 0; i < buffer_size; i += BYTE_GROUP_SIZE) {
+		// Every group reads at most 24 bytes.
+		if ((uint64_t)(data_end - data) < BYTE_GROUP_DECODE_LIMIT)
+			return NULL;
+		const uint32_t group = i / BYTE_GROUP_SIZE;
+		const uint32_t bitslog2 = (header[group / 4] >> ((group % 4) * 2)) & 3;
+		data = decode_bytes_group(data, buffer + i, bitslog2);
+	}
+	return data;
+}
+
+// Undoes the zigzag and delta encoding of one byte of the vertex: `out` is advanced by `stride`
+// for each vertex and `last` holds the value of the previous vertex.
+static void decode_deltas(uint8_t *out, uint32_t stride, const uint8_t *deltas, uint32_t count, uint8_t *last)
+{
+	uint8_t p = *last;
+	uint32_t i = 0;
+#if MESHOPT_SSE
+	for (; i + BYTE_GROUP_SIZE <= count; i += BYTE_GROUP_SIZE) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(deltas + i));
+		const __m128i half = _mm_and_si128(_mm_srli_epi16(v, 1), _mm_set1_epi8(0x7f));
+		const __m128i sign = _mm_sub_epi8(_mm_setzero_si128(), _mm_and_si128(v, _mm_set1_epi8(1)));
+		v = _mm_xor_si128(half, sign);
+
+		// Prefix sum of the 16 deltas.
+		v = _mm_add_epi8(v, _mm_slli_si128(v, 1));
+		v = _mm_add_epi8(v, _mm_slli_si128(v, 2));
+		v = _mm_add_epi8(v, _mm_slli_si128(v, 4));
+		v = _mm_add_epi8(v, _mm_slli_si128(v, 8));
+		v = _mm_add_epi8(v, _mm_set1_epi8((char)p));
+
+		uint8_t values[BYTE_GROUP_SIZE];
+		_mm_storeu_si128((__m128i *)values, v);
+		for (uint32_t j = 0; j < BYTE_GROUP_SIZE; ++j)
+			out[(i + j) * stride] = values[j];
+		p = values[BYTE_GROUP_SIZE - 1];
+	}
+#endif
+	for (; i < count; ++i) {
+		const uint8_t d = deltas[i];
+		p = (uint8_t)(((0u - (d & 1)) ^ (d >> 1)) + p);
+		out[i * stride] = p;
+	}
+	*last = p;
+}
+
+static const uint8_t *decode_vertex_block(const uint8_t *data, const uint8_t *data_end, uint8_t *vertex_data, uint32_t vertex_count, uint32_t vertex_size, uint8_t *last_vertex)
+{
+	uint8_t buffer[VERTEX_BLOCK_MAX_SIZE];
+	const uint32_t vertex_count_aligned = (vertex_count + BYTE_GROUP_SIZE - 1) & ~(BYTE_GROUP_SIZE - 1);
+
+	// The block stores each byte of the vertex as a separate stream.
+	for (uint32_t k = 0; k < vertex_size; ++k) {
+		data = decode_bytes(data, data_end, buffer, vertex_count_aligned);
+		if (!data)
+			return NULL;
+		decode_deltas(vertex_data + k, vertex_size, buffer, vertex_count, last_vertex + k);
+	}
+	return data;
+}
+
+bool meshopt_decode_vertex_buffer(void *destination, uint32_t vertex_count, uint32_t vertex_size, const uint8_t *buffer, uint64_t buffer_size)
+{
+	if (vertex_size == 0 || vertex_size > 256 || vertex_size % 4 != 0)
+		return false;
+	if (buffer_size < 1 + (uint64_t)vertex_size)
+		return false;
+	if (buffer[0] != VERTEX_HEADER)
+		return false;
+
+	const uint8_t *data = buffer + 1;
+	const uint8_t *data_end = buffer + buffer_size;
+
+	// The first vertex is stored at the end of the buffer and is the base of the first delta.
+	uint8_t last_vertex[256];
+	memcpy(last_vertex, data_end - vertex_size, vertex_size);
+
+	const uint32_t block_size = vertex_block_size(vertex_size);
+	uint8_t *vertex_data = destination;
+	for (uint32_t offset = 0; offset < vertex_count; offset += block_size) {
+		const uint32_t count = vertex_count - offset < block_size ? vertex_count - offset : block_size;
+		data = decode_vertex_block(data, data_end, vertex_data + (uint64_t)offset * vertex_size, count, vertex_size, last_vertex);
+		if (!data)
+			return false;
+	}
+
+	const uint32_t tail_size = vertex_size < TAIL_MAX_SIZE ? TAIL_MAX_SIZE : vertex_size;
+	return (uint64_t)(data_end - data) == tail_size;
+}
+
+// Index codecs
+
+#define INDEX_HEADER 0xe0
+#define SEQUENCE_HEADER 0xd0
+
+static uint32_t decode_vbyte(const uint8_t **data)
+{
+	const uint8_t *p = *data;
+	const uint8_t lead = *p++;
+	if (lead < 128) {
+		*data = p;
+		return lead;
+	}
+
+	uint32_t result = lead & 127;
+	uint32_t shift = 7;
+	for (uint32_t i = 0; i < 4; ++i) {
+		const uint8_t group = *p++;
+		result |= (uint32_t)(group & 127) << shift;
+		shift += 7;
+		if (group < 128)
+			break;
+	}
+	*data = p;
+	return result;
+}
+
+static uint32_t decode_index(const uint8_t **data, uint32_t last)
+{
+	const uint32_t v = decode_vbyte(data);
+	const uint32_t d = (v >> 1) ^ (0u - (v & 1));
+	return last + d;
+}
+
+static void write_triangle(void *destination, uint32_t i, uint32_t index_size, uint32_t a, uint32_t b, uint32_t c)
+{
+	if (index_size == 2) {
+		uint16_t *out = (uint16_t *)destination + i;
+		out[0] = (uint16_t)a;
+		out[1] = (uint16_t)b;
+		out[2] = (uint16_t)c;
+	} else {
+		uint32_t *out = (uint32_t *)destination + i;
+		out[0] = a;
+		out[1] = b;
+		out[2] = c;
+	}
+}
+
+typedef struct index_fifos_t
+{
+	uint32_t edges[16][2];
+	uint32_t vertices[16];
+	uint32_t edge_offset;
+	uint32_t vertex_offset;
+} index_fifos_t;
+
+static void push_edge(index_fifos_t *f, uint32_t a, uint32_t b)
+{
+	f->edges[f->edge_offset][0] = a;
+	f->edges[f->edge_offset][1] = b;
+	f->edge_offset = (f->edge_offset + 1) & 15;
+}
+
+static void push_vertex(index_fifos_t *f, uint32_t v, bool cond)
+{
+	f->vertices[f->vertex_offset] = v;
+	f->vertex_offset = (f->vertex_offset + cond) & 15;
+}
+
+bool meshopt_decode_index_buffer(void *destination, uint32_t index_count, uint32_t index_size, const uint8_t *buffer, uint64_t buffer_size)
+{
+	if (index_count % 3 != 0 || (index_size != 2 && index_size != 4))
+		return false;
+
+	// The smallest valid encoding is the header, one code per triangle and the 16 byte table.
+	if (buffer_size < 1 + (uint64_t)index_count / 3 + 16)
+		return false;
+	if ((buffer[0] & 0xf0) != INDEX_HEADER)
+		return false;
+	const uint32_t version = buffer[0] & 0x0f;
+	if (version > 1)
+		return false;
+
+	index_fifos_t f;
+	memset(&f, 0xff, sizeof(f.edges) + sizeof(f.vertices));
+	f.edge_offset = f.vertex_offset = 0;
+
+	uint32_t next = 0;
+	uint32_t last = 0;
+	const uint32_t fecmax = version >= 1 ? 13 : 15;
+
+	const uint8_t *code = buffer + 1;
+	const uint8_t *data = code + index_count / 3;
+	const uint8_t *data_safe_end = buffer + buffer_size - 16;
+	const uint8_t *codeaux_table = data_safe_end;
+
+	for (uint32_t i = 0; i < index_count; i += 3) {
+		// A triangle reads at most 16 bytes of data, so this is the only bounds check needed.
+		if (data > data_safe_end)
+			return false;
+
+		const uint8_t codetri = *code++;
+
+		if (codetri < 0xf0) {
+			// Edge from the edge FIFO, third vertex is next, from the vertex FIFO or free.
+			const uint32_t fe = codetri >> 4;
+			const uint32_t a = f.edges[(f.edge_offset - 1 - fe) & 15][0];
+			const uint32_t b = f.edges[(f.edge_offset - 1 - fe) & 15][1];
+			const uint32_t fec = codetri & 15;
+
+			if (fec < fecmax) {
+				const uint32_t c = fec == 0 ? next : f.vertices[(f.vertex_offset - 1 - fec) & 15];
+				next += fec == 0;
+				write_triangle(destination, i, index_size, a, b, c);
+				push_vertex(&f, c, fec == 0);
+				push_edge(&f, c, b);
+				push_edge(&f, a, c);
+			} else {
+				// 13 and 14 encode last - 1 and last + 1.
+				const uint32_t c = fec != 15 ? last + (fec == 13 ? -1u : 1u) : decode_index(&data, last);
+				last = c;
+				write_triangle(destination, i, index_size, a, b, c);
+				push_vertex(&f, c, true);
+				push_edge(&f, c, b);
+				push_edge(&f, a, c);
+			}
+		} else if (codetri < 0xfe) {
+			// New triangle, the FIFO indices of b and c are looked up in the table.
+			const uint8_t codeaux = codeaux_table[codetri & 15];
+			const uint32_t feb = codeaux >> 4;
+			const uint32_t fec = codeaux & 15;
+
+			const uint32_t a = next++;
+			const uint32_t b = feb == 0 ? next : f.vertices[(f.vertex_offset - feb) & 15];
+			next += feb == 0;
+			const uint32_t c = fec == 0 ? next : f.vertices[(f.vertex_offset - fec) & 15];
+			next += fec == 0;
+
+			write_triangle(destination, i, index_size, a, b, c);
+			push_vertex(&f, a, true);
+			push_vertex(&f, b, feb == 0);
+			push_vertex(&f, c, fec == 0);
+			push_edge(&f, b, a);
+			push_edge(&f, c, b);
+			push_edge(&f, a, c);
+		} else {
+			// New triangle with an explicit codeaux byte, any vertex can be free.
+			const uint8_t codeaux = *data++;
+			const uint32_t fea = codetri == 0xfe ? 0 : 15;
+			const uint32_t feb = codeaux >> 4;
+			const uint32_t fec = codeaux & 15;
+
+			// A zero codeaux that isn't in the table resets the vertex numbering.
+			if (codeaux == 0)
+				next = 0;
+
+			uint32_t a = fea == 0 ? next++ : 0;
+			uint32_t b = feb == 0 ? next++ : f.vertices[(f.vertex_offset - feb) & 15];
+			uint32_t c = fec == 0 ? next++ : f.vertices[(f.vertex_offset - fec) & 15];
+
+			if (fea == 15)
+				last = a = decode_index(&data, last);
+			if (feb == 15)
+				last = b = decode_index(&data, last);
+			if (fec == 15)
+				last = c = decode_index(&data, last);
+
+			write_triangle(destination, i, index_size, a, b, c);
+			push_vertex(&f, a, true);
+			push_vertex(&f, b, feb == 0 || feb == 15);
+			push_vertex(&f, c, fec == 0 || fec == 15);
+			push_edge(&f, b, a);
+			push_edge(&f, c, b);
+			push_edge(&f, a, c);
+		}
+	}
+
+	// All the data must have been consumed, up to the codeaux table.
+	return data == data_safe_end;
+}
+
+bool meshopt_decode_index_sequence(void *destination, uint32_t index_count, uint32_t index_size, const uint8_t *buffer, uint64_t buffer_size)
+{
+	if (index_size != 2 && index_size != 4)
+		return false;
+
+	// The smallest valid encoding is the header, one byte per index and a 4 byte tail.
+	if (buffer_size < 1 + (uint64_t)index_count + 4)
+		return false;
+	if ((buffer[0] & 0xf0) != SEQUENCE_HEADER)
+		return false;
+	const uint32_t version = buffer[0] & 0x0f;
+	if (version > 1)
+		return false;
+
+	const uint8_t *data = buffer + 1;
+	const uint8_t *data_safe_end = buffer + buffer_size - 4;
+	uint32_t last[2] = { 0, 0 };
+
+	for (uint32_t i = 0; i < index_count; ++i) {
+		// An index reads at most 5 bytes, the tail makes this safe.
+		if (data >= data_safe_end)
+			return false;
+
+		uint32_t v = decode_vbyte(&data);
+
+		// The lowest bit selects one of two baselines, the rest is a zigzag delta.
+		const uint32_t current = v & 1;
+		v >>= 1;
+		const uint32_t index = last[current] + ((v >> 1) ^ (0u - (v & 1)));
+		last[current] = index;
+
+		if (index_size == 2)
+			((uint16_t *)destination)[i] = (uint16_t)index;
+		else
+			((uint32_t *)destination)[i] = index;
+	}
+
+	return data == data_safe_end;
+}
+
+// Filters
+
+static inline int32_t round_to_int(float v)
+{
+	return (int32_t)(v + (v >= 0.f ? 0.5f : -0.5f));
+}
+
+static void decode_oct8_scalar(int8_t *data, uint32_t count)
+{
+	for (uint32_t i = 0; i < count; ++i) {
+		int8_t *n = data + i * 4;
+		float x = n[0], y = n[1];
+		const float z = (float)n[2] - fabsf(x) - fabsf(y);
+
+		// Unfold the lower hemisphere.
+		const float t = z < 0.f ? z : 0.f;
+		x += x >= 0.f ? t : -t;
+		y += y >= 0.f ? t : -t;
+
+		const float s = 127.f / sqrtf(x * x + y * y + z * z);
+		n[0] = (int8_t)round_to_int(x * s);
+		n[1] = (int8_t)round_to_int(y * s);
+		n[2] = (int8_t)round_to_int(z * s);
+	}
+}
+
+static void decode_oct16_scalar(int16_t *data, uint32_t count)
+{
+	for (uint32_t i = 0; i < count; ++i) {
+		int16_t *n = data + i * 4;
+		float x = n[0], y = n[1];
+		const float z = (float)n[2] - fabsf(x) - fabsf(y);
+
+		const float t = z < 0.f ? z : 0.f;
+		x += x >= 0.f ? t : -t;
+		y += y >= 0.f ? t : -t;
+
+		const float s = 32767.f / sqrtf(x * x + y * y + z * z);
+		n[0] = (int16_t)round_to_int(x * s);
+		n[1] = (int16_t)round_to_int(y * s);
+		n[2] = (int16_t)round_to_int(z * s);
+	}
+}
+
+static void decode_quat_scalar(int16_t *data, uint32_t count)
+{
+	const float scale = 1.f / sqrtf(2.f);
+	for (uint32_t i = 0; i < count; ++i) {
+		int16_t *q = data + i * 4;
+
+		// The 4th component holds the range of the other components in the upper bits and the
+		// index of the omitted (largest) component in the two lowest bits.
+		const int32_t sf = q[3] | 3;
+		const float ss = scale / (float)sf;
+		const float x = (float)q[0] * ss, y = (float)q[1] * ss, z = (float)q[2] * ss;
+		const float ww = 1.f - x * x - y * y - z * z;
+		const float w = sqrtf(ww >= 0.f ? ww : 0.f);
+
+		const uint32_t qc = q[3] & 3;
+		const int16_t xf = (int16_t)round_to_int(x * 32767.f);
+		const int16_t yf = (int16_t)round_to_int(y * 32767.f);
+		const int16_t zf = (int16_t)round_to_int(z * 32767.f);
+		const int16_t wf = (int16_t)round_to_int(w * 32767.f);
+		q[(qc + 1) & 3] = xf;
+		q[(qc + 2) & 3] = yf;
+		q[(qc + 3) & 3] = zf;
+		q[(qc + 0) & 3] = wf;
+	}
+}
+
+static void decode_exp_scalar(uint32_t *data, uint32_t count)
+{
+	for (uint32_t i = 0; i < count; ++i) {
+		const uint32_t v = data[i];
+		const int32_t m = (int32_t)(v << 8) >> 8;
+		const int32_t e = (int32_t)v >> 24;
+
+		// ldexp(m, e), building 2^e directly in the exponent bits.
+		union { float f; uint32_t u; } p;
+		p.u = (uint32_t)(e + 127) << 23;
+		p.f *= (float)m;
+		data[i] = p.u;
+	}
+}
+
+#if MESHOPT_SSE
+
+// Splits 4 interleaved 16-bit vectors into sign extended 32-bit x, y, z and w lanes.
+static inline void load_int16x4(const int16_t *data, __m128i *x, __m128i *y, __m128i *z, __m128i *w)
+{
+	const __m128i n0 = _mm_loadu_si128((const __m128i *)data);
+	const __m128i n1 = _mm_loadu_si128((const __m128i *)(data + 8));
+	const __m128i a = _mm_unpacklo_epi16(n0, n1);
+	const __m128i b = _mm_unpackhi_epi16(n0, n1);
+	const __m128i xy = _mm_unpacklo_epi16(a, b);
+	const __m128i zw = _mm_unpackhi_epi16(a, b);
+	*x = _mm_srai_epi32(_mm_unpacklo_epi16(xy, xy), 16);
+	*y = _mm_srai_epi32(_mm_unpackhi_epi16(xy, xy), 16);
+	*z = _mm_srai_epi32(_mm_unpacklo_epi16(zw, zw), 16);
+	*w = _mm_srai_epi32(_mm_unpackhi_epi16(zw, zw), 16);
+}
+
+static inline void store_int16x4(int16_t *data, __m128i x, __m128i y, __m128i z, __m128i w)
+{
+	const __m128i xy = _mm_packs_epi32(x, y);
+	const __m128i zw = _mm_packs_epi32(z, w);
+	const __m128i xz = _mm_unpacklo_epi16(xy, zw);
+	const __m128i yw = _mm_unpackhi_epi16(xy, zw);
+	_mm_storeu_si128((__m128i *)data, _mm_unpacklo_epi16(xz, yw));
+	_mm_storeu_si128((__m128i *)(data + 8), _mm_unpackhi_epi16(xz, yw));
+}
+
+// Octahedral decode of 4 lanes, `x`, `y` and `z` are replaced with the normalized vector scaled
+// by `max`.
+static inline void oct_sse(__m128 *x, __m128 *y, __m128 *z, float max)
+{
+	const __m128 sign = _mm_set1_ps(-0.f);
+	*z = _mm_sub_ps(*z, _mm_add_ps(_mm_andnot_ps(sign, *x), _mm_andnot_ps(sign, *y)));
+	const __m128 t = _mm_min_ps(*z, _mm_setzero_ps());
+	*x = _mm_add_ps(*x, _mm_xor_ps(t, _mm_and_ps(*x, sign)));
+	*y = _mm_add_ps(*y, _mm_xor_ps(t, _mm_and_ps(*y, sign)));
+	const __m128 ll = _mm_add_ps(_mm_mul_ps(*x, *x), _mm_add_ps(_mm_mul_ps(*y, *y), _mm_mul_ps(*z, *z)));
+	const __m128 s = _mm_div_ps(_mm_set1_ps(max), _mm_sqrt_ps(ll));
+	*x = _mm_mul_ps(*x, s);
+	*y = _mm_mul_ps(*y, s);
+	*z = _mm_mul_ps(*z, s);
+}
+
+static void decode_oct8_sse(int8_t *data, uint32_t count)
+{
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		const __m128i n = _mm_loadu_si128((const __m128i *)(data + i * 4));
+		__m128 x = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(n, 24), 24));
+		__m128 y = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(n, 16), 24));
+		__m128 z = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(n, 8), 24));
+		oct_sse(&x, &y, &z, 127.f);
+
+		const __m128i mask = _mm_set1_epi32(0xff);
+		__m128i r = _mm_and_si128(n, _mm_set1_epi32((int)0xff000000));
+		r = _mm_or_si128(r, _mm_and_si128(_mm_cvtps_epi32(x), mask));
+		r = _mm_or_si128(r, _mm_slli_epi32(_mm_and_si128(_mm_cvtps_epi32(y), mask), 8));
+		r = _mm_or_si128(r, _mm_slli_epi32(_mm_and_si128(_mm_cvtps_epi32(z), mask), 16));
+		_mm_storeu_si128((__m128i *)(data + i * 4), r);
+	}
+	decode_oct8_scalar(data + i * 4, count - i);
+}
+
+#if MESHOPT_AVX
+
+static inline __m256 combine_ps(__m128i lo, __m128i hi)
+{
+	return _mm256_cvtepi32_ps(_mm256_insertf128_si256(_mm256_castsi128_si256(lo), hi, 1));
+}
+
+// 8 lane version of `oct_sse()`.
+static inline void oct_avx(__m256 *x, __m256 *y, __m256 *z, float max)
+{
+	const __m256 sign = _mm256_set1_ps(-0.f);
+	*z = _mm256_sub_ps(*z, _mm256_add_ps(_mm256_andnot_ps(sign, *x), _mm256_andnot_ps(sign, *y)));
+	const __m256 t = _mm256_min_ps(*z, _mm256_setzero_ps());
+	*x = _mm256_add_ps(*x, _mm256_xor_ps(t, _mm256_and_ps(*x, sign)));
+	*y = _mm256_add_ps(*y, _mm256_xor_ps(t, _mm256_and_ps(*y, sign)));
+	const __m256 ll = _mm256_add_ps(_mm256_mul_ps(*x, *x), _mm256_add_ps(_mm256_mul_ps(*y, *y), _mm256_mul_ps(*z, *z)));
+	const __m256 s = _mm256_div_ps(_mm256_set1_ps(max), _mm256_sqrt_ps(ll));
+	*x = _mm256_mul_ps(*x, s);
+	*y = _mm256_mul_ps(*y, s);
+	*z = _mm256_mul_ps(*z, s);
+}
+
+#endif
+
+static void decode_oct16_sse(int16_t *data, uint32_t count)
+{
+	uint32_t i = 0;
+#if MESHOPT_AVX
+	for (; i + 8 <= count; i += 8) {
+		__m128i x0, y0, z0, w0, x1, y1, z1, w1;
+		load_int16x4(data + i * 4, &x0, &y0, &z0, &w0);
+		load_int16x4(data + i * 4 + 16, &x1, &y1, &z1, &w1);
+		__m256 x = combine_ps(x0, x1), y = combine_ps(y0, y1), z = combine_ps(z0, z1);
+		oct_avx(&x, &y, &z, 32767.f);
+		const __m256i xi = _mm256_cvtps_epi32(x), yi = _mm256_cvtps_epi32(y), zi = _mm256_cvtps_epi32(z);
+		store_int16x4(data + i * 4, _mm256_castsi256_si128(xi), _mm256_castsi256_si128(yi), _mm256_castsi256_si128(zi), w0);
+		store_int16x4(data + i * 4 + 16, _mm256_extractf128_si256(xi, 1), _mm256_extractf128_si256(yi, 1), _mm256_extractf128_si256(zi, 1), w1);
+	}
+#endif
+	for (; i + 4 <= count; i += 4) {
+		__m128i xi, yi, zi, wi;
+		load_int16x4(data + i * 4, &xi, &yi, &zi, &wi);
+		__m128 x = _mm_cvtepi32_ps(xi), y = _mm_cvtepi32_ps(yi), z = _mm_cvtepi32_ps(zi);
+		oct_sse(&x, &y, &z, 32767.f);
+		store_int16x4(data + i * 4, _mm_cvtps_epi32(x), _mm_cvtps_epi32(y), _mm_cvtps_epi32(z), wi);
+	}
+	decode_oct16_scalar(data + i * 4, count - i);
+}
+
+// Writes the 4 decoded quaternions of a SIMD batch, the component order depends on the omitted
+// component of each quaternion so this is done per lane.
+static inline void scatter_quat(int16_t *data, const int32_t *x, const int32_t *y, const int32_t *z, const int32_t *w, uint32_t count)
+{
+	for (uint32_t l = 0; l < count; ++l) {
+		int16_t *q = data + l * 4;
+		const uint32_t qc = q[3] & 3;
+		q[(qc + 1) & 3] = (int16_t)x[l];
+		q[(qc + 2) & 3] = (int16_t)y[l];
+		q[(qc + 3) & 3] = (int16_t)z[l];
+		q[(qc + 0) & 3] = (int16_t)w[l];
+	}
+}
+
+static void decode_quat_sse(int16_t *data, uint32_t count)
+{
+	const float scale = 1.f / sqrtf(2.f);
+	uint32_t i = 0;
+#if MESHOPT_AVX
+	for (; i + 8 <= count; i += 8) {
+		__m128i x0, y0, z0, w0, x1, y1, z1, w1;
+		load_int16x4(data + i * 4, &x0, &y0, &z0, &w0);
+		load_int16x4(data + i * 4 + 16, &x1, &y1, &z1, &w1);
+		const __m128i three = _mm_set1_epi32(3);
+		const __m256 ss = _mm256_div_ps(_mm256_set1_ps(scale), combine_ps(_mm_or_si128(w0, three), _mm_or_si128(w1, three)));
+		const __m256 x = _mm256_mul_ps(combine_ps(x0, x1), ss);
+		const __m256 y = _mm256_mul_ps(combine_ps(y0, y1), ss);
+		const __m256 z = _mm256_mul_ps(combine_ps(z0, z1), ss);
+		const __m256 ww = _mm256_sub_ps(_mm256_set1_ps(1.f), _mm256_add_ps(_mm256_mul_ps(x, x), _mm256_add_ps(_mm256_mul_ps(y, y), _mm256_mul_ps(z, z))));
+		const __m256 w = _mm256_sqrt_ps(_mm256_max_ps(ww, _mm256_setzero_ps()));
+
+		const __m256 k = _mm256_set1_ps(32767.f);
+		int32_t xs[8], ys[8], zs[8], ws[8];
+		_mm256_storeu_si256((__m256i *)xs, _mm256_cvtps_epi32(_mm256_mul_ps(x, k)));
+		_mm256_storeu_si256((__m256i *)ys, _mm256_cvtps_epi32(_mm256_mul_ps(y, k)));
+		_mm256_storeu_si256((__m256i *)zs, _mm256_cvtps_epi32(_mm256_mul_ps(z, k)));
+		_mm256_storeu_si256((__m256i *)ws, _mm256_cvtps_epi32(_mm256_mul_ps(w, k)));
+		scatter_quat(data + i * 4, xs, ys, zs, ws, 8);
+	}
+#endif
+	for (; i + 4 <= count; i += 4) {
+		__m128i xi, yi, zi, wi;
+		load_int16x4(data + i * 4, &xi, &yi, &zi, &wi);
+		const __m128 ss = _mm_div_ps(_mm_set1_ps(scale), _mm_cvtepi32_ps(_mm_or_si128(wi, _mm_set1_epi32(3))));
+		const __m128 x = _mm_mul_ps(_mm_cvtepi32_ps(xi), ss);
+		const __m128 y = _mm_mul_ps(_mm_cvtepi32_ps(yi), ss);
+		const __m128 z = _mm_mul_ps(_mm_cvtepi32_ps(zi), ss);
+		const __m128 ww = _mm_sub_ps(_mm_set1_ps(1.f), _mm_add_ps(_mm_mul_ps(x, x), _mm_add_ps(_mm_mul_ps(y, y), _mm_mul_ps(z, z))));
+		const __m128 w = _mm_sqrt_ps(_mm_max_ps(ww, _mm_setzero_ps()));
+
+		const __m128 k = _mm_set1_ps(32767.f);
+		int32_t xs[4], ys[4], zs[4], ws[4];
+		_mm_storeu_si128((__m128i *)xs, _mm_cvtps_epi32(_mm_mul_ps(x, k)));
+		_mm_storeu_si128((__m128i *)ys, _mm_cvtps_epi32(_mm_mul_ps(y, k)));
+		_mm_storeu_si128((__m128i *)zs, _mm_cvtps_epi32(_mm_mul_ps(z, k)));
+		_mm_storeu_si128((__m128i *)ws, _mm_cvtps_epi32(_mm_mul_ps(w, k)));
+		scatter_quat(data + i * 4, xs, ys, zs, ws, 4);
+	}
+	decode_quat_scalar(data + i * 4, count - i);
+}
+
+static void decode_exp_sse(uint32_t *data, uint32_t count)
+{
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		const __m128i v = _mm_loadu_si128((const __m128i *)(data + i));
+		const __m128i m = _mm_srai_epi32(_mm_slli_epi32(v, 8), 8);
+		const __m128i e = _mm_srai_epi32(v, 24);
+		const __m128i p = _mm_slli_epi32(_mm_add_epi32(e, _mm_set1_epi32(127)), 23);
+		const __m128 r = _mm_mul_ps(_mm_castsi128_ps(p), _mm_cvtepi32_ps(m));
+		_mm_storeu_si128((__m128i *)(data + i), _mm_castps_si128(r));
+	}
+	decode_exp_scalar(data + i, count - i);
+}
+
+#endif
+
+void meshopt_decode_filter_oct(void *buffer, uint32_t count, uint32_t stride)
+{
+#if MESHOPT_SSE
+	if (stride == 4)
+		decode_oct8_sse(buffer, count);
+	else
+		decode_oct16_sse(buffer, count);
+#else
+	if (stride == 4)
+		decode_oct8_scalar(buffer, count);
+	else
+		decode_oct16_scalar(buffer, count);
+#endif
+}
+
+void meshopt_decode_filter_quat(void *buffer, uint32_t count, uint32_t stride)
+{
+	(void)stride;
+#if MESHOPT_SSE
+	decode_quat_sse(buffer, count);
+#else
+	decode_quat_scalar(buffer, count);
+#endif
+}
+
+void meshopt_decode_filter_exp(void *buffer, uint32_t count, uint32_t stride)
+{
+#if MESHOPT_SSE
+	decode_exp_sse(buffer, count * (stride / 4));
+#else
+	decode_exp_scalar(buffer, count * (stride / 4));
+#endif
+}
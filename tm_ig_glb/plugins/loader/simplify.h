@@ -0,0 +1,38 @@
+#pragma once
+
+#include <foundation/api_types.h>
+
+struct tm_allocator_i;
+
+// Vertex data used by `simplify_indices()` to decide which edges can be collapsed. Only
+// `positions` is required, the other streams are optional.
+typedef struct simplify_vertices_t
+{
+    // 3 floats per vertex.
+    const float *positions;
+
+    // 3 floats per vertex.
+    const float *normals;
+
+    // 2 floats per vertex.
+    const float *texcoords;
+
+    // 4 joint indices and 4 weights per vertex.
+    const uint32_t *joints;
+    const float *weights;
+
+    uint32_t num_vertices;
+    TM_PAD(4);
+} simplify_vertices_t;
+
+// Simplifies the triangle list `indices` towards `target_index_count` indices using quadric edge
+// collapses, without exceeding `target_error` (relative to the extents of the mesh).
+//
+// Vertices that sit on UV or normal seams are kept in place, vertices on open borders only slide
+// along the border and collapses between vertices with different skin influences are penalized.
+//
+// All indices must be less than `vertices->num_vertices`, they are not checked. The result is
+// written to `out`, which must have room for `num_indices` indices, and only references vertices
+// of the original vertex buffer. Returns the number of indices written.
+uint32_t simplify_indices(uint32_t *out, const uint32_t *indices, uint32_t num_indices, const simplify_vertices_t *vertices,
+    uint32_t target_index_count, float target_error, struct tm_allocator_i *allocator);
@@ -0,0 +1,35 @@
+#include "vertex_layout.h"
+
+uint64_t vertex_layout_plan(vertex_layout_t *layout, const vertex_format_t formats[VERTEX_STREAM_COUNT], uint32_t num_vertices,
+	uint64_t offset, bool interleave, uint32_t min_stride, uint32_t alignment)
+{
+	*layout = (vertex_layout_t){ 0 };
+	uint64_t *offsets[VERTEX_STREAM_COUNT] = { &layout->position_offset, &layout->normal_offset, &layout->texcoord_offset, &layout->tangent_offset };
+
+	uint64_t size = offset;
+	uint64_t last_stream_offset = 0;
+	for (uint32_t i = 0; i < VERTEX_STREAM_COUNT; ++i) {
+		if (!formats[i].component_count)
+			continue;
+		*offsets[i] = last_stream_offset = size;
+		size += vertex_stream_size(formats[i], num_vertices);
+	}
+
+	if (!num_vertices || (!interleave && last_stream_offset <= UINT32_MAX))
+		return size;
+
+	// One record per vertex. The attributes of a record are 4-byte aligned.
+	uint32_t record_size = 0;
+	for (uint32_t i = 0; i < VERTEX_STREAM_COUNT; ++i) {
+		if (!formats[i].component_count)
+			continue;
+		*offsets[i] = record_size;
+		record_size = (uint32_t)align_up(record_size + vertex_format_size(formats[i]), 4);
+	}
+
+	const uint64_t records_offset = align_up(offset, alignment);
+	layout->stride = (uint32_t)align_up(record_size > min_stride ? record_size : min_stride, alignment);
+	for (uint32_t i = 0; i < VERTEX_STREAM_COUNT; ++i)
+		*offsets[i] += records_offset;
+	return records_offset + (uint64_t)layout->stride * num_vertices;
+}
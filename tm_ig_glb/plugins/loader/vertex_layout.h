@@ -0,0 +1,75 @@
+#pragma once
+
+#include <foundation/api_types.h>
+
+// Layout of the vertex streams in the vertex buffer of an imported primitive.
+
+typedef struct vertex_format_t
+{
+	uint32_t bits;
+	uint32_t component_count;
+	bool is_float;
+	bool is_signed;
+	bool is_normalized;
+} vertex_format_t;
+
+// Streams of a vertex buffer, in the order they are stored.
+enum vertex_stream {
+	VERTEX_STREAM_POSITION,
+	VERTEX_STREAM_NORMAL,
+	VERTEX_STREAM_TEXCOORD,
+	VERTEX_STREAM_TANGENT,
+	VERTEX_STREAM_COUNT,
+};
+
+// Layout of the POSITION, NORMAL, TEXCOORD and TANGENT streams in the vertex buffer of a primitive,
+// see `interleave_vertices` in the import settings.
+typedef struct vertex_layout_t
+{
+	// Offset of the first element of each stream from the start of the vertex buffer. The vertex
+	// buffer can be larger than 4 GB, but the accessor offsets are 32-bit.
+	uint64_t position_offset;
+	uint64_t normal_offset;
+	uint64_t texcoord_offset;
+	uint64_t tangent_offset;
+
+	// Distance in bytes between the vertex records if the streams are interleaved, 0 if they are
+	// stored one after the other.
+	uint32_t stride;
+	TM_PAD(4);
+} vertex_layout_t;
+
+static inline uint32_t vertex_format_size(vertex_format_t format)
+{
+	return format.bits / 8 * format.component_count;
+}
+
+// Size of a vertex stream, rounded up so that the following stream starts 4-byte aligned.
+static inline uint64_t vertex_stream_size(vertex_format_t format, uint32_t num_vertices)
+{
+	return ((uint64_t)vertex_format_size(format) * num_vertices + 3) & ~3ull;
+}
+
+// Rounds `x` up to a multiple of `alignment`, which must be a power of two.
+static inline uint64_t align_up(uint64_t x, uint64_t alignment)
+{
+	return (x + alignment - 1) & ~(alignment - 1);
+}
+
+// Returns the distance in bytes between two elements of a stream with `format`.
+static inline uint32_t vertex_layout_stride(const vertex_layout_t *layout, vertex_format_t format)
+{
+	return layout->stride ? layout->stride : vertex_format_size(format);
+}
+
+// Lays out `num_vertices` vertices of the streams in `formats`, indexed by `enum vertex_stream`,
+// after `offset` bytes of other data. Streams with a `component_count` of 0 are left out.
+//
+// The streams are stored one after the other unless `interleave` is set. Since the accessor
+// offsets are 32-bit, primitives whose streams wouldn't start within the first 4 GB of the buffer
+// are interleaved as well, then all streams start in the first record. Interleaved records are at
+// least `min_stride` bytes and aligned to `alignment`, a power of two of at least 4.
+//
+// Returns the size of the vertex buffer.
+uint64_t vertex_layout_plan(vertex_layout_t *layout, const vertex_format_t formats[VERTEX_STREAM_COUNT], uint32_t num_vertices,
+	uint64_t offset, bool interleave, uint32_t min_stride, uint32_t alignment);
@@ -9,6 +9,12 @@ newoption {
     description = "Force use of CLANG for Windows builds"
  }
 
+newoption {
+    trigger     = "draco",
+    value       = "PATH",
+    description = "Decode KHR_draco_mesh_compression with the Draco library installed at PATH"
+}
+
  function lib_path(path)
     local lib_dir = os.getenv("TM_LIB_DIR")
 
@@ -152,9 +158,25 @@ project "tm_ig_glb"
     language "C++"
     targetdir "bin/%{cfg.buildcfg}/plugins"
     defines { "TM_LINKS_IG_GLB" }
-    files {"plugins/loader/**.inl", "plugins/loader/**.h", "plugins/loader/**.c"}
+    files {"plugins/loader/**.inl", "plugins/loader/**.h", "plugins/loader/**.c", "plugins/loader/**.cpp"}
     sysincludedirs { "" }
     filter "platforms:Win64"
     targetdir "$(TM_SDK_DIR)/bin/plugins"
     links { }
     includedirs { "plugins/loader/include" }
+
+    filter {}
+    if _OPTIONS["draco"] then
+        defines { "TM_IG_DRACO" }
+        includedirs { path.join(_OPTIONS["draco"], "include") }
+        libdirs { path.join(_OPTIONS["draco"], "lib") }
+        links { "draco" }
+    end
+
+project "vertex_layout_check"
+    location "build/vertex_layout_check"
+    kind "ConsoleApp"
+    language "C"
+    targetdir "bin/%{cfg.buildcfg}"
+    files { "tests/vertex_layout_check.c", "plugins/loader/vertex_layout.h", "plugins/loader/vertex_layout.c" }
+    sysincludedirs { "" }
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <foundation/api_types.h>
+
+// Decoder for primitives compressed with the `KHR_draco_mesh_compression` glTF extension.
+//
+// The decoding is done by the Draco library, which is only linked when the plugin is built with
+// the `--draco=<path>` premake option (this defines `TM_IG_DRACO`). Without it
+// `draco_decoder_available()` returns false and files that use the extension can't be imported.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Component types of the decoded attribute streams.
+enum draco_component_type {
+    DRACO_COMPONENT_TYPE_INT8,
+    DRACO_COMPONENT_TYPE_UINT8,
+    DRACO_COMPONENT_TYPE_INT16,
+    DRACO_COMPONENT_TYPE_UINT16,
+    DRACO_COMPONENT_TYPE_UINT32,
+    DRACO_COMPONENT_TYPE_FLOAT32,
+};
+
+// Destination of a single decoded attribute.
+typedef struct draco_attribute_output_t
+{
+    // Unique id of the attribute in the Draco bitstream, as given by the extension's attribute map.
+    uint32_t unique_id;
+
+    // Number of components per vertex, 1 - 4.
+    uint32_t num_components;
+
+    // Type of the components written to `data`, one of `enum draco_component_type`. Values are
+    // converted from the type stored in the bitstream.
+    uint32_t component_type;
+
+    TM_PAD(4);
+
+    // Tightly packed destination of `num_components` components for each vertex.
+    void *data;
+} draco_attribute_output_t;
+
+// Returns true if the plugin was built with Draco support.
+bool draco_decoder_available(void);
+
+// Decodes the Draco mesh in `buffer`. The mesh must have exactly `vertex_count` vertices and
+// `index_count` indices, these come from the glTF accessors the decoded data replaces.
+//
+// The triangle list is written to `indices` with `index_size` bytes (1, 2 or 4) per index and each
+// attribute to the destination described by `attributes`. Returns false if the data is malformed
+// or doesn't match the expected counts.
+bool draco_decode_mesh(const uint8_t *buffer, uint64_t buffer_size, uint32_t vertex_count,
+    void *indices, uint32_t index_count, uint32_t index_size,
+    const draco_attribute_output_t *attributes, uint32_t num_attributes);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,228 @@
+#include "meshlet.h"
+
+#include <foundation/allocator.h>
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+uint32_t meshlets_bound(uint32_t num_indices, uint32_t max_vertices, uint32_t max_triangles)
+{
+	// A meshlet is only closed when the next triangle doesn't fit, so it either holds at least
+	// `max_vertices - 2` vertices or `max_triangles` triangles.
+	const uint32_t num_triangles = num_indices / 3;
+	const uint32_t by_vertices = (num_indices + max_vertices - 3) / (max_vertices - 2);
+	const uint32_t by_triangles = (num_triangles + max_triangles - 1) / max_triangles;
+	return by_vertices + by_triangles;
+}
+
+static void triangle_centroid(float out[3], const float *positions, const uint32_t *tri)
+{
+	for (uint32_t k = 0; k < 3; ++k)
+		out[k] = (positions[tri[0] * 3 + k] + positions[tri[1] * 3 + k] + positions[tri[2] * 3 + k]) / 3.0f;
+}
+
+uint32_t build_meshlets(meshlet_t *meshlets, uint32_t *meshlet_vertices, uint8_t *meshlet_triangles,
+	const uint32_t *indices, uint32_t num_indices, const float *positions, uint32_t num_vertices,
+	uint32_t max_vertices, uint32_t max_triangles, tm_allocator_i *a)
+{
+	const uint32_t num_triangles = num_indices / 3;
+	if (!num_triangles)
+		return 0;
+
+	// Vertex to triangle adjacency, `live` counts the triangles of each vertex that haven't been
+	// added to a meshlet yet.
+	uint32_t *offsets = tm_alloc(a, (num_vertices + 1) * sizeof(uint32_t));
+	uint32_t *live = tm_alloc(a, num_vertices * sizeof(uint32_t));
+	uint32_t *adjacency = tm_alloc(a, num_triangles * 3 * sizeof(uint32_t));
+	uint8_t *emitted = tm_alloc(a, num_triangles);
+	uint8_t *local = tm_alloc(a, num_vertices);
+
+	memset(live, 0, num_vertices * sizeof(uint32_t));
+	for (uint32_t i = 0; i < num_triangles * 3; ++i)
+		++live[indices[i]];
+	offsets[0] = 0;
+	for (uint32_t v = 0; v < num_vertices; ++v)
+		offsets[v + 1] = offsets[v] + live[v];
+	memset(live, 0, num_vertices * sizeof(uint32_t));
+	for (uint32_t i = 0; i < num_triangles * 3; ++i) {
+		const uint32_t v = indices[i];
+		adjacency[offsets[v] + live[v]++] = i / 3;
+	}
+	memset(emitted, 0, num_triangles);
+	memset(local, 0xff, num_vertices);
+
+	uint32_t num_meshlets = 0;
+	meshlet_t meshlet = { 0 };
+	float centroid_sum[3] = { 0.0f, 0.0f, 0.0f };
+	float bmin[3] = { 0.0f, 0.0f, 0.0f }, bmax[3] = { 0.0f, 0.0f, 0.0f };
+	uint32_t seed = 0;
+
+	for (uint32_t emitted_count = 0; emitted_count < num_triangles; ++emitted_count) {
+		// Prefer the unused triangle around the meshlet that adds the fewest vertices, then the one
+		// closest to the center of the meshlet. Fall back to the next unused triangle in index order.
+		uint32_t best = UINT32_MAX;
+		uint32_t best_extra = 4;
+		float best_distance = FLT_MAX;
+		const float inv_count = meshlet.triangle_count ? 1.0f / (float)meshlet.triangle_count : 0.0f;
+		const float center[3] = { centroid_sum[0] * inv_count, centroid_sum[1] * inv_count, centroid_sum[2] * inv_count };
+		for (uint32_t i = 0; i < meshlet.vertex_count; ++i) {
+			const uint32_t v = meshlet_vertices[meshlet.vertex_offset + i];
+			if (!live[v])
+				continue;
+			for (uint32_t j = offsets[v]; j < offsets[v + 1]; ++j) {
+				const uint32_t t = adjacency[j];
+				if (emitted[t])
+					continue;
+				const uint32_t *tri = indices + t * 3;
+				const uint32_t extra = (local[tri[0]] == 0xff) + (local[tri[1]] == 0xff) + (local[tri[2]] == 0xff);
+				if (extra > best_extra)
+					continue;
+				float c[3];
+				triangle_centroid(c, positions, tri);
+				const float distance = (c[0] - center[0]) * (c[0] - center[0]) + (c[1] - center[1]) * (c[1] - center[1]) + (c[2] - center[2]) * (c[2] - center[2]);
+				if (extra < best_extra || distance < best_distance || (distance == best_distance && t < best)) {
+					best = t;
+					best_extra = extra;
+					best_distance = distance;
+				}
+			}
+		}
+		bool is_far = false;
+		if (best == UINT32_MAX) {
+			while (emitted[seed])
+				++seed;
+			best = seed;
+
+			// Only continue the meshlet with a disconnected triangle when it is close by,
+			// otherwise the bounding sphere would grow too large to be useful for culling.
+			float c[3];
+			triangle_centroid(c, positions, indices + best * 3);
+			const float grow = 0.5f * sqrtf((bmax[0] - bmin[0]) * (bmax[0] - bmin[0]) + (bmax[1] - bmin[1]) * (bmax[1] - bmin[1]) + (bmax[2] - bmin[2]) * (bmax[2] - bmin[2]));
+			for (uint32_t k = 0; k < 3; ++k)
+				is_far = is_far || c[k] < bmin[k] - grow || c[k] > bmax[k] + grow;
+		}
+
+		const uint32_t *tri = indices + best * 3;
+		const uint32_t extra = (local[tri[0]] == 0xff) + (local[tri[1]] == 0xff) + (local[tri[2]] == 0xff);
+		if (meshlet.triangle_count && (is_far || meshlet.vertex_count + extra > max_vertices || meshlet.triangle_count + 1 > max_triangles)) {
+			for (uint32_t i = 0; i < meshlet.vertex_count; ++i)
+				local[meshlet_vertices[meshlet.vertex_offset + i]] = 0xff;
+			meshlets[num_meshlets++] = meshlet;
+			meshlet = (meshlet_t){
+				.vertex_offset = meshlet.vertex_offset + meshlet.vertex_count,
+				.triangle_offset = meshlet.triangle_offset + meshlet.triangle_count * 3,
+			};
+			centroid_sum[0] = centroid_sum[1] = centroid_sum[2] = 0.0f;
+		}
+		if (!meshlet.triangle_count) {
+			for (uint32_t k = 0; k < 3; ++k)
+				bmin[k] = bmax[k] = positions[tri[0] * 3 + k];
+		}
+
+		for (uint32_t k = 0; k < 3; ++k) {
+			const uint32_t v = tri[k];
+			if (local[v] == 0xff) {
+				local[v] = (uint8_t)meshlet.vertex_count;
+				meshlet_vertices[meshlet.vertex_offset + meshlet.vertex_count++] = v;
+			}
+			meshlet_triangles[meshlet.triangle_offset + meshlet.triangle_count * 3 + k] = local[v];
+			--live[v];
+			for (uint32_t j = 0; j < 3; ++j) {
+				bmin[j] = fminf(bmin[j], positions[v * 3 + j]);
+				bmax[j] = fmaxf(bmax[j], positions[v * 3 + j]);
+			}
+		}
+		float c[3];
+		triangle_centroid(c, positions, tri);
+		centroid_sum[0] += c[0], centroid_sum[1] += c[1], centroid_sum[2] += c[2];
+		++meshlet.triangle_count;
+		emitted[best] = 1;
+	}
+	if (meshlet.triangle_count)
+		meshlets[num_meshlets++] = meshlet;
+
+	tm_free(a, local, num_vertices);
+	tm_free(a, emitted, num_triangles);
+	tm_free(a, adjacency, num_triangles * 3 * sizeof(uint32_t));
+	tm_free(a, live, num_vertices * sizeof(uint32_t));
+	tm_free(a, offsets, (num_vertices + 1) * sizeof(uint32_t));
+	return num_meshlets;
+}
+
+void compute_meshlet_bounds(meshlet_bounds_t *bounds, const meshlet_t *meshlets, uint32_t num_meshlets,
+	const uint32_t *meshlet_vertices, const uint8_t *meshlet_triangles, const float *positions)
+{
+	for (uint32_t m = 0; m < num_meshlets; ++m) {
+		const meshlet_t *meshlet = meshlets + m;
+		const uint32_t *vertices = meshlet_vertices + meshlet->vertex_offset;
+		const uint8_t *triangles = meshlet_triangles + meshlet->triangle_offset;
+		meshlet_bounds_t *b = bounds + m;
+
+		// Ritter's bounding sphere: start from the two vertices furthest apart along a line, then
+		// grow the sphere to include the remaining vertices.
+		const float *p0 = positions + vertices[0] * 3;
+		const float *p1 = p0, *p2 = p0;
+		float d1 = 0.0f;
+		for (uint32_t i = 0; i < meshlet->vertex_count; ++i) {
+			const float *p = positions + vertices[i] * 3;
+			const float d = (p[0] - p0[0]) * (p[0] - p0[0]) + (p[1] - p0[1]) * (p[1] - p0[1]) + (p[2] - p0[2]) * (p[2] - p0[2]);
+			if (d > d1)
+				p1 = p, d1 = d;
+		}
+		float d2 = 0.0f;
+		for (uint32_t i = 0; i < meshlet->vertex_count; ++i) {
+			const float *p = positions + vertices[i] * 3;
+			const float d = (p[0] - p1[0]) * (p[0] - p1[0]) + (p[1] - p1[1]) * (p[1] - p1[1]) + (p[2] - p1[2]) * (p[2] - p1[2]);
+			if (d > d2)
+				p2 = p, d2 = d;
+		}
+		float center[3] = { (p1[0] + p2[0]) * 0.5f, (p1[1] + p2[1]) * 0.5f, (p1[2] + p2[2]) * 0.5f };
+		float radius = sqrtf(d2) * 0.5f;
+		for (uint32_t i = 0; i < meshlet->vertex_count; ++i) {
+			const float *p = positions + vertices[i] * 3;
+			const float e[3] = { p[0] - center[0], p[1] - center[1], p[2] - center[2] };
+			const float d = sqrtf(e[0] * e[0] + e[1] * e[1] + e[2] * e[2]);
+			if (d > radius) {
+				const float k = (d - radius) * 0.5f / d;
+				center[0] += e[0] * k, center[1] += e[1] * k, center[2] += e[2] * k;
+				radius = (radius + d) * 0.5f;
+			}
+		}
+		memcpy(b->center, center, sizeof(center));
+		b->radius = radius;
+
+		// Normal cone: the axis is the area weighted average normal, the cutoff is the sine of
+		// the largest angle between the axis and a triangle normal.
+		float normals[MESHLET_MAX_TRIANGLES][3];
+		float axis[3] = { 0.0f, 0.0f, 0.0f };
+		uint32_t num_normals = 0;
+		for (uint32_t t = 0; t < meshlet->triangle_count; ++t) {
+			const float *a = positions + vertices[triangles[t * 3 + 0]] * 3;
+			const float *c = positions + vertices[triangles[t * 3 + 1]] * 3;
+			const float *d = positions + vertices[triangles[t * 3 + 2]] * 3;
+			const float e0[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+			const float e1[3] = { d[0] - a[0], d[1] - a[1], d[2] - a[2] };
+			const float n[3] = { e0[1] * e1[2] - e0[2] * e1[1], e0[2] * e1[0] - e0[0] * e1[2], e0[0] * e1[1] - e0[1] * e1[0] };
+			const float len = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+			if (len == 0.0f)
+				continue;
+			axis[0] += n[0], axis[1] += n[1], axis[2] += n[2];
+			normals[num_normals][0] = n[0] / len;
+			normals[num_normals][1] = n[1] / len;
+			normals[num_normals][2] = n[2] / len;
+			++num_normals;
+		}
+		const float axis_len = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+		float min_dot = axis_len > 0.0f ? 1.0f : -1.0f;
+		if (axis_len > 0.0f) {
+			axis[0] /= axis_len, axis[1] /= axis_len, axis[2] /= axis_len;
+			for (uint32_t i = 0; i < num_normals; ++i) {
+				const float d = normals[i][0] * axis[0] + normals[i][1] * axis[1] + normals[i][2] * axis[2];
+				min_dot = d < min_dot ? d : min_dot;
+			}
+		}
+		memcpy(b->cone_axis, axis, sizeof(axis));
+		b->cone_cutoff = min_dot <= 0.0f ? 1.0f : sqrtf(1.0f - min_dot * min_dot);
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <foundation/api_types.h>
+
+struct tm_allocator_i;
+
+// A cluster of triangles that reference at most `max_vertices` vertices. The triangles index into
+// the meshlet vertex list with 8-bit local indices, three per triangle.
+typedef struct meshlet_t
+{
+    // Offset into the meshlet vertex array.
+    uint32_t vertex_offset;
+
+    // Offset into the meshlet triangle array, in bytes.
+    uint32_t triangle_offset;
+
+    uint32_t vertex_count;
+    uint32_t triangle_count;
+} meshlet_t;
+
+typedef struct meshlet_bounds_t
+{
+    // Bounding sphere of the meshlet.
+    float center[3];
+    float radius;
+
+    // Normal cone of the meshlet. All triangles of the meshlet face away from the view direction
+    // `d` when `dot(d, cone_axis) > cone_cutoff`. `cone_cutoff` is 1 when the triangles face too
+    // many different directions for the meshlet to be back-face culled.
+    float cone_axis[3];
+    float cone_cutoff;
+} meshlet_bounds_t;
+
+// Maximum number of vertices and triangles of a single meshlet.
+#define MESHLET_MAX_VERTICES 255
+#define MESHLET_MAX_TRIANGLES 512
+
+// Returns the maximum number of meshlets `build_meshlets()` can produce for `num_indices` indices.
+uint32_t meshlets_bound(uint32_t num_indices, uint32_t max_vertices, uint32_t max_triangles);
+
+// Partitions the triangle list `indices` into meshlets, growing each meshlet from adjacent
+// triangles that add the fewest new vertices. The result only depends on the input, so it is
+// the same on every run.
+//
+// `meshlets` must have room for `meshlets_bound()` meshlets, `meshlet_vertices` for `num_indices`
+// vertices and `meshlet_triangles` for `num_indices` bytes. All indices must be less than
+// `num_vertices`, they are not checked. Returns the number of meshlets.
+uint32_t build_meshlets(meshlet_t *meshlets, uint32_t *meshlet_vertices, uint8_t *meshlet_triangles,
+    const uint32_t *indices, uint32_t num_indices, const float *positions, uint32_t num_vertices,
+    uint32_t max_vertices, uint32_t max_triangles, struct tm_allocator_i *allocator);
+
+// Computes the bounding sphere and normal cone of each meshlet.
+void compute_meshlet_bounds(meshlet_bounds_t *bounds, const meshlet_t *meshlets, uint32_t num_meshlets,
+    const uint32_t *meshlet_vertices, const uint8_t *meshlet_triangles, const float *positions);
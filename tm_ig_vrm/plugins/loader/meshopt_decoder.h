@@ -0,0 +1,30 @@
+#pragma once
+
+#include <foundation/api_types.h>
+
+// Decoders for the bitstreams of the `EXT_meshopt_compression` glTF extension.
+//
+// The decoders return false if the data is malformed. They never read outside of `buffer` or
+// write outside of the destination, so they are safe to use with untrusted files.
+
+// Decodes `vertex_count` vertices of `vertex_size` bytes (the `ATTRIBUTES` mode).
+// `vertex_size` must be a multiple of 4 and at most 256.
+bool meshopt_decode_vertex_buffer(void *destination, uint32_t vertex_count, uint32_t vertex_size, const uint8_t *buffer, uint64_t buffer_size);
+
+// Decodes a triangle list of `index_count` indices (the `TRIANGLES` mode). `index_size` is 2 or 4.
+bool meshopt_decode_index_buffer(void *destination, uint32_t index_count, uint32_t index_size, const uint8_t *buffer, uint64_t buffer_size);
+
+// Decodes a sequence of `index_count` indices (the `INDICES` mode). `index_size` is 2 or 4.
+bool meshopt_decode_index_sequence(void *destination, uint32_t index_count, uint32_t index_size, const uint8_t *buffer, uint64_t buffer_size);
+
+// Filters that are applied in place after decoding the vertex data.
+
+// `OCTAHEDRAL`: 4 snorm8 or snorm16 components (`stride` 4 or 8) to a normalized vector, the
+// fourth component is preserved.
+void meshopt_decode_filter_oct(void *buffer, uint32_t count, uint32_t stride);
+
+// `QUATERNION`: 4 snorm16 components with the largest one omitted to a normalized quaternion.
+void meshopt_decode_filter_quat(void *buffer, uint32_t count, uint32_t stride);
+
+// `EXPONENTIAL`: each 32-bit component with an 8-bit exponent and 24-bit mantissa to a float.
+void meshopt_decode_filter_exp(void *buffer, uint32_t count, uint32_t stride);
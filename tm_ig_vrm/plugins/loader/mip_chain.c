@@ -0,0 +1,417 @@
+#include "mip_chain.h"
+
+#include <foundation/allocator.h>
+
+#include <math.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define MIP_CHAIN_SSE 1
+#include <emmintrin.h>
+#endif
+
+// Kaiser filter, in source texels. The taps of a destination texel are the six source texels
+// centered on the 2x2 block it covers.
+#define KAISER_RADIUS 3
+#define KAISER_TAPS (2 * KAISER_RADIUS)
+#define KAISER_BETA 4.0
+
+// Number of entries in the linear to sRGB table, enough to keep the error below one sRGB step.
+#define SRGB_TABLE_SIZE 4096
+
+uint32_t mip_chain_levels(uint32_t width, uint32_t height)
+{
+	uint32_t levels = 1;
+	while ((width > 1 || height > 1) && levels < MIP_CHAIN_MAX_LEVELS) {
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+		++levels;
+	}
+	return levels;
+}
+
+uint64_t mip_chain_size(uint32_t width, uint32_t height, uint64_t *offsets)
+{
+	const uint32_t levels = mip_chain_levels(width, height);
+	uint64_t size = 0;
+	for (uint32_t i = 0; i < levels; ++i) {
+		if (offsets)
+			offsets[i] = size;
+		size += (uint64_t)width * height * 4;
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+	return size;
+}
+
+// Floating point RGBA texels.
+
+#if MIP_CHAIN_SSE
+
+typedef __m128 texel_t;
+
+static inline texel_t texel_zero(void)
+{
+	return _mm_setzero_ps();
+}
+
+static inline texel_t texel_madd(texel_t acc, const float *t, float w)
+{
+	return _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(t), _mm_set1_ps(w)));
+}
+
+static inline void texel_store(float *t, texel_t v)
+{
+	_mm_storeu_ps(t, v);
+}
+
+#else
+
+typedef struct texel_t
+{
+	float v[4];
+} texel_t;
+
+static inline texel_t texel_zero(void)
+{
+	return (texel_t){ 0 };
+}
+
+static inline texel_t texel_madd(texel_t acc, const float *t, float w)
+{
+	for (uint32_t c = 0; c < 4; ++c)
+		acc.v[c] += t[c] * w;
+	return acc;
+}
+
+static inline void texel_store(float *t, texel_t v)
+{
+	memcpy(t, v.v, sizeof(v.v));
+}
+
+#endif
+
+static inline float srgb_to_linear(float c)
+{
+	return c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+}
+
+static inline float linear_to_srgb(float c)
+{
+	return c <= 0.0031308f ? c * 12.92f : 1.055f * powf(c, 1.0f / 2.4f) - 0.055f;
+}
+
+// Fills the RGBA8 to linear table and, for sRGB images, the linear to sRGB table.
+static void init_tables(float *to_linear, uint8_t *to_srgb, bool srgb)
+{
+	for (uint32_t i = 0; i < 256; ++i)
+		to_linear[i] = srgb ? srgb_to_linear((float)i / 255.0f) : (float)i / 255.0f;
+
+	if (srgb) {
+		for (uint32_t i = 0; i < SRGB_TABLE_SIZE; ++i)
+			to_srgb[i] = (uint8_t)(linear_to_srgb((float)i / (SRGB_TABLE_SIZE - 1)) * 255.0f + 0.5f);
+	}
+}
+
+static void decode_level(float *out, const uint8_t *in, uint64_t count, const float *to_linear)
+{
+	for (uint64_t i = 0; i < count; ++i) {
+		out[i * 4 + 0] = to_linear[in[i * 4 + 0]];
+		out[i * 4 + 1] = to_linear[in[i * 4 + 1]];
+		out[i * 4 + 2] = to_linear[in[i * 4 + 2]];
+		out[i * 4 + 3] = (float)in[i * 4 + 3] * (1.0f / 255.0f);
+	}
+}
+
+// Quantizes the texels in `in` to RGBA8. If `to_srgb` is set, the color channels are looked up in
+// the linear to sRGB table.
+static void encode_level(uint8_t *out, const float *in, uint64_t count, const uint8_t *to_srgb)
+{
+	const float color_scale = to_srgb ? (float)(SRGB_TABLE_SIZE - 1) : 255.0f;
+#if MIP_CHAIN_SSE
+	const __m128 scale = _mm_setr_ps(color_scale, color_scale, color_scale, 255.0f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	for (uint64_t i = 0; i < count; ++i) {
+		const __m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i * 4), zero), one);
+		int32_t q[4];
+		_mm_storeu_si128((__m128i *)q, _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, scale), half)));
+		out[i * 4 + 0] = to_srgb ? to_srgb[q[0]] : (uint8_t)q[0];
+		out[i * 4 + 1] = to_srgb ? to_srgb[q[1]] : (uint8_t)q[1];
+		out[i * 4 + 2] = to_srgb ? to_srgb[q[2]] : (uint8_t)q[2];
+		out[i * 4 + 3] = (uint8_t)q[3];
+	}
+#else
+	for (uint64_t i = 0; i < count; ++i) {
+		for (uint32_t c = 0; c < 4; ++c) {
+			const float v = in[i * 4 + c] < 0.0f ? 0.0f : in[i * 4 + c] > 1.0f ? 1.0f : in[i * 4 + c];
+			const uint32_t q = (uint32_t)(v * (c < 3 ? color_scale : 255.0f) + 0.5f);
+			out[i * 4 + c] = c < 3 && to_srgb ? to_srgb[q] : (uint8_t)q;
+		}
+	}
+#endif
+}
+
+static void downsample_box(float *dst, const float *src, uint32_t width, uint32_t height, uint32_t dst_width, uint32_t dst_height)
+{
+	for (uint32_t y = 0; y < dst_height; ++y) {
+		const float *row0 = src + (uint64_t)(2 * y < height ? 2 * y : height - 1) * width * 4;
+		const float *row1 = src + (uint64_t)(2 * y + 1 < height ? 2 * y + 1 : height - 1) * width * 4;
+		float *out = dst + (uint64_t)y * dst_width * 4;
+		for (uint32_t x = 0; x < dst_width; ++x) {
+			const uint32_t x0 = 2 * x < width ? 2 * x : width - 1;
+			const uint32_t x1 = 2 * x + 1 < width ? 2 * x + 1 : width - 1;
+			texel_t acc = texel_zero();
+			acc = texel_madd(acc, row0 + x0 * 4, 0.25f);
+			acc = texel_madd(acc, row0 + x1 * 4, 0.25f);
+			acc = texel_madd(acc, row1 + x0 * 4, 0.25f);
+			acc = texel_madd(acc, row1 + x1 * 4, 0.25f);
+			texel_store(out + x * 4, acc);
+		}
+	}
+}
+
+static inline uint32_t kaiser_tap(uint32_t dst, uint32_t tap, uint32_t size)
+{
+	const int64_t i = (int64_t)dst * 2 - (KAISER_RADIUS - 1) + tap;
+	return i < 0 ? 0 : i >= size ? size - 1 : (uint32_t)i;
+}
+
+// Downsamples the rows of `src` to `dst_width` texels.
+static void kaiser_horizontal(float *dst, const float *src, uint32_t width, uint32_t height, uint32_t dst_width, const float *weights)
+{
+	for (uint32_t y = 0; y < height; ++y) {
+		const float *row = src + (uint64_t)y * width * 4;
+		float *out = dst + (uint64_t)y * dst_width * 4;
+		for (uint32_t x = 0; x < dst_width; ++x) {
+			texel_t acc = texel_zero();
+			for (uint32_t t = 0; t < KAISER_TAPS; ++t)
+				acc = texel_madd(acc, row + kaiser_tap(x, t, width) * 4, weights[t]);
+			texel_store(out + x * 4, acc);
+		}
+	}
+}
+
+// Downsamples the columns of `src` to `dst_height` texels.
+static void kaiser_vertical(float *dst, const float *src, uint32_t width, uint32_t height, uint32_t dst_height, const float *weights)
+{
+	for (uint32_t y = 0; y < dst_height; ++y) {
+		const float *rows[KAISER_TAPS];
+		for (uint32_t t = 0; t < KAISER_TAPS; ++t)
+			rows[t] = src + (uint64_t)kaiser_tap(y, t, height) * width * 4;
+		float *out = dst + (uint64_t)y * width * 4;
+		for (uint32_t x = 0; x < width; ++x) {
+			texel_t acc = texel_zero();
+			for (uint32_t t = 0; t < KAISER_TAPS; ++t)
+				acc = texel_madd(acc, rows[t] + x * 4, weights[t]);
+			texel_store(out + x * 4, acc);
+		}
+	}
+}
+
+// Zeroth order modified Bessel function of the first kind.
+static double bessel_i0(double x)
+{
+	double sum = 1.0, term = 1.0;
+	for (uint32_t k = 1; k < 32; ++k) {
+		term *= (x * 0.5 / k) * (x * 0.5 / k);
+		sum += term;
+		if (term < sum * 1e-12)
+			break;
+	}
+	return sum;
+}
+
+static void kaiser_weights(float *weights)
+{
+	const double pi = 3.14159265358979323846;
+	double sum = 0.0;
+	double w[KAISER_TAPS];
+	for (uint32_t t = 0; t < KAISER_TAPS; ++t) {
+		// Distance from the center of the 2x2 block in source texels, the sinc is stretched by the
+		// downsampling factor.
+		const double d = (double)t - (KAISER_RADIUS - 0.5);
+		const double x = pi * d * 0.5;
+		const double sinc = sin(x) / x;
+		const double r = d / KAISER_RADIUS;
+		const double window = bessel_i0(KAISER_BETA * sqrt(1.0 - r * r)) / bessel_i0(KAISER_BETA);
+		w[t] = sinc * window;
+		sum += w[t];
+	}
+	for (uint32_t t = 0; t < KAISER_TAPS; ++t)
+		weights[t] = (float)(w[t] / sum);
+}
+
+void mip_chain_fit(uint32_t width, uint32_t height, uint32_t max_size, uint32_t *fit_width, uint32_t *fit_height)
+{
+	*fit_width = width;
+	*fit_height = height;
+	if (!max_size || (width <= max_size && height <= max_size))
+		return;
+
+	if (width >= height) {
+		*fit_width = max_size;
+		*fit_height = (uint32_t)(((uint64_t)height * max_size + width / 2) / width);
+	} else {
+		*fit_height = max_size;
+		*fit_width = (uint32_t)(((uint64_t)width * max_size + height / 2) / height);
+	}
+	*fit_width = *fit_width ? *fit_width : 1;
+	*fit_height = *fit_height ? *fit_height : 1;
+}
+
+// Number of taps of the tent filter that resamples `size` texels to `dst_size` texels.
+static uint32_t tent_taps(uint32_t size, uint32_t dst_size)
+{
+	return 2 * (uint32_t)ceilf((float)size / (float)dst_size) + 1;
+}
+
+// Computes the tent filter that resamples `size` texels to `dst_size` texels. Destination texel `i`
+// is the sum of the source texels `index[i * taps + t]` multiplied by `weights[i * taps + t]`. The
+// indices are clamped to the edges of the image and never decrease.
+static void tent_filter(uint32_t *index, float *weights, uint32_t taps, uint32_t size, uint32_t dst_size)
+{
+	const float scale = (float)size / (float)dst_size;
+	for (uint32_t i = 0; i < dst_size; ++i) {
+		const float center = ((float)i + 0.5f) * scale - 0.5f;
+		const int64_t first = (int64_t)floorf(center - scale) + 1;
+		float sum = 0.0f;
+		for (uint32_t t = 0; t < taps; ++t) {
+			const int64_t s = first + t;
+			const float d = fabsf((float)s - center) / scale;
+			index[i * taps + t] = s < 0 ? 0 : s >= size ? size - 1 : (uint32_t)s;
+			weights[i * taps + t] = d < 1.0f ? 1.0f - d : 0.0f;
+			sum += weights[i * taps + t];
+		}
+		for (uint32_t t = 0; t < taps; ++t)
+			weights[i * taps + t] /= sum;
+	}
+}
+
+void mip_chain_downscale(uint8_t *dst, uint32_t dst_width, uint32_t dst_height, const uint8_t *src, uint32_t width,
+	uint32_t height, bool srgb, struct tm_allocator_i *allocator)
+{
+	float to_linear[256];
+	uint8_t to_srgb[SRGB_TABLE_SIZE];
+	init_tables(to_linear, to_srgb, srgb);
+
+	const uint32_t taps_x = tent_taps(width, dst_width);
+	const uint32_t taps_y = tent_taps(height, dst_height);
+	const uint64_t index_bytes = ((uint64_t)taps_x * dst_width + (uint64_t)taps_y * dst_height) * sizeof(uint32_t);
+	const uint64_t weights_bytes = ((uint64_t)taps_x * dst_width + (uint64_t)taps_y * dst_height) * sizeof(float);
+	uint32_t *index_x = tm_alloc(allocator, index_bytes);
+	uint32_t *index_y = index_x + (uint64_t)taps_x * dst_width;
+	float *weights_x = tm_alloc(allocator, weights_bytes);
+	float *weights_y = weights_x + (uint64_t)taps_x * dst_width;
+	tent_filter(index_x, weights_x, taps_x, width, dst_width);
+	tent_filter(index_y, weights_y, taps_y, height, dst_height);
+
+	// The source rows are filtered horizontally as they are needed and kept in a ring of `taps_y`
+	// rows. The rows read by a destination row never decrease, so each source row is only decoded
+	// and filtered once and the full image is never converted to floating point.
+	const uint64_t row_bytes = (uint64_t)width * 4 * sizeof(float);
+	const uint64_t ring_bytes = ((uint64_t)taps_y + 1) * dst_width * 4 * sizeof(float);
+	const uint64_t ring_rows_bytes = (uint64_t)taps_y * sizeof(int64_t);
+	float *row = tm_alloc(allocator, row_bytes);
+	float *ring = tm_alloc(allocator, ring_bytes);
+	float *out = ring + (uint64_t)taps_y * dst_width * 4;
+	int64_t *ring_rows = tm_alloc(allocator, ring_rows_bytes);
+	const float **taps = tm_alloc(allocator, taps_y * sizeof(*taps));
+	for (uint32_t i = 0; i < taps_y; ++i)
+		ring_rows[i] = -1;
+
+	for (uint32_t y = 0; y < dst_height; ++y) {
+		const uint32_t *rows = index_y + (uint64_t)y * taps_y;
+		const float *wy = weights_y + (uint64_t)y * taps_y;
+
+		for (uint32_t t = 0; t < taps_y; ++t) {
+			const uint32_t slot = rows[t] % taps_y;
+			float *h = ring + (uint64_t)slot * dst_width * 4;
+			if (ring_rows[slot] != rows[t]) {
+				decode_level(row, src + (uint64_t)rows[t] * width * 4, width, to_linear);
+				for (uint32_t x = 0; x < dst_width; ++x) {
+					const uint32_t *cols = index_x + (uint64_t)x * taps_x;
+					const float *wx = weights_x + (uint64_t)x * taps_x;
+					texel_t acc = texel_zero();
+					for (uint32_t u = 0; u < taps_x; ++u)
+						acc = texel_madd(acc, row + cols[u] * 4, wx[u]);
+					texel_store(h + x * 4, acc);
+				}
+				ring_rows[slot] = rows[t];
+			}
+			taps[t] = h;
+		}
+
+		for (uint32_t x = 0; x < dst_width; ++x) {
+			texel_t acc = texel_zero();
+			for (uint32_t t = 0; t < taps_y; ++t)
+				acc = texel_madd(acc, taps[t] + x * 4, wy[t]);
+			texel_store(out + x * 4, acc);
+		}
+		encode_level(dst + (uint64_t)y * dst_width * 4, out, dst_width, srgb ? to_srgb : NULL);
+	}
+
+	tm_free(allocator, row, row_bytes);
+	tm_free(allocator, ring, ring_bytes);
+	tm_free(allocator, ring_rows, ring_rows_bytes);
+	tm_free(allocator, taps, taps_y * sizeof(*taps));
+	tm_free(allocator, index_x, index_bytes);
+	tm_free(allocator, weights_x, weights_bytes);
+}
+
+void mip_chain_generate(uint8_t *mips, uint32_t width, uint32_t height, bool srgb, enum mip_filter filter,
+	struct tm_allocator_i *allocator)
+{
+	const uint32_t levels = mip_chain_levels(width, height);
+	if (levels < 2)
+		return;
+
+	float to_linear[256];
+	uint8_t to_srgb[SRGB_TABLE_SIZE];
+	init_tables(to_linear, to_srgb, srgb);
+
+	float weights[KAISER_TAPS];
+	kaiser_weights(weights);
+
+	// Two level sized scratch images that are swapped after each level, plus the intermediate
+	// result of the horizontal Kaiser pass.
+	const uint32_t width_1 = width > 1 ? width / 2 : 1;
+	const uint32_t height_1 = height > 1 ? height / 2 : 1;
+	const uint64_t src_bytes = (uint64_t)width * height * 4 * sizeof(float);
+	const uint64_t dst_bytes = (uint64_t)width_1 * height_1 * 4 * sizeof(float);
+	const uint64_t tmp_bytes = filter == MIP_FILTER_KAISER ? (uint64_t)width_1 * height * 4 * sizeof(float) : 0;
+	float *src = tm_alloc(allocator, src_bytes);
+	float *dst = tm_alloc(allocator, dst_bytes);
+	float *tmp = tmp_bytes ? tm_alloc(allocator, tmp_bytes) : NULL;
+	float *const scratch[2] = { src, dst };
+
+	decode_level(src, mips, (uint64_t)width * height, to_linear);
+
+	uint8_t *level = mips;
+	for (uint32_t i = 1; i < levels; ++i) {
+		const uint32_t w = width > 1 ? width / 2 : 1;
+		const uint32_t h = height > 1 ? height / 2 : 1;
+
+		if (filter == MIP_FILTER_KAISER) {
+			kaiser_horizontal(tmp, src, width, height, w, weights);
+			kaiser_vertical(dst, tmp, w, height, h, weights);
+		} else {
+			downsample_box(dst, src, width, height, w, h);
+		}
+
+		level += (uint64_t)width * height * 4;
+		encode_level(level, dst, (uint64_t)w * h, srgb ? to_srgb : NULL);
+
+		float *t = src;
+		src = dst;
+		dst = t;
+		width = w;
+		height = h;
+	}
+
+	tm_free(allocator, scratch[0], src_bytes);
+	tm_free(allocator, scratch[1], dst_bytes);
+	if (tmp)
+		tm_free(allocator, tmp, tmp_bytes);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <foundation/api_types.h>
+
+struct tm_allocator_i;
+
+// Generation of mip chains for decoded RGBA8 images.
+
+// Filters used to downsample the mip levels.
+enum mip_filter {
+    // Average of 2x2 texels. Fast, but slightly blurry.
+    MIP_FILTER_BOX,
+
+    // Separable Kaiser windowed sinc with a support of six texels. Keeps the smaller levels
+    // sharper than the box filter.
+    MIP_FILTER_KAISER,
+};
+
+// Maximum number of levels in a mip chain, enough for 16384 x 16384 images.
+#define MIP_CHAIN_MAX_LEVELS 15
+
+// Returns the number of levels in the full mip chain of a `width` x `height` image. Each level is
+// half the size of the previous one (rounded down, at least one texel) down to 1 x 1.
+uint32_t mip_chain_levels(uint32_t width, uint32_t height);
+
+// Returns the size in bytes of the RGBA8 mip chain of a `width` x `height` image and writes the
+// offset of each level to `offsets` (if not NULL). The levels are stored tightly packed, largest
+// first.
+uint64_t mip_chain_size(uint32_t width, uint32_t height, uint64_t *offsets);
+
+// Returns the size of a `width` x `height` image scaled down so that neither side is larger than
+// `max_size`, keeping the aspect ratio. Images that already fit, and a `max_size` of 0, keep their
+// size.
+void mip_chain_fit(uint32_t width, uint32_t height, uint32_t max_size, uint32_t *fit_width, uint32_t *fit_height);
+
+// Downscales the RGBA8 image `src` of `width` x `height` texels to the `dst_width` x `dst_height`
+// image `dst`, which can't be larger than the source in either direction. Uses a separable tent
+// filter with a support of one destination texel, so the ratio doesn't have to be a power of two.
+// The filtering is done in linear space like `mip_chain_generate()`. `allocator` is used for a few
+// rows of scratch memory.
+void mip_chain_downscale(uint8_t *dst, uint32_t dst_width, uint32_t dst_height, const uint8_t *src, uint32_t width,
+    uint32_t height, bool srgb, struct tm_allocator_i *allocator);
+
+// Generates levels 1 and up of the mip chain in `mips` from level 0, which must already be stored
+// at the start of `mips`. If `srgb` is set the color channels are converted to linear space before
+// filtering and back to sRGB afterwards, alpha is always filtered as linear. `allocator` is used
+// for the floating point scratch images.
+void mip_chain_generate(uint8_t *mips, uint32_t width, uint32_t height, bool srgb, enum mip_filter filter,
+    struct tm_allocator_i *allocator);
@@ -0,0 +1,511 @@
+#include "simplify.h"
+
+#include <foundation/allocator.h>
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Weight of the border quadrics relative to the face quadrics, keeps open borders from shrinking.
+#define BORDER_WEIGHT 10.0
+
+// Error (relative to the mesh extents) of collapsing two vertices with opposite normals.
+#define NORMAL_WEIGHT 0.05
+
+// Error (relative to the mesh extents) of collapsing two vertices with disjoint skin influences.
+#define SKIN_WEIGHT 0.1
+
+enum {
+	VERTEX_KIND__MANIFOLD,
+	VERTEX_KIND__BORDER,
+	VERTEX_KIND__LOCKED,
+};
+
+// Symmetric 4x4 error matrix, stored as the upper triangle of the 3x3 part plus the translation
+// vector and the constant term. `w` is the accumulated triangle area.
+typedef struct quadric_t
+{
+	double a00, a11, a22, a01, a02, a12;
+	double b0, b1, b2, c;
+	double w;
+} quadric_t;
+
+typedef struct collapse_t
+{
+	uint32_t v0;
+	uint32_t v1;
+	float error;
+	uint32_t pad;
+} collapse_t;
+
+typedef struct vertex_table_t
+{
+	uint32_t *slots;
+	uint32_t mask;
+	bool positions_only;
+	char pad[3];
+} vertex_table_t;
+
+typedef struct edge_table_t
+{
+	uint64_t *slots;
+	uint64_t mask;
+} edge_table_t;
+
+static uint32_t next_pow2(uint32_t v)
+{
+	uint32_t r = 1;
+	while (r < v)
+		r <<= 1;
+	return r;
+}
+
+static uint32_t hash_bytes(uint32_t h, const void *data, size_t size)
+{
+	const uint8_t *p = data;
+	for (size_t i = 0; i < size; ++i)
+		h = (h ^ p[i]) * 16777619u;
+	return h;
+}
+
+static uint32_t vertex_hash(const simplify_vertices_t *vd, uint32_t v, bool positions_only)
+{
+	uint32_t h = hash_bytes(2166136261u, vd->positions + v * 3, 3 * sizeof(float));
+	if (positions_only)
+		return h;
+	if (vd->normals)
+		h = hash_bytes(h, vd->normals + v * 3, 3 * sizeof(float));
+	if (vd->texcoords)
+		h = hash_bytes(h, vd->texcoords + v * 2, 2 * sizeof(float));
+	if (vd->joints && vd->weights) {
+		h = hash_bytes(h, vd->joints + v * 4, 4 * sizeof(uint32_t));
+		h = hash_bytes(h, vd->weights + v * 4, 4 * sizeof(float));
+	}
+	return h;
+}
+
+static bool vertex_equal(const simplify_vertices_t *vd, uint32_t a, uint32_t b, bool positions_only)
+{
+	if (memcmp(vd->positions + a * 3, vd->positions + b * 3, 3 * sizeof(float)) != 0)
+		return false;
+	if (positions_only)
+		return true;
+	if (vd->normals && memcmp(vd->normals + a * 3, vd->normals + b * 3, 3 * sizeof(float)) != 0)
+		return false;
+	if (vd->texcoords && memcmp(vd->texcoords + a * 2, vd->texcoords + b * 2, 2 * sizeof(float)) != 0)
+		return false;
+	if (vd->joints && vd->weights) {
+		if (memcmp(vd->joints + a * 4, vd->joints + b * 4, 4 * sizeof(uint32_t)) != 0)
+			return false;
+		if (memcmp(vd->weights + a * 4, vd->weights + b * 4, 4 * sizeof(float)) != 0)
+			return false;
+	}
+	return true;
+}
+
+// Returns the first inserted vertex that matches `v`, or inserts `v` if there is none.
+static uint32_t vertex_table_find_or_insert(vertex_table_t *t, const simplify_vertices_t *vd, uint32_t v)
+{
+	uint32_t i = vertex_hash(vd, v, t->positions_only) & t->mask;
+	while (t->slots[i] != UINT32_MAX) {
+		if (vertex_equal(vd, t->slots[i], v, t->positions_only))
+			return t->slots[i];
+		i = (i + 1) & t->mask;
+	}
+	t->slots[i] = v;
+	return v;
+}
+
+static uint64_t edge_key(uint32_t a, uint32_t b)
+{
+	return ((uint64_t)a << 32) | b;
+}
+
+static uint64_t edge_hash(uint64_t key)
+{
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdull;
+	key ^= key >> 33;
+	return key;
+}
+
+static void edge_table_insert(edge_table_t *t, uint32_t a, uint32_t b)
+{
+	const uint64_t key = edge_key(a, b);
+	uint64_t i = edge_hash(key) & t->mask;
+	while (t->slots[i] != UINT64_MAX && t->slots[i] != key)
+		i = (i + 1) & t->mask;
+	t->slots[i] = key;
+}
+
+static bool edge_table_has(const edge_table_t *t, uint32_t a, uint32_t b)
+{
+	const uint64_t key = edge_key(a, b);
+	uint64_t i = edge_hash(key) & t->mask;
+	while (t->slots[i] != UINT64_MAX) {
+		if (t->slots[i] == key)
+			return true;
+		i = (i + 1) & t->mask;
+	}
+	return false;
+}
+
+static bool is_border_edge(const edge_table_t *t, uint32_t a, uint32_t b)
+{
+	return edge_table_has(t, a, b) != edge_table_has(t, b, a);
+}
+
+static void quadric_add(quadric_t *q, const quadric_t *r)
+{
+	q->a00 += r->a00;
+	q->a11 += r->a11;
+	q->a22 += r->a22;
+	q->a01 += r->a01;
+	q->a02 += r->a02;
+	q->a12 += r->a12;
+	q->b0 += r->b0;
+	q->b1 += r->b1;
+	q->b2 += r->b2;
+	q->c += r->c;
+	q->w += r->w;
+}
+
+// Adds the plane `n.p + d = 0` to `q` with weight `w`. `n` must be normalized.
+static void quadric_add_plane(quadric_t *q, const double n[3], double d, double w)
+{
+	q->a00 += w * n[0] * n[0];
+	q->a11 += w * n[1] * n[1];
+	q->a22 += w * n[2] * n[2];
+	q->a01 += w * n[0] * n[1];
+	q->a02 += w * n[0] * n[2];
+	q->a12 += w * n[1] * n[2];
+	q->b0 += w * n[0] * d;
+	q->b1 += w * n[1] * d;
+	q->b2 += w * n[2] * d;
+	q->c += w * d * d;
+	q->w += w;
+}
+
+// Returns the mean squared distance of `p` to the planes accumulated in `q`.
+static double quadric_error(const quadric_t *q, const float *p)
+{
+	const double x = p[0], y = p[1], z = p[2];
+	const double e = q->a00 * x * x + q->a11 * y * y + q->a22 * z * z
+		+ 2.0 * (q->a01 * x * y + q->a02 * x * z + q->a12 * y * z)
+		+ 2.0 * (q->b0 * x + q->b1 * y + q->b2 * z) + q->c;
+	return q->w > 0.0 ? fabs(e) / q->w : 0.0;
+}
+
+static void triangle_normal(double n[3], const float *p0, const float *p1, const float *p2)
+{
+	const double e0[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+	const double e1[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+	n[0] = e0[1] * e1[2] - e0[2] * e1[1];
+	n[1] = e0[2] * e1[0] - e0[0] * e1[2];
+	n[2] = e0[0] * e1[1] - e0[1] * e1[0];
+}
+
+static void add_triangle_quadrics(quadric_t *quadrics, const float *positions, uint32_t a, uint32_t b, uint32_t c)
+{
+	double n[3];
+	triangle_normal(n, positions + a * 3, positions + b * 3, positions + c * 3);
+	const double len = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+	if (len == 0.0)
+		return;
+	n[0] /= len, n[1] /= len, n[2] /= len;
+	const float *p = positions + a * 3;
+	const double d = -(n[0] * p[0] + n[1] * p[1] + n[2] * p[2]);
+	const double area = len * 0.5;
+	quadric_add_plane(quadrics + a, n, d, area);
+	quadric_add_plane(quadrics + b, n, d, area);
+	quadric_add_plane(quadrics + c, n, d, area);
+}
+
+// Adds a plane through the border edge `a -> b` that is perpendicular to the triangle, so that
+// moving the border vertices away from the border is penalized.
+static void add_border_quadrics(quadric_t *quadrics, const float *positions, uint32_t a, uint32_t b, uint32_t c)
+{
+	const float *pa = positions + a * 3, *pb = positions + b * 3;
+	double fn[3];
+	triangle_normal(fn, pa, pb, positions + c * 3);
+	const double e[3] = { pb[0] - pa[0], pb[1] - pa[1], pb[2] - pa[2] };
+	double n[3] = { e[1] * fn[2] - e[2] * fn[1], e[2] * fn[0] - e[0] * fn[2], e[0] * fn[1] - e[1] * fn[0] };
+	const double len = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+	if (len == 0.0)
+		return;
+	n[0] /= len, n[1] /= len, n[2] /= len;
+	const double d = -(n[0] * pa[0] + n[1] * pa[1] + n[2] * pa[2]);
+	const double w = (e[0] * e[0] + e[1] * e[1] + e[2] * e[2]) * BORDER_WEIGHT;
+	quadric_add_plane(quadrics + a, n, d, w);
+	quadric_add_plane(quadrics + b, n, d, w);
+}
+
+// Returns a value between 0 (same influences) and 1 (disjoint influences).
+static double skin_distance(const simplify_vertices_t *vd, uint32_t a, uint32_t b)
+{
+	const uint32_t *ja = vd->joints + a * 4, *jb = vd->joints + b * 4;
+	const float *wa = vd->weights + a * 4, *wb = vd->weights + b * 4;
+	double d = 0.0;
+	for (uint32_t i = 0; i < 4; ++i) {
+		float w = 0.0f;
+		for (uint32_t j = 0; j < 4; ++j) {
+			if (jb[j] == ja[i])
+				w += wb[j];
+		}
+		d += fabs(wa[i] - w);
+	}
+	for (uint32_t j = 0; j < 4; ++j) {
+		bool found = false;
+		for (uint32_t i = 0; i < 4; ++i)
+			found = found || ja[i] == jb[j];
+		if (!found)
+			d += fabs(wb[j]);
+	}
+	return d * 0.5;
+}
+
+static double collapse_error(const simplify_vertices_t *vd, const quadric_t *quadrics, uint32_t v0, uint32_t v1, double scale)
+{
+	double error = quadric_error(quadrics + v0, vd->positions + v1 * 3);
+	if (vd->normals) {
+		const float *n0 = vd->normals + v0 * 3, *n1 = vd->normals + v1 * 3;
+		const double d = n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2];
+		error += (1.0 - d) * 0.5 * (NORMAL_WEIGHT * scale) * (NORMAL_WEIGHT * scale);
+	}
+	if (vd->joints && vd->weights)
+		error += skin_distance(vd, v0, v1) * (SKIN_WEIGHT * scale) * (SKIN_WEIGHT * scale);
+	return error;
+}
+
+static bool can_collapse(const uint8_t *kind, const edge_table_t *edges, uint32_t v0, uint32_t v1)
+{
+	if (kind[v0] == VERTEX_KIND__LOCKED)
+		return false;
+	if (kind[v0] == VERTEX_KIND__BORDER)
+		return is_border_edge(edges, v0, v1);
+	return true;
+}
+
+// Returns true if collapsing `v0` into `v1` flips any of the triangles around `v0`.
+static bool collapse_flips(const uint32_t *indices, const uint32_t *adjacency, uint32_t adjacency_count, const float *positions, uint32_t v0, uint32_t v1)
+{
+	for (uint32_t i = 0; i < adjacency_count; ++i) {
+		const uint32_t *tri = indices + adjacency[i] * 3;
+		if (tri[0] == v1 || tri[1] == v1 || tri[2] == v1)
+			continue;
+		const float *p[3], *q[3];
+		for (uint32_t k = 0; k < 3; ++k) {
+			p[k] = positions + tri[k] * 3;
+			q[k] = positions + (tri[k] == v0 ? v1 : tri[k]) * 3;
+		}
+		double n0[3], n1[3];
+		triangle_normal(n0, p[0], p[1], p[2]);
+		triangle_normal(n1, q[0], q[1], q[2]);
+		if (n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2] <= 0.0)
+			return true;
+	}
+	return false;
+}
+
+static int compare_collapses(const void *a, const void *b)
+{
+	const collapse_t *ca = a, *cb = b;
+	if (ca->error != cb->error)
+		return ca->error < cb->error ? -1 : 1;
+	if (ca->v0 != cb->v0)
+		return ca->v0 < cb->v0 ? -1 : 1;
+	return ca->v1 < cb->v1 ? -1 : ca->v1 > cb->v1;
+}
+
+uint32_t simplify_indices(uint32_t *out, const uint32_t *indices, uint32_t num_indices, const simplify_vertices_t *vd,
+	uint32_t target_index_count, float target_error, tm_allocator_i *a)
+{
+	const uint32_t num_vertices = vd->num_vertices;
+	num_indices -= num_indices % 3;
+	memcpy(out, indices, num_indices * sizeof(uint32_t));
+	if (target_index_count >= num_indices || !num_vertices)
+		return num_indices;
+	for (uint32_t i = 0; i < num_indices; ++i) {
+		if (indices[i] >= num_vertices)
+			return num_indices;
+	}
+
+	uint32_t *remap = tm_alloc(a, num_vertices * sizeof(uint32_t));
+	uint32_t *wedges = tm_alloc(a, num_vertices * sizeof(uint32_t));
+	uint8_t *kind = tm_alloc(a, num_vertices);
+	uint8_t *seam = tm_alloc(a, num_vertices);
+	uint8_t *locked = tm_alloc(a, num_vertices);
+	quadric_t *quadrics = tm_alloc(a, num_vertices * sizeof(quadric_t));
+	uint32_t *collapse_remap = tm_alloc(a, num_vertices * sizeof(uint32_t));
+	uint32_t *adjacency_offsets = tm_alloc(a, (num_vertices + 1) * sizeof(uint32_t));
+	uint32_t *adjacency = tm_alloc(a, num_indices * sizeof(uint32_t));
+	collapse_t *collapses = tm_alloc(a, num_indices * sizeof(collapse_t));
+
+	const uint32_t vertex_slots = next_pow2(num_vertices * 2);
+	vertex_table_t vertex_table = { .slots = tm_alloc(a, vertex_slots * sizeof(uint32_t)), .mask = vertex_slots - 1 };
+	const uint32_t edge_slots = next_pow2(num_indices * 2);
+	edge_table_t edges = { .slots = tm_alloc(a, edge_slots * sizeof(uint64_t)), .mask = edge_slots - 1 };
+
+	// Weld vertices that only differ by their index, then find the welded vertices that share a
+	// position with another welded vertex: these sit on a UV or normal seam.
+	memset(vertex_table.slots, 0xff, vertex_slots * sizeof(uint32_t));
+	for (uint32_t v = 0; v < num_vertices; ++v)
+		remap[v] = vertex_table_find_or_insert(&vertex_table, vd, v);
+
+	memset(vertex_table.slots, 0xff, vertex_slots * sizeof(uint32_t));
+	vertex_table.positions_only = true;
+	memset(wedges, 0, num_vertices * sizeof(uint32_t));
+	for (uint32_t v = 0; v < num_vertices; ++v) {
+		if (remap[v] == v)
+			++wedges[vertex_table_find_or_insert(&vertex_table, vd, v)];
+	}
+	for (uint32_t v = 0; v < num_vertices; ++v) {
+		const uint32_t p = remap[v] == v ? vertex_table_find_or_insert(&vertex_table, vd, v) : v;
+		seam[v] = remap[v] == v && wedges[p] > 1;
+	}
+
+	uint32_t count = 0;
+	for (uint32_t i = 0; i < num_indices; i += 3) {
+		const uint32_t v0 = remap[indices[i + 0]], v1 = remap[indices[i + 1]], v2 = remap[indices[i + 2]];
+		if (v0 == v1 || v1 == v2 || v0 == v2)
+			continue;
+		out[count++] = v0;
+		out[count++] = v1;
+		out[count++] = v2;
+	}
+
+	float bmin[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, bmax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (uint32_t v = 0; v < num_vertices; ++v) {
+		for (uint32_t k = 0; k < 3; ++k) {
+			bmin[k] = fminf(bmin[k], vd->positions[v * 3 + k]);
+			bmax[k] = fmaxf(bmax[k], vd->positions[v * 3 + k]);
+		}
+	}
+	const double scale = fmax(bmax[0] - bmin[0], fmax(bmax[1] - bmin[1], bmax[2] - bmin[2]));
+	const double error_limit = (target_error * scale) * (target_error * scale);
+
+	memset(edges.slots, 0xff, edge_slots * sizeof(uint64_t));
+	for (uint32_t i = 0; i < count; i += 3) {
+		for (uint32_t k = 0; k < 3; ++k)
+			edge_table_insert(&edges, out[i + k], out[i + (k + 1) % 3]);
+	}
+
+	memset(quadrics, 0, num_vertices * sizeof(quadric_t));
+	for (uint32_t i = 0; i < count; i += 3) {
+		add_triangle_quadrics(quadrics, vd->positions, out[i + 0], out[i + 1], out[i + 2]);
+		for (uint32_t k = 0; k < 3; ++k) {
+			const uint32_t v0 = out[i + k], v1 = out[i + (k + 1) % 3], v2 = out[i + (k + 2) % 3];
+			if (!edge_table_has(&edges, v1, v0))
+				add_border_quadrics(quadrics, vd->positions, v0, v1, v2);
+		}
+	}
+
+	while (count > target_index_count) {
+		// Rebuild the vertex to triangle adjacency and the edge table from the current triangles.
+		memset(edges.slots, 0xff, edge_slots * sizeof(uint64_t));
+		for (uint32_t i = 0; i < count; i += 3) {
+			for (uint32_t k = 0; k < 3; ++k)
+				edge_table_insert(&edges, out[i + k], out[i + (k + 1) % 3]);
+		}
+
+		memset(adjacency_offsets, 0, (num_vertices + 1) * sizeof(uint32_t));
+		for (uint32_t i = 0; i < count; ++i)
+			++adjacency_offsets[out[i] + 1];
+		for (uint32_t v = 0; v < num_vertices; ++v)
+			adjacency_offsets[v + 1] += adjacency_offsets[v];
+		memcpy(collapse_remap, adjacency_offsets, num_vertices * sizeof(uint32_t));
+		for (uint32_t i = 0; i < count; ++i)
+			adjacency[collapse_remap[out[i]]++] = i / 3;
+
+		for (uint32_t v = 0; v < num_vertices; ++v)
+			kind[v] = seam[v] ? VERTEX_KIND__LOCKED : VERTEX_KIND__MANIFOLD;
+		for (uint32_t i = 0; i < count; i += 3) {
+			for (uint32_t k = 0; k < 3; ++k) {
+				const uint32_t v0 = out[i + k], v1 = out[i + (k + 1) % 3];
+				if (!edge_table_has(&edges, v1, v0)) {
+					if (kind[v0] == VERTEX_KIND__MANIFOLD)
+						kind[v0] = VERTEX_KIND__BORDER;
+					if (kind[v1] == VERTEX_KIND__MANIFOLD)
+						kind[v1] = VERTEX_KIND__BORDER;
+				}
+			}
+		}
+
+		// Pick the cheapest direction of every edge. Interior edges show up in both of their
+		// triangles, so only the one with `v0 < v1` is considered.
+		uint32_t num_collapses = 0;
+		for (uint32_t i = 0; i < count; i += 3) {
+			for (uint32_t k = 0; k < 3; ++k) {
+				const uint32_t v0 = out[i + k], v1 = out[i + (k + 1) % 3];
+				if (v0 > v1 && edge_table_has(&edges, v1, v0))
+					continue;
+				const bool c01 = can_collapse(kind, &edges, v0, v1);
+				const bool c10 = can_collapse(kind, &edges, v1, v0);
+				if (!c01 && !c10)
+					continue;
+				const double e01 = c01 ? collapse_error(vd, quadrics, v0, v1, scale) : DBL_MAX;
+				const double e10 = c10 ? collapse_error(vd, quadrics, v1, v0, scale) : DBL_MAX;
+				collapses[num_collapses++] = e01 <= e10
+					? (collapse_t){ .v0 = v0, .v1 = v1, .error = (float)e01 }
+					: (collapse_t){ .v0 = v1, .v1 = v0, .error = (float)e10 };
+			}
+		}
+		qsort(collapses, num_collapses, sizeof(collapse_t), compare_collapses);
+
+		for (uint32_t v = 0; v < num_vertices; ++v)
+			collapse_remap[v] = v;
+		memset(locked, 0, num_vertices);
+
+		// Every collapse removes the triangles that share the collapsed edge. The vertices around
+		// a collapse are locked for the rest of the pass so the adjacency stays valid.
+		const uint32_t triangle_goal = (count - target_index_count + 2) / 3;
+		uint32_t triangles_removed = 0;
+		for (uint32_t i = 0; i < num_collapses && triangles_removed < triangle_goal; ++i) {
+			const collapse_t *c = collapses + i;
+			if (c->error > error_limit)
+				break;
+			if (locked[c->v0] || locked[c->v1])
+				continue;
+			const uint32_t *adj = adjacency + adjacency_offsets[c->v0];
+			const uint32_t adj_count = adjacency_offsets[c->v0 + 1] - adjacency_offsets[c->v0];
+			if (collapse_flips(out, adj, adj_count, vd->positions, c->v0, c->v1))
+				continue;
+
+			collapse_remap[c->v0] = c->v1;
+			quadric_add(quadrics + c->v1, quadrics + c->v0);
+			for (uint32_t j = 0; j < adj_count; ++j) {
+				const uint32_t *tri = out + adj[j] * 3;
+				locked[tri[0]] = locked[tri[1]] = locked[tri[2]] = 1;
+				triangles_removed += tri[0] == c->v1 || tri[1] == c->v1 || tri[2] == c->v1;
+			}
+		}
+		if (!triangles_removed)
+			break;
+
+		uint32_t new_count = 0;
+		for (uint32_t i = 0; i < count; i += 3) {
+			const uint32_t v0 = collapse_remap[out[i + 0]], v1 = collapse_remap[out[i + 1]], v2 = collapse_remap[out[i + 2]];
+			if (v0 == v1 || v1 == v2 || v0 == v2)
+				continue;
+			out[new_count++] = v0;
+			out[new_count++] = v1;
+			out[new_count++] = v2;
+		}
+		count = new_count;
+	}
+
+	tm_free(a, edges.slots, edge_slots * sizeof(uint64_t));
+	tm_free(a, vertex_table.slots, vertex_slots * sizeof(uint32_t));
+	tm_free(a, collapses, num_indices * sizeof(collapse_t));
+	tm_free(a, adjacency, num_indices * sizeof(uint32_t));
+	tm_free(a, adjacency_offsets, (num_vertices + 1) * sizeof(uint32_t));
+	tm_free(a, collapse_remap, num_vertices * sizeof(uint32_t));
+	tm_free(a, quadrics, num_vertices * sizeof(quadric_t));
+	tm_free(a, locked, num_vertices);
+	tm_free(a, seam, num_vertices);
+	tm_free(a, kind, num_vertices);
+	tm_free(a, wedges, num_vertices * sizeof(uint32_t));
+	tm_free(a, remap, num_vertices * sizeof(uint32_t));
+	return count;
+}
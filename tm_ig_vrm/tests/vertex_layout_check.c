@@ -0,0 +1,81 @@
+// Standalone check of the vertex buffer layout math in `vertex_layout.h` for primitives whose
+// vertex data exceeds 4 GB. Built by the `vertex_layout_check` project, returns non-zero and prints
+// the failing checks if the layout is wrong.
+
+#include "../plugins/loader/vertex_layout.h"
+
+#include <stdio.h>
+
+static int failures;
+
+#define CHECK(x)                                                  \
+    do {                                                          \
+        if (!(x)) {                                               \
+            printf("%s:%d: CHECK(%s)\n", __FILE__, __LINE__, #x); \
+            ++failures;                                           \
+        }                                                         \
+    } while (0)
+
+static const vertex_format_t float3 = { .bits = 32, .component_count = 3, .is_float = true, .is_signed = true };
+static const vertex_format_t float2 = { .bits = 32, .component_count = 2, .is_float = true, .is_signed = true };
+static const vertex_format_t float4 = { .bits = 32, .component_count = 4, .is_float = true, .is_signed = true };
+static const vertex_format_t unorm16x3 = { .bits = 16, .component_count = 3, .is_normalized = true };
+
+int main(void)
+{
+    // Stream sizes are 64-bit and rounded up to 4 bytes.
+    CHECK(vertex_stream_size(unorm16x3, 3) == 20);
+    CHECK(vertex_stream_size(float4, UINT32_MAX) == 16ull * UINT32_MAX);
+    CHECK(align_up(0, 16) == 0);
+    CHECK(align_up(17, 16) == 32);
+    CHECK(align_up(0x100000001ull, 256) == 0x100000100ull);
+
+    const vertex_format_t formats[VERTEX_STREAM_COUNT] = { float3, float3, float2, float4 };
+    vertex_layout_t layout;
+
+    // Planar streams that all start within the first 4 GB, even though the buffer is larger.
+    {
+        const uint32_t n = 100000000;
+        const uint64_t size = vertex_layout_plan(&layout, formats, n, 64, false, 0, 16);
+        CHECK(layout.stride == 0);
+        CHECK(layout.position_offset == 64);
+        CHECK(layout.normal_offset == 64 + 12ull * n);
+        CHECK(layout.texcoord_offset == 64 + 24ull * n);
+        CHECK(layout.tangent_offset == 64 + 32ull * n);
+        CHECK(size == 64 + 48ull * n);
+        CHECK(size > UINT32_MAX);
+    }
+
+    // A stream that would start beyond 4 GB falls back to interleaved records.
+    {
+        const uint32_t n = 200000000;
+        const uint64_t size = vertex_layout_plan(&layout, formats, n, 64, false, 0, 16);
+        CHECK(layout.stride == 48);
+        CHECK(layout.position_offset == 64);
+        CHECK(layout.normal_offset == 64 + 12);
+        CHECK(layout.texcoord_offset == 64 + 24);
+        CHECK(layout.tangent_offset == 64 + 32);
+        CHECK(size == 64 + 48ull * n);
+    }
+
+    // Requested interleaving with a minimum stride, missing streams and an unaligned offset.
+    {
+        const vertex_format_t sparse[VERTEX_STREAM_COUNT] = { [VERTEX_STREAM_POSITION] = unorm16x3, [VERTEX_STREAM_TEXCOORD] = float2 };
+        const uint64_t size = vertex_layout_plan(&layout, sparse, 10, 4, true, 20, 16);
+        CHECK(layout.stride == 32);
+        CHECK(layout.position_offset == 16);
+        CHECK(layout.texcoord_offset == 16 + 8);
+        CHECK(size == 16 + 32 * 10);
+    }
+
+    // Without vertices nothing is interleaved.
+    {
+        const uint64_t size = vertex_layout_plan(&layout, formats, 0, 8, true, 0, 16);
+        CHECK(layout.stride == 0);
+        CHECK(size == 8);
+    }
+
+    if (!failures)
+        printf("vertex_layout_check: OK\n");
+    return failures ? 1 : 0;
+}